@@ -0,0 +1,45 @@
+#include "alloc_stats.h"
+#include <cstdlib>
+#include <new>
+
+// Global operator new/delete replacement that feeds AllocationScope. Only
+// binaries that list this file count allocations; the rest keep the
+// standard library's allocator untouched.
+//
+// Each block carries its size in a header so frees can lower the live
+// count. The array, nothrow and sized forms all forward to these two in the
+// standard library; over-aligned allocations go their own way and are not
+// counted.
+
+namespace {
+
+constexpr std::size_t Header = alignof(std::max_align_t);
+
+struct Install {
+    Install() { allocstats::detail::markAvailable(); }
+} install;
+
+}
+
+void* operator new(std::size_t size) {
+    void* block = std::malloc(size + Header);
+    if (block == nullptr) throw std::bad_alloc();
+    *static_cast<std::size_t*>(block) = size;
+    allocstats::detail::ThreadCounters& c = allocstats::detail::counters();
+    ++c.allocations;
+    c.bytes += size;
+    c.live += static_cast<int64_t>(size);
+    if (c.live > c.peak) c.peak = c.live;
+    return static_cast<char*>(block) + Header;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr == nullptr) return;
+    void* block = static_cast<char*>(ptr) - Header;
+    allocstats::detail::counters().live -= static_cast<int64_t>(*static_cast<std::size_t*>(block));
+    std::free(block);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    ::operator delete(ptr);
+}
@@ -0,0 +1,108 @@
+#include "alloc_stats.h"
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+
+namespace allocstats {
+namespace {
+
+std::atomic<bool> hooked{false};
+thread_local detail::ThreadCounters threadCounters{};
+
+}
+
+bool available() {
+    return hooked.load(std::memory_order_relaxed);
+}
+
+namespace detail {
+
+ThreadCounters& counters() {
+    return threadCounters;
+}
+
+void markAvailable() {
+    hooked.store(true, std::memory_order_relaxed);
+}
+
+} // namespace detail
+} // namespace allocstats
+
+AllocationCounts& AllocationCounts::operator+=(const AllocationCounts& other) {
+    allocations += other.allocations;
+    bytes += other.bytes;
+    peakLiveBytes = std::max(peakLiveBytes, other.peakLiveBytes);
+    return *this;
+}
+
+AllocationScope::AllocationScope() {
+    allocstats::detail::ThreadCounters& c = allocstats::detail::counters();
+    startAllocations = c.allocations;
+    startBytes = c.bytes;
+    startLive = c.live;
+    outerPeak = c.peak;
+    c.peak = c.live;
+}
+
+AllocationScope::~AllocationScope() {
+    allocstats::detail::ThreadCounters& c = allocstats::detail::counters();
+    c.peak = std::max(c.peak, outerPeak);
+}
+
+AllocationCounts AllocationScope::counts() const {
+    const allocstats::detail::ThreadCounters& c = allocstats::detail::counters();
+    AllocationCounts result;
+    result.allocations = c.allocations - startAllocations;
+    result.bytes = c.bytes - startBytes;
+    result.peakLiveBytes = c.peak > startLive ? static_cast<uint64_t>(c.peak - startLive) : 0;
+    return result;
+}
+
+void AllocationStats::add(std::string_view phase, const AllocationCounts& counts) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = std::find_if(entries.begin(), entries.end(), [&](const Phase& p) { return p.name == phase; });
+    if (found == entries.end()) {
+        entries.push_back(Phase{std::string(phase), {}, 0});
+        found = entries.end() - 1;
+    }
+    found->counts += counts;
+    ++found->samples;
+}
+
+void AllocationStats::addInputBytes(uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    input += bytes;
+}
+
+std::vector<AllocationStats::Phase> AllocationStats::phases() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries;
+}
+
+uint64_t AllocationStats::inputBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return input;
+}
+
+void AllocationStats::print(std::ostream& out) const {
+    std::vector<Phase> phases = this->phases();
+    uint64_t bytesIn = inputBytes();
+    if (!allocstats::available()) {
+        out << "allocation counts unavailable (built without the allocation hook)\n";
+        return;
+    }
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::left << std::setw(12) << "phase" << std::right << std::setw(14) << "allocations" << std::setw(16)
+        << "bytes" << std::setw(16) << "peak live" << std::setw(12) << "alloc/KB" << std::setw(12) << "bytes/B"
+        << "\n";
+    for (const Phase& phase : phases) {
+        double perKilobyte = bytesIn > 0 ? phase.counts.allocations * 1024.0 / bytesIn : 0.0;
+        double perByte = bytesIn > 0 ? static_cast<double>(phase.counts.bytes) / bytesIn : 0.0;
+        out << std::left << std::setw(12) << phase.name << std::right << std::setw(14) << phase.counts.allocations
+            << std::setw(16) << phase.counts.bytes << std::setw(16) << phase.counts.peakLiveBytes << std::fixed
+            << std::setprecision(2) << std::setw(12) << perKilobyte << std::setw(12) << perByte << "\n";
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
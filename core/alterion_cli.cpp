@@ -0,0 +1,171 @@
+#include "alloc_stats.h"
+#include "alterion_compiler.h"
+#include "compile_cache.h"
+#include "json_writer.h"
+#include "lexer.h"
+#include "phase_timer.h"
+#include "source_buffer.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// alterion check [-j N] [--cache DIR [--cache-limit MB]] [--max-errors N] [--max-nesting N]
+//                [--stats] [--timings] [--trace FILE] <file|directory>...
+//
+// Lexes and parses every .alt file given (directories are searched
+// recursively) in parallel and prints their diagnostics in file order.
+// With --cache, files whose content was seen before are loaded from DIR
+// instead, and the hit/miss counts are reported with the summary.
+// --max-errors stops parsing a file after N errors. --max-nesting reports
+// tags or expressions nested more than N deep (default 1000) as errors.
+// --stats adds heap allocations per phase, when the binary was built with
+// ALTERION_ALLOC_STATS. --timings prints time per phase and the slowest
+// files and components; --trace writes the same timings as Chrome
+// trace-event JSON, for chrome://tracing or ui.perfetto.dev.
+//
+// alterion tokens [--compact] <file>
+//
+// Writes the file's token stream to stdout as a JSON array, one object per
+// token, streamed as the lexer produces it.
+
+namespace {
+
+int usage() {
+    std::cerr << "usage: alterion check [-j N] [--cache DIR [--cache-limit MB]] [--max-errors N] [--max-nesting N]\n"
+                 "                      [--stats] [--timings] [--trace FILE] <file|directory>...\n"
+                 "       alterion tokens [--compact] <file>\n";
+    return 2;
+}
+
+int dumpTokens(int argc, char** argv) {
+    JsonWriter::Style style = JsonWriter::Style::Pretty;
+    std::string path;
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--compact") == 0) style = JsonWriter::Style::Compact;
+        else if (path.empty()) path = argv[i];
+        else return usage();
+    }
+    if (path.empty()) return usage();
+
+    auto source = SourceBuffer::fromFile(path);
+    if (!source) {
+        std::cerr << "error: cannot read " << path << "\n";
+        return 1;
+    }
+    Lexer lexer(source);
+    JsonWriter json(1, style);
+    json.beginArray();
+    for (const Token& token : lexer) {
+        SourceLocation at = lexer.lines().locate(token.offset);
+        json.beginObject()
+            .field("type", Token::tokenTypeToString(token.type))
+            .field("value", token.value)
+            .field("line", at.line)
+            .field("column", at.column);
+        if (token.hasError()) json.field("error", lexer.errors()[token.errorIndex].message);
+        json.endObject();
+    }
+    json.endArray();
+    if (!json.flush()) {
+        std::cerr << "error: writing the token stream failed\n";
+        return 1;
+    }
+    return lexer.errors().empty() ? 0 : 1;
+}
+
+bool writeTrace(const PhaseTrace& trace, const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) return false;
+    bool ok;
+    {
+        JsonWriter json(fileno(file), JsonWriter::Style::Compact);
+        trace.writeChromeTrace(json);
+        ok = json.flush();
+    }
+    return std::fclose(file) == 0 && ok;
+}
+
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && std::strcmp(argv[1], "tokens") == 0) return dumpTokens(argc, argv);
+    if (argc < 2 || std::strcmp(argv[1], "check") != 0) return usage();
+
+    CompileOptions options;
+    std::vector<std::string> inputs;
+    std::string cacheDirectory;
+    uint64_t cacheLimit = CompileCache::DefaultLimit;
+    AllocationStats stats;
+    bool timings = false;
+    std::string tracePath;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            options.jobs = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg.rfind("-j", 0) == 0 && arg.size() > 2) {
+            options.jobs = static_cast<unsigned>(std::strtoul(arg.c_str() + 2, nullptr, 10));
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cacheDirectory = argv[++i];
+        } else if (arg == "--cache-limit" && i + 1 < argc) {
+            cacheLimit = static_cast<uint64_t>(std::strtoull(argv[++i], nullptr, 10)) << 20;
+        } else if (arg == "--max-errors" && i + 1 < argc) {
+            options.errorLimit = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--max-nesting" && i + 1 < argc) {
+            options.nestingLimit = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--stats") {
+            options.stats = &stats;
+        } else if (arg == "--timings") {
+            timings = true;
+        } else if (arg == "--trace" && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (arg == "-h" || arg == "--help") {
+            usage();
+            return 0;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.empty()) return usage();
+
+    std::unique_ptr<CompileCache> cache;
+    if (!cacheDirectory.empty()) {
+        cache = std::make_unique<CompileCache>(cacheDirectory, cacheLimit);
+        if (!cache->enabled()) std::cerr << "warning: cannot use cache directory " << cacheDirectory << "\n";
+        options.cache = cache.get();
+    }
+
+    PhaseTrace trace;
+    if (timings || !tracePath.empty()) PhaseTrace::install(&trace);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> files = collectSourceFiles(inputs);
+    std::vector<FileResult> results = compileFiles(files, options);
+    PhaseTrace::install(nullptr);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    printDiagnostics(results, std::cout);
+
+    size_t bytes = 0, errors = 0;
+    for (const auto& result : results) {
+        bytes += result.bytes;
+        errors += result.diagnostics.size();
+    }
+    std::cerr << "checked " << files.size() << " files (" << bytes << " bytes) in " << static_cast<long>(ms)
+              << " ms: " << errors << (errors == 1 ? " error\n" : " errors\n");
+    if (cache != nullptr) {
+        CacheCounters counters = cache->counters();
+        std::cerr << "cache: " << counters.hits << " hits, " << counters.misses << " misses, " << counters.stores
+                  << " stored, " << counters.evictions << " evicted\n";
+    }
+    if (options.stats != nullptr) stats.print(std::cerr);
+    if (timings) trace.printSummary(std::cerr);
+    if (!tracePath.empty() && !writeTrace(trace, tracePath)) {
+        std::cerr << "error: cannot write " << tracePath << "\n";
+        return 2;
+    }
+    return errors == 0 ? 0 : 1;
+}
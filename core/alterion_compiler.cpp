@@ -0,0 +1,146 @@
+#include "alterion_compiler.h"
+#include "alloc_stats.h"
+#include "compile_cache.h"
+#include "lexer.h"
+#include "parser.h"
+#include "phase_timer.h"
+#include "source_buffer.h"
+#include "work_stealing_pool.h"
+#include <algorithm>
+#include <filesystem>
+#include <numeric>
+#include <optional>
+#include <system_error>
+
+namespace {
+
+void compileOne(const std::string& path, const CompileOptions& options, FileResult& result) {
+    CompileCache* cache = options.cache;
+    AllocationStats* stats = options.stats;
+    result.path = path;
+    FileTimer timer(path);
+
+    auto buffer = SourceBuffer::fromFile(path);
+    if (!buffer) {
+        result.diagnostics.push_back({Diagnostic::Phase::Read, 0, 0, "cannot read file"});
+        return;
+    }
+    result.bytes = buffer->size();
+    if (stats != nullptr) stats->addInputBytes(result.bytes);
+
+    ContentHash key;
+    if (cache != nullptr) {
+        PhaseTimer lookup("load");
+        AllocationScope scope;
+        key = CompileCache::keyFor(buffer->text(), options);
+        if (auto entry = cache->find(key)) {
+            result.program = entry->program();
+            if (result.program != nullptr) {
+                result.diagnostics = entry->diagnostics();
+                result.cached = true;
+                if (stats != nullptr) stats->add("load", scope.counts());
+                return;
+            }
+        }
+    }
+
+    // Stats and timings count lexing apart from parsing, so in those cases
+    // the file is lexed up front; otherwise the parser pulls tokens as it
+    // goes.
+    Lexer lexer(buffer);
+    std::vector<Token> tokens;
+    std::optional<Parser> parser;
+    if (stats != nullptr || PhaseTrace::active() != nullptr) {
+        AllocationScope scope;
+        tokens = lexer.tokenize();
+        if (stats != nullptr) stats->add("lex", scope.counts());
+        parser.emplace(tokens);
+    } else {
+        parser.emplace(lexer);
+    }
+    parser->setErrorLimit(options.errorLimit);
+    if (options.nestingLimit != 0) parser->setNestingLimit(options.nestingLimit);
+    {
+        AllocationScope scope;
+        result.program = parser->parse();
+        if (stats != nullptr) stats->add("parse", scope.counts());
+    }
+
+    // Only files with errors pay for the line table.
+    for (const LexError& error : lexer.errors()) {
+        SourceLocation at = buffer->lines().locate(error.offset);
+        result.diagnostics.push_back({Diagnostic::Phase::Lex, at.line, at.column, error.message});
+    }
+    for (const ParseError& error : parser->errors()) {
+        SourceLocation at = buffer->lines().locate(error.offset);
+        result.diagnostics.push_back({Diagnostic::Phase::Parse, at.line, at.column, error.message});
+    }
+    // Lexer and parser errors interleave by position; ties keep lexer first.
+    std::stable_sort(result.diagnostics.begin(), result.diagnostics.end(),
+                     [](const Diagnostic& a, const Diagnostic& b) {
+                         return a.line != b.line ? a.line < b.line : a.column < b.column;
+                     });
+
+    if (cache != nullptr) {
+        AllocationScope scope;
+        cache->store(key, result.program.get(), result.diagnostics);
+        if (stats != nullptr) stats->add("serialize", scope.counts());
+    }
+}
+
+}
+
+std::vector<std::string> collectSourceFiles(const std::vector<std::string>& inputs) {
+    std::vector<std::string> files;
+    for (const auto& input : inputs) {
+        std::error_code ec;
+        if (std::filesystem::is_directory(input, ec)) {
+            for (std::filesystem::recursive_directory_iterator it(input, ec), end; !ec && it != end; it.increment(ec)) {
+                if (it->is_regular_file(ec) && it->path().extension() == ".alt") {
+                    files.push_back(it->path().string());
+                }
+            }
+        } else {
+            files.push_back(input);
+        }
+    }
+    std::sort(files.begin(), files.end());
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+    return files;
+}
+
+std::vector<FileResult> compileFiles(const std::vector<std::string>& files, const CompileOptions& options) {
+    std::vector<FileResult> results(files.size());
+
+    // Largest files first, so a big file picked up last does not leave the
+    // other workers idle at the end.
+    std::vector<uintmax_t> sizes(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        std::error_code ec;
+        sizes[i] = std::filesystem::file_size(files[i], ec);
+        if (ec) sizes[i] = 0;
+    }
+    std::vector<size_t> order(files.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+    WorkStealingPool pool(options.jobs);
+    for (size_t index : order) {
+        pool.submit([&files, &results, &options, index] { compileOne(files[index], options, results[index]); });
+    }
+    pool.wait();
+    if (options.cache != nullptr) options.cache->trim();
+    return results;
+}
+
+void printDiagnostics(const std::vector<FileResult>& results, std::ostream& out) {
+    for (const auto& result : results) {
+        for (const auto& diagnostic : result.diagnostics) {
+            out << result.path;
+            if (diagnostic.phase != Diagnostic::Phase::Read) {
+                out << ':' << diagnostic.line << ':' << diagnostic.column;
+            }
+            out << ": error: " << diagnostic.message << '\n';
+        }
+    }
+}
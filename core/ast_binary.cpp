@@ -0,0 +1,166 @@
+#include "ast_binary.h"
+#include "phase_timer.h"
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr char Magic[4] = {'A', 'L', 'T', 'A'};
+constexpr uint32_t HeaderSize = 32;
+constexpr uint32_t RecordSize = 32;
+
+void put16(std::string& out, uint16_t value) {
+    out.push_back(static_cast<char>(value & 0xFF));
+    out.push_back(static_cast<char>(value >> 8));
+}
+
+void put32(std::string& out, uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) out.push_back(static_cast<char>((value >> shift) & 0xFF));
+}
+
+uint16_t load16(const unsigned char* p) {
+    return static_cast<uint16_t>(p[0] | p[1] << 8);
+}
+
+class StringTable {
+public:
+    StringTable() { add(std::string_view()); }
+
+    uint32_t add(std::string_view text) {
+        auto found = indices.find(text);
+        if (found != indices.end()) return found->second;
+        uint32_t index = static_cast<uint32_t>(entries.size());
+        entries.push_back(text);
+        indices.emplace(text, index);
+        return index;
+    }
+
+    void write(std::string& out) const {
+        uint32_t offset = 0;
+        for (std::string_view text : entries) {
+            put32(out, offset);
+            put32(out, static_cast<uint32_t>(text.size()));
+            offset += static_cast<uint32_t>(text.size());
+        }
+        for (std::string_view text : entries) out.append(text.data(), text.size());
+    }
+
+    uint32_t count() const { return static_cast<uint32_t>(entries.size()); }
+    uint32_t bytes() const {
+        size_t total = 0;
+        for (std::string_view text : entries) total += text.size();
+        return static_cast<uint32_t>(total);
+    }
+
+private:
+    std::vector<std::string_view> entries;
+    std::unordered_map<std::string_view, uint32_t> indices;
+};
+
+void fail(std::string* error, const char* message) {
+    if (error != nullptr) *error = message;
+}
+
+}
+
+void writeASTBinary(const ASTNode& root, std::string& out) {
+    PhaseTimer timer("serialize");
+    // Breadth-first, so that every node's children end up adjacent.
+    std::vector<const ASTNode*> order{&root};
+    for (size_t i = 0; i < order.size(); ++i) {
+        for (const ASTNode* child = order[i]->firstChild; child != nullptr; child = child->nextSibling) {
+            order.push_back(child);
+        }
+    }
+
+    StringTable strings;
+    std::string records;
+    records.reserve(order.size() * RecordSize);
+    uint32_t nextChild = 1;
+    for (const ASTNode* node : order) {
+        uint32_t children = 0;
+        for (const ASTNode* child = node->firstChild; child != nullptr; child = child->nextSibling) ++children;
+        records.push_back(static_cast<char>(node->type));
+        records.push_back(static_cast<char>((node->hasValue() ? 1 : 0) | (node->hasError() ? 2 : 0)));
+        put16(records, 0);
+        put32(records, node->line);
+        put32(records, node->column);
+        put32(records, strings.add(node->name));
+        put32(records, node->hasValue() ? strings.add(node->value) : 0);
+        put32(records, node->hasError() ? strings.add(node->error) : 0);
+        put32(records, children == 0 ? 0 : nextChild);
+        put32(records, children);
+        nextChild += children;
+    }
+
+    out.append(Magic, sizeof Magic);
+    put16(out, ASTBinaryVersion);
+    put16(out, HeaderSize);
+    put32(out, static_cast<uint32_t>(order.size()));
+    put32(out, RecordSize);
+    put32(out, strings.count());
+    put32(out, strings.bytes());
+    put32(out, 0);   // root
+    put32(out, 0);   // reserved
+    out += records;
+    strings.write(out);
+}
+
+std::optional<ASTBinaryView> ASTBinaryView::open(std::string_view bytes, std::string* error) {
+    const auto* data = reinterpret_cast<const unsigned char*>(bytes.data());
+    if (bytes.size() < HeaderSize || !std::equal(std::begin(Magic), std::end(Magic), bytes.data())) {
+        fail(error, "not an Alterion binary AST");
+        return std::nullopt;
+    }
+
+    ASTBinaryView view;
+    view.formatVersion = load16(data + 4);
+    uint32_t headerSize = load16(data + 6);
+    view.count = load32(data + 8);
+    view.recordSize = load32(data + 12);
+    uint32_t stringCount = load32(data + 16);
+    uint32_t stringBytes = load32(data + 20);
+    view.rootIndex = load32(data + 24);
+
+    if (view.formatVersion != ASTBinaryVersion) {
+        fail(error, "unsupported binary AST version");
+        return std::nullopt;
+    }
+    uint64_t needed = uint64_t(headerSize) + uint64_t(view.count) * view.recordSize + uint64_t(stringCount) * 8 +
+                      stringBytes;
+    if (headerSize < HeaderSize || view.recordSize < RecordSize || stringCount == 0 || view.count == 0 ||
+        view.rootIndex >= view.count || needed > bytes.size()) {
+        fail(error, "truncated or inconsistent binary AST header");
+        return std::nullopt;
+    }
+
+    view.nodes = data + headerSize;
+    view.strings = view.nodes + size_t(view.count) * view.recordSize;
+    view.stringData = reinterpret_cast<const char*>(view.strings + size_t(stringCount) * 8);
+
+    for (uint32_t i = 0; i < stringCount; ++i) {
+        const unsigned char* entry = view.strings + size_t(i) * 8;
+        if (uint64_t(load32(entry)) + load32(entry + 4) > stringBytes) {
+            fail(error, "string out of bounds");
+            return std::nullopt;
+        }
+    }
+    for (uint32_t i = 0; i < view.count; ++i) {
+        const unsigned char* record = view.nodes + size_t(i) * view.recordSize;
+        uint8_t flags = record[1];
+        uint32_t first = load32(record + 24);
+        uint32_t children = load32(record + 28);
+        if (load32(record + 12) >= stringCount || ((flags & 1) && load32(record + 16) >= stringCount) ||
+            ((flags & 2) && load32(record + 20) >= stringCount)) {
+            fail(error, "node refers to a missing string");
+            return std::nullopt;
+        }
+        // Children always come after their parent, so the tree has no cycles.
+        if (children != 0 && (first <= i || uint64_t(first) + children > view.count)) {
+            fail(error, "node children out of range");
+            return std::nullopt;
+        }
+    }
+    return view;
+}
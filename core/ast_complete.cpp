@@ -0,0 +1,88 @@
+#include "ast_complete.h"
+
+namespace {
+
+template <typename T>
+void visitOne(const std::unique_ptr<T>& child, const std::function<void(Node&)>& visit) {
+    if (child) visit(*child);
+}
+
+template <typename T>
+void visitAll(const std::vector<std::unique_ptr<T>>& children, const std::function<void(Node&)>& visit) {
+    for (const auto& child : children) visitOne(child, visit);
+}
+
+}
+
+void forEachChild(Node& node, const std::function<void(Node&)>& visit) {
+    if (auto* n = dynamic_cast<BinaryExpression*>(&node)) {
+        visitOne(n->left, visit);
+        visitOne(n->right, visit);
+    } else if (auto* n = dynamic_cast<UnaryExpression*>(&node)) {
+        visitOne(n->operand, visit);
+    } else if (auto* n = dynamic_cast<CallExpression*>(&node)) {
+        visitOne(n->callee, visit);
+        visitAll(n->arguments, visit);
+    } else if (auto* n = dynamic_cast<MemberExpression*>(&node)) {
+        visitOne(n->object, visit);
+        visitOne(n->property, visit);
+    } else if (auto* n = dynamic_cast<ArrayExpression*>(&node)) {
+        visitAll(n->elements, visit);
+    } else if (auto* n = dynamic_cast<ObjectProperty*>(&node)) {
+        visitOne(n->key, visit);
+        visitOne(n->value, visit);
+    } else if (auto* n = dynamic_cast<ObjectExpression*>(&node)) {
+        visitAll(n->properties, visit);
+    } else if (auto* n = dynamic_cast<ExpressionStatement*>(&node)) {
+        visitOne(n->expression, visit);
+    } else if (auto* n = dynamic_cast<BlockStatement*>(&node)) {
+        visitAll(n->statements, visit);
+    } else if (auto* n = dynamic_cast<VariableDeclaration*>(&node)) {
+        visitOne(n->initializer, visit);
+    } else if (auto* n = dynamic_cast<Assignment*>(&node)) {
+        visitOne(n->value, visit);
+    } else if (auto* n = dynamic_cast<IfStatement*>(&node)) {
+        visitOne(n->condition, visit);
+        visitOne(n->thenBranch, visit);
+        visitOne(n->elseBranch, visit);
+    } else if (auto* n = dynamic_cast<WhileStatement*>(&node)) {
+        visitOne(n->condition, visit);
+        visitOne(n->body, visit);
+    } else if (auto* n = dynamic_cast<ForStatement*>(&node)) {
+        visitOne(n->init, visit);
+        visitOne(n->condition, visit);
+        visitOne(n->update, visit);
+        visitOne(n->body, visit);
+    } else if (auto* n = dynamic_cast<ForInStatement*>(&node)) {
+        visitOne(n->iterable, visit);
+        visitOne(n->body, visit);
+    } else if (auto* n = dynamic_cast<ReturnStatement*>(&node)) {
+        visitOne(n->value, visit);
+    } else if (auto* n = dynamic_cast<TryStatement*>(&node)) {
+        visitOne(n->block, visit);
+        visitOne(n->catchBlock, visit);
+        visitOne(n->finallyBlock, visit);
+    } else if (auto* n = dynamic_cast<ThrowStatement*>(&node)) {
+        visitOne(n->value, visit);
+    } else if (auto* n = dynamic_cast<Export*>(&node)) {
+        visitOne(n->declaration, visit);
+    } else if (auto* n = dynamic_cast<Function*>(&node)) {
+        visitOne(n->body, visit);
+    } else if (auto* n = dynamic_cast<Attribute*>(&node)) {
+        visitOne(n->value, visit);
+    } else if (auto* n = dynamic_cast<Tag*>(&node)) {
+        visitAll(n->attributes, visit);
+        visitAll(n->children, visit);
+    } else if (auto* n = dynamic_cast<Component*>(&node)) {
+        visitAll(n->statements, visit);
+        visitAll(n->body, visit);
+    } else if (auto* n = dynamic_cast<Program*>(&node)) {
+        visitAll(n->components, visit);
+        visitAll(n->functions, visit);
+        visitAll(n->globalStatements, visit);
+    }
+}
+
+void forEachChild(const Node& node, const std::function<void(const Node&)>& visit) {
+    forEachChild(const_cast<Node&>(node), [&visit](Node& child) { visit(child); });
+}
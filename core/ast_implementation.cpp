@@ -1,24 +1,84 @@
 #include "ast.h"
-#include <sstream>
-
-std::string astToJson(const std::shared_ptr<ASTNode>& node, int indent) {
-    std::ostringstream oss;
-    std::string ind(indent, ' ');
-    oss << ind << "{\n";
-    oss << ind << "  \"type\": \"" << static_cast<int>(node->type) << "\",\n";
-    oss << ind << "  \"name\": \"" << node->name << "\",\n";
-    if (node->value)
-        oss << ind << "  \"value\": \"" << *node->value << "\",\n";
-    oss << ind << "  \"line\": " << node->line << ",\n";
-    oss << ind << "  \"column\": " << node->column << ",\n";
-    if (node->error)
-        oss << ind << "  \"error\": \"" << *node->error << "\",\n";
-    oss << ind << "  \"children\": [\n";
-    for (size_t i = 0; i < node->children.size(); ++i) {
-        oss << astToJson(node->children[i], indent + 4);
-        if (i + 1 < node->children.size()) oss << ",\n";
+#include "phase_timer.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+size_t hashText(std::string_view text) {
+    size_t h = 14695981039346656037ull;
+    for (char c : text) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+}
+
+std::string_view ASTArena::intern(std::string_view text) {
+    // Non-null so that an empty value still reads as set.
+    if (text.empty()) return std::string_view("", 0);
+
+    if ((interned + 1) * 4 > table.size() * 3) growTable();
+    size_t mask = table.size() - 1;
+    for (size_t slot = hashText(text) & mask;; slot = (slot + 1) & mask) {
+        std::string_view& entry = table[slot];
+        if (entry.data() == nullptr) {
+            entry = arena.copy(text);
+            ++interned;
+            return entry;
+        }
+        if (entry == text) return entry;
     }
-    oss << "\n" << ind << "  ]\n";
-    oss << ind << "}";
-    return oss.str();
+}
+
+void ASTArena::growTable() {
+    std::vector<std::string_view> old(table.size() ? table.size() * 2 : 256);
+    old.swap(table);
+    size_t mask = table.size() - 1;
+    for (std::string_view entry : old) {
+        if (entry.data() == nullptr) continue;
+        size_t slot = hashText(entry) & mask;
+        while (table[slot].data() != nullptr) slot = (slot + 1) & mask;
+        table[slot] = entry;
+    }
+}
+
+void writeASTJson(JsonWriter& json, const ASTNode& root) {
+    PhaseTimer timer("serialize");
+    // Iterative: `open` holds the nodes whose children array is still being
+    // written, so arbitrarily deep trees cannot overflow the stack.
+    std::vector<const ASTNode*> open;
+    const ASTNode* node = &root;
+    for (;;) {
+        json.beginObject().field("type", std::to_string(static_cast<int>(node->type))).field("name", node->name);
+        if (node->hasValue()) json.field("value", node->value);
+        json.field("line", node->line).field("column", node->column);
+        if (node->hasError()) json.field("error", node->error);
+        json.key("children").beginArray();
+        if (node->firstChild) {
+            open.push_back(node);
+            node = node->firstChild;
+            continue;
+        }
+        json.endArray().endObject();
+        for (;;) {
+            if (node == &root) return;
+            if (node->nextSibling) {
+                node = node->nextSibling;
+                break;
+            }
+            node = open.back();
+            open.pop_back();
+            json.endArray().endObject();
+        }
+    }
+}
+
+std::string astToJson(const ASTNode* node, JsonWriter::Style style) {
+    std::string out;
+    JsonWriter json(out, style);
+    writeASTJson(json, *node);
+    return out;
 }
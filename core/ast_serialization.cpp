@@ -0,0 +1,657 @@
+#include "ast_serialization.h"
+#include "binary_io.h"
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// One per concrete node class. Stored on disk: append, never renumber.
+enum class Kind : uint8_t {
+    None,
+    StringLiteral,
+    NumberLiteral,
+    BooleanLiteral,
+    NullLiteral,
+    Identifier,
+    ValueBinding,
+    Binary,
+    Unary,
+    Call,
+    Member,
+    Array,
+    ObjectProperty,
+    Object,
+    ExpressionStatement,
+    Block,
+    VariableDeclaration,
+    Assignment,
+    If,
+    While,
+    For,
+    ForIn,
+    Return,
+    Break,
+    Continue,
+    Try,
+    Throw,
+    Import,
+    Export,
+    Function,
+    Attribute,
+    TextContent,
+    Tag,
+    Component,
+    Program,
+    Error,
+};
+
+// Node classes are told apart by their dynamic type: one hash lookup instead
+// of a chain of dynamic_casts per node.
+Kind kindOf(const Node& node) {
+    static const std::unordered_map<std::type_index, Kind> kinds = {
+        {typeid(StringLiteral), Kind::StringLiteral},
+        {typeid(NumberLiteral), Kind::NumberLiteral},
+        {typeid(BooleanLiteral), Kind::BooleanLiteral},
+        {typeid(NullLiteral), Kind::NullLiteral},
+        {typeid(Identifier), Kind::Identifier},
+        {typeid(ValueBinding), Kind::ValueBinding},
+        {typeid(BinaryExpression), Kind::Binary},
+        {typeid(UnaryExpression), Kind::Unary},
+        {typeid(CallExpression), Kind::Call},
+        {typeid(MemberExpression), Kind::Member},
+        {typeid(ArrayExpression), Kind::Array},
+        {typeid(ObjectProperty), Kind::ObjectProperty},
+        {typeid(ObjectExpression), Kind::Object},
+        {typeid(ExpressionStatement), Kind::ExpressionStatement},
+        {typeid(BlockStatement), Kind::Block},
+        {typeid(VariableDeclaration), Kind::VariableDeclaration},
+        {typeid(Assignment), Kind::Assignment},
+        {typeid(IfStatement), Kind::If},
+        {typeid(WhileStatement), Kind::While},
+        {typeid(ForStatement), Kind::For},
+        {typeid(ForInStatement), Kind::ForIn},
+        {typeid(ReturnStatement), Kind::Return},
+        {typeid(BreakStatement), Kind::Break},
+        {typeid(ContinueStatement), Kind::Continue},
+        {typeid(TryStatement), Kind::Try},
+        {typeid(ThrowStatement), Kind::Throw},
+        {typeid(Import), Kind::Import},
+        {typeid(Export), Kind::Export},
+        {typeid(Function), Kind::Function},
+        {typeid(Attribute), Kind::Attribute},
+        {typeid(TextContent), Kind::TextContent},
+        {typeid(Tag), Kind::Tag},
+        {typeid(Component), Kind::Component},
+        {typeid(Program), Kind::Program},
+        {typeid(ErrorExpression), Kind::Error},
+    };
+    auto found = kinds.find(typeid(node));
+    return found == kinds.end() ? Kind::None : found->second;
+}
+
+// Deeper trees are not encoded, so that reading a damaged file cannot
+// recurse without bound.
+constexpr size_t MaxDepth = 10000;
+
+class Writer {
+public:
+    explicit Writer(std::string& buffer) : out(buffer) {}
+
+    bool ok() const { return !tooDeep; }
+
+    void node(const Node* node) {
+        if (node == nullptr || depth >= MaxDepth) {
+            if (node != nullptr) tooDeep = true;
+            out.byte(static_cast<uint8_t>(Kind::None));
+            return;
+        }
+        Nested nested(depth);
+        switch (kindOf(*node)) {
+        case Kind::StringLiteral: {
+            auto* n = static_cast<const StringLiteral*>(node);
+            header(Kind::StringLiteral, *n);
+            out.string(n->value);
+            break;
+        }
+        case Kind::NumberLiteral: {
+            auto* n = static_cast<const NumberLiteral*>(node);
+            header(Kind::NumberLiteral, *n);
+            out.string(n->value);
+            out.byte(n->isFloat);
+            break;
+        }
+        case Kind::BooleanLiteral: {
+            auto* n = static_cast<const BooleanLiteral*>(node);
+            header(Kind::BooleanLiteral, *n);
+            out.byte(n->value);
+            break;
+        }
+        case Kind::NullLiteral: {
+            auto* n = static_cast<const NullLiteral*>(node);
+            header(Kind::NullLiteral, *n);
+            break;
+        }
+        case Kind::Identifier: {
+            auto* n = static_cast<const Identifier*>(node);
+            header(Kind::Identifier, *n);
+            symbol(n->name);
+            break;
+        }
+        case Kind::ValueBinding: {
+            auto* n = static_cast<const ValueBinding*>(node);
+            header(Kind::ValueBinding, *n);
+            symbol(n->name);
+            break;
+        }
+        case Kind::Binary: {
+            auto* n = static_cast<const BinaryExpression*>(node);
+            header(Kind::Binary, *n);
+            out.varint(static_cast<uint64_t>(n->op));
+            this->node(n->left.get());
+            this->node(n->right.get());
+            break;
+        }
+        case Kind::Unary: {
+            auto* n = static_cast<const UnaryExpression*>(node);
+            header(Kind::Unary, *n);
+            out.varint(static_cast<uint64_t>(n->op));
+            this->node(n->operand.get());
+            break;
+        }
+        case Kind::Call: {
+            auto* n = static_cast<const CallExpression*>(node);
+            header(Kind::Call, *n);
+            this->node(n->callee.get());
+            list(n->arguments);
+            break;
+        }
+        case Kind::Member: {
+            auto* n = static_cast<const MemberExpression*>(node);
+            header(Kind::Member, *n);
+            out.byte(n->computed);
+            this->node(n->object.get());
+            this->node(n->property.get());
+            break;
+        }
+        case Kind::Array: {
+            auto* n = static_cast<const ArrayExpression*>(node);
+            header(Kind::Array, *n);
+            list(n->elements);
+            break;
+        }
+        case Kind::ObjectProperty: {
+            auto* n = static_cast<const ObjectProperty*>(node);
+            header(Kind::ObjectProperty, *n);
+            this->node(n->key.get());
+            this->node(n->value.get());
+            break;
+        }
+        case Kind::Object: {
+            auto* n = static_cast<const ObjectExpression*>(node);
+            header(Kind::Object, *n);
+            list(n->properties);
+            break;
+        }
+        case Kind::ExpressionStatement: {
+            auto* n = static_cast<const ExpressionStatement*>(node);
+            header(Kind::ExpressionStatement, *n);
+            this->node(n->expression.get());
+            break;
+        }
+        case Kind::Block: {
+            auto* n = static_cast<const BlockStatement*>(node);
+            header(Kind::Block, *n);
+            list(n->statements);
+            break;
+        }
+        case Kind::VariableDeclaration: {
+            auto* n = static_cast<const VariableDeclaration*>(node);
+            header(Kind::VariableDeclaration, *n);
+            symbol(n->name);
+            out.varint(static_cast<uint64_t>(n->kind));
+            this->node(n->initializer.get());
+            break;
+        }
+        case Kind::Assignment: {
+            auto* n = static_cast<const Assignment*>(node);
+            header(Kind::Assignment, *n);
+            symbol(n->target);
+            out.varint(static_cast<uint64_t>(n->op));
+            this->node(n->value.get());
+            break;
+        }
+        case Kind::If: {
+            auto* n = static_cast<const IfStatement*>(node);
+            header(Kind::If, *n);
+            this->node(n->condition.get());
+            this->node(n->thenBranch.get());
+            this->node(n->elseBranch.get());
+            break;
+        }
+        case Kind::While: {
+            auto* n = static_cast<const WhileStatement*>(node);
+            header(Kind::While, *n);
+            this->node(n->condition.get());
+            this->node(n->body.get());
+            break;
+        }
+        case Kind::For: {
+            auto* n = static_cast<const ForStatement*>(node);
+            header(Kind::For, *n);
+            this->node(n->init.get());
+            this->node(n->condition.get());
+            this->node(n->update.get());
+            this->node(n->body.get());
+            break;
+        }
+        case Kind::ForIn: {
+            auto* n = static_cast<const ForInStatement*>(node);
+            header(Kind::ForIn, *n);
+            symbol(n->variable);
+            this->node(n->iterable.get());
+            this->node(n->body.get());
+            break;
+        }
+        case Kind::Return: {
+            auto* n = static_cast<const ReturnStatement*>(node);
+            header(Kind::Return, *n);
+            this->node(n->value.get());
+            break;
+        }
+        case Kind::Break: {
+            auto* n = static_cast<const BreakStatement*>(node);
+            header(Kind::Break, *n);
+            break;
+        }
+        case Kind::Continue: {
+            auto* n = static_cast<const ContinueStatement*>(node);
+            header(Kind::Continue, *n);
+            break;
+        }
+        case Kind::Try: {
+            auto* n = static_cast<const TryStatement*>(node);
+            header(Kind::Try, *n);
+            symbol(n->catchVariable);
+            this->node(n->block.get());
+            this->node(n->catchBlock.get());
+            this->node(n->finallyBlock.get());
+            break;
+        }
+        case Kind::Throw: {
+            auto* n = static_cast<const ThrowStatement*>(node);
+            header(Kind::Throw, *n);
+            this->node(n->value.get());
+            break;
+        }
+        case Kind::Import: {
+            auto* n = static_cast<const Import*>(node);
+            header(Kind::Import, *n);
+            symbols(n->bindings);
+            out.string(n->source);
+            out.byte(n->isDefault);
+            break;
+        }
+        case Kind::Export: {
+            auto* n = static_cast<const Export*>(node);
+            header(Kind::Export, *n);
+            out.byte(n->isDefault);
+            this->node(n->declaration.get());
+            break;
+        }
+        case Kind::Function: {
+            auto* n = static_cast<const Function*>(node);
+            header(Kind::Function, *n);
+            symbol(n->name);
+            symbols(n->parameters);
+            out.varint(static_cast<uint64_t>(n->functionType));
+            this->node(n->body.get());
+            break;
+        }
+        case Kind::Attribute: {
+            auto* n = static_cast<const Attribute*>(node);
+            header(Kind::Attribute, *n);
+            symbol(n->name);
+            this->node(n->value.get());
+            break;
+        }
+        case Kind::TextContent: {
+            auto* n = static_cast<const TextContent*>(node);
+            header(Kind::TextContent, *n);
+            out.string(n->text);
+            break;
+        }
+        case Kind::Tag: {
+            auto* n = static_cast<const Tag*>(node);
+            header(Kind::Tag, *n);
+            symbol(n->tagName);
+            out.byte(n->isSelfClosing);
+            out.varint(n->styles.size());
+            for (const StyleProperty& style : n->styles) {
+                out.string(style.property);
+                out.string(style.value);
+            }
+            list(n->attributes);
+            list(n->children);
+            break;
+        }
+        case Kind::Component: {
+            auto* n = static_cast<const Component*>(node);
+            header(Kind::Component, *n);
+            symbol(n->name);
+            out.varint(static_cast<uint64_t>(n->componentType));
+            list(n->statements);
+            list(n->body);
+            break;
+        }
+        case Kind::Program: {
+            auto* n = static_cast<const Program*>(node);
+            header(Kind::Program, *n);
+            list(n->components);
+            list(n->functions);
+            list(n->globalStatements);
+            break;
+        }
+        case Kind::Error:
+            header(Kind::Error, *node);
+            break;
+        case Kind::None:
+            out.byte(static_cast<uint8_t>(Kind::None));
+            break;
+        }
+    }
+
+private:
+    struct Nested {
+        explicit Nested(size_t& depth) : depth(depth) { ++depth; }
+        ~Nested() { --depth; }
+        size_t& depth;
+    };
+
+    void header(Kind kind, const Node& node) {
+        out.byte(static_cast<uint8_t>(kind));
+        // NoOffset wraps to 0, so nodes without a position cost one byte.
+        out.varint(static_cast<uint32_t>(node.offset + 1));
+    }
+
+    // 0 followed by the text for a name not seen yet, index + 1 after that.
+    void symbol(Symbol symbol) {
+        auto found = seen.find(symbol.id);
+        if (found != seen.end()) {
+            out.varint(found->second + 1);
+            return;
+        }
+        seen.emplace(symbol.id, static_cast<uint32_t>(seen.size()));
+        out.varint(0);
+        out.string(symbolText(symbol));
+    }
+
+    void symbols(const std::vector<Symbol>& list) {
+        out.varint(list.size());
+        for (Symbol s : list) symbol(s);
+    }
+
+    template <typename T>
+    void list(const std::vector<std::unique_ptr<T>>& nodes) {
+        out.varint(nodes.size());
+        for (const auto& n : nodes) node(n.get());
+    }
+
+    ByteWriter out;
+    std::unordered_map<uint32_t, uint32_t> seen;
+    size_t depth = 0;
+    bool tooDeep = false;
+};
+
+class Reader {
+public:
+    explicit Reader(std::string_view bytes) : in(bytes) {}
+
+    bool failed() const { return in.failed() || !in.atEnd(); }
+
+    // nullptr for an encoded null child, and on error.
+    ASTNodePtr node() {
+        Kind kind = static_cast<Kind>(in.byte());
+        if (kind == Kind::None || in.failed()) return nullptr;
+        if (depth >= MaxDepth) {
+            in.fail();
+            return nullptr;
+        }
+        ++depth;
+        uint32_t offset = static_cast<uint32_t>(in.varint()) - 1;
+        ASTNodePtr result = build(kind, offset);
+        --depth;
+        return result;
+    }
+
+    template <typename T>
+    std::unique_ptr<T> as() {
+        ASTNodePtr n = node();
+        if (n == nullptr) return nullptr;
+        T* typed = dynamic_cast<T*>(n.get());
+        if (typed == nullptr) {
+            in.fail();
+            return nullptr;
+        }
+        n.release();
+        return std::unique_ptr<T>(typed);
+    }
+
+private:
+    ASTNodePtr build(Kind kind, uint32_t o) {
+        switch (kind) {
+        case Kind::StringLiteral:
+            return std::make_unique<StringLiteral>(std::string(in.string()), o);
+        case Kind::NumberLiteral: {
+            std::string value(in.string());
+            return std::make_unique<NumberLiteral>(std::move(value), in.byte() != 0, o);
+        }
+        case Kind::BooleanLiteral:
+            return std::make_unique<BooleanLiteral>(in.byte() != 0, o);
+        case Kind::NullLiteral:
+            return std::make_unique<NullLiteral>(o);
+        case Kind::Identifier:
+            return std::make_unique<Identifier>(symbol(), o);
+        case Kind::ValueBinding:
+            return std::make_unique<ValueBinding>(symbol(), o);
+        case Kind::Binary: {
+            TokenType op = static_cast<TokenType>(in.varint());
+            ExpressionPtr left = as<Expression>();
+            ExpressionPtr right = as<Expression>();
+            return std::make_unique<BinaryExpression>(std::move(left), op, std::move(right), o);
+        }
+        case Kind::Unary: {
+            TokenType op = static_cast<TokenType>(in.varint());
+            return std::make_unique<UnaryExpression>(op, as<Expression>(), o);
+        }
+        case Kind::Call: {
+            ExpressionPtr callee = as<Expression>();
+            std::vector<ExpressionPtr> arguments;
+            list(arguments);
+            return std::make_unique<CallExpression>(std::move(callee), std::move(arguments), o);
+        }
+        case Kind::Member: {
+            bool computed = in.byte() != 0;
+            ExpressionPtr object = as<Expression>();
+            ExpressionPtr property = as<Expression>();
+            return std::make_unique<MemberExpression>(std::move(object), std::move(property), computed, o);
+        }
+        case Kind::Array: {
+            std::vector<ExpressionPtr> elements;
+            list(elements);
+            return std::make_unique<ArrayExpression>(std::move(elements), o);
+        }
+        case Kind::ObjectProperty: {
+            ExpressionPtr key = as<Expression>();
+            ExpressionPtr value = as<Expression>();
+            return std::make_unique<ObjectProperty>(std::move(key), std::move(value), o);
+        }
+        case Kind::Object: {
+            std::vector<std::unique_ptr<ObjectProperty>> properties;
+            list(properties);
+            return std::make_unique<ObjectExpression>(std::move(properties), o);
+        }
+        case Kind::ExpressionStatement:
+            return std::make_unique<ExpressionStatement>(as<Expression>(), o);
+        case Kind::Block: {
+            std::vector<StatementPtr> statements;
+            list(statements);
+            return std::make_unique<BlockStatement>(std::move(statements), o);
+        }
+        case Kind::VariableDeclaration: {
+            Symbol name = symbol();
+            Keyword declared = static_cast<Keyword>(in.varint());
+            return std::make_unique<VariableDeclaration>(name, as<Expression>(), declared, o);
+        }
+        case Kind::Assignment: {
+            Symbol target = symbol();
+            TokenType op = static_cast<TokenType>(in.varint());
+            return std::make_unique<Assignment>(target, as<Expression>(), op, o);
+        }
+        case Kind::If: {
+            ExpressionPtr condition = as<Expression>();
+            StatementPtr thenBranch = as<Statement>();
+            StatementPtr elseBranch = as<Statement>();
+            return std::make_unique<IfStatement>(std::move(condition), std::move(thenBranch), std::move(elseBranch), o);
+        }
+        case Kind::While: {
+            ExpressionPtr condition = as<Expression>();
+            StatementPtr body = as<Statement>();
+            return std::make_unique<WhileStatement>(std::move(condition), std::move(body), o);
+        }
+        case Kind::For: {
+            StatementPtr init = as<Statement>();
+            ExpressionPtr condition = as<Expression>();
+            ExpressionPtr update = as<Expression>();
+            StatementPtr body = as<Statement>();
+            return std::make_unique<ForStatement>(std::move(init), std::move(condition), std::move(update),
+                                                  std::move(body), o);
+        }
+        case Kind::ForIn: {
+            Symbol variable = symbol();
+            ExpressionPtr iterable = as<Expression>();
+            StatementPtr body = as<Statement>();
+            return std::make_unique<ForInStatement>(variable, std::move(iterable), std::move(body), o);
+        }
+        case Kind::Return:
+            return std::make_unique<ReturnStatement>(as<Expression>(), o);
+        case Kind::Break:
+            return std::make_unique<BreakStatement>(o);
+        case Kind::Continue:
+            return std::make_unique<ContinueStatement>(o);
+        case Kind::Try: {
+            Symbol catchVariable = symbol();
+            auto statement = std::make_unique<TryStatement>(as<Statement>(), o);
+            statement->catchVariable = catchVariable;
+            statement->catchBlock = as<Statement>();
+            statement->finallyBlock = as<Statement>();
+            return statement;
+        }
+        case Kind::Throw:
+            return std::make_unique<ThrowStatement>(as<Expression>(), o);
+        case Kind::Import: {
+            std::vector<Symbol> bindings = symbols();
+            std::string source(in.string());
+            return std::make_unique<Import>(std::move(bindings), std::move(source), in.byte() != 0, o);
+        }
+        case Kind::Export: {
+            bool isDefault = in.byte() != 0;
+            return std::make_unique<Export>(as<Statement>(), isDefault, o);
+        }
+        case Kind::Function: {
+            Symbol name = symbol();
+            std::vector<Symbol> parameters = symbols();
+            FunctionType type = static_cast<FunctionType>(in.varint());
+            return std::make_unique<Function>(name, std::move(parameters), as<Statement>(), type, o);
+        }
+        case Kind::Attribute: {
+            Symbol name = symbol();
+            return std::make_unique<Attribute>(name, as<Expression>(), o);
+        }
+        case Kind::TextContent:
+            return std::make_unique<TextContent>(std::string(in.string()), o);
+        case Kind::Tag: {
+            auto tag = std::make_unique<Tag>(symbol(), o);
+            tag->isSelfClosing = in.byte() != 0;
+            uint64_t styles = in.varint();
+            for (uint64_t i = 0; i < styles && !in.failed(); ++i) {
+                std::string property(in.string());
+                tag->styles.emplace_back(std::move(property), std::string(in.string()));
+            }
+            list(tag->attributes);
+            list(tag->children);
+            return tag;
+        }
+        case Kind::Component: {
+            Symbol name = symbol();
+            auto component = std::make_unique<Component>(name, static_cast<ComponentType>(in.varint()), o);
+            list(component->statements);
+            list(component->body);
+            return component;
+        }
+        case Kind::Program: {
+            auto program = std::make_unique<Program>();
+            program->offset = o;
+            list(program->components);
+            list(program->functions);
+            list(program->globalStatements);
+            return program;
+        }
+        case Kind::Error:
+            return std::make_unique<ErrorExpression>(o);
+        case Kind::None:
+            break;
+        }
+        in.fail();
+        return nullptr;
+    }
+
+    Symbol symbol() {
+        uint64_t index = in.varint();
+        if (index == 0) {
+            table.push_back(intern(in.string()));
+            return table.back();
+        }
+        if (index > table.size()) {
+            in.fail();
+            return Symbol();
+        }
+        return table[index - 1];
+    }
+
+    std::vector<Symbol> symbols() {
+        std::vector<Symbol> result;
+        uint64_t count = in.varint();
+        for (uint64_t i = 0; i < count && !in.failed(); ++i) result.push_back(symbol());
+        return result;
+    }
+
+    template <typename T>
+    void list(std::vector<std::unique_ptr<T>>& nodes) {
+        uint64_t count = in.varint();
+        for (uint64_t i = 0; i < count && !in.failed(); ++i) nodes.push_back(as<T>());
+    }
+
+    ByteReader in;
+    std::vector<Symbol> table;
+    size_t depth = 0;
+};
+
+}
+
+bool writeProgram(const Program& program, std::string& out) {
+    size_t start = out.size();
+    Writer writer(out);
+    writer.node(&program);
+    if (writer.ok()) return true;
+    out.resize(start);
+    return false;
+}
+
+std::unique_ptr<Program> readProgram(std::string_view bytes) {
+    Reader reader(bytes);
+    std::unique_ptr<Program> program = reader.as<Program>();
+    if (reader.failed()) return nullptr;
+    return program;
+}
@@ -0,0 +1,243 @@
+#include "compile_cache.h"
+#include "ast_serialization.h"
+#include "binary_io.h"
+#include "parser.h"
+#include "phase_timer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <system_error>
+#include <thread>
+
+#ifndef ALTERION_VERSION
+#define ALTERION_VERSION "unknown"
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Bump whenever the layout below or the AST encoding changes, or the lexer
+// or parser produce different results for the same source; old entries then
+// simply stop matching.
+constexpr uint32_t EntryFormat = 4;
+constexpr char Magic[4] = {'A', 'L', 'T', 'C'};
+constexpr const char* Extension = ".altc";
+
+struct Section {
+    uint64_t offset;
+    uint64_t size;
+};
+
+// Fixed-size prefix of every entry. `checksum` covers everything after it.
+struct EntryHeader {
+    char magic[4];
+    uint32_t format;
+    uint64_t keyHigh;
+    uint64_t keyLow;
+    Section ast;          // size 0: no program
+    Section diagnostics;
+    uint64_t checksum;
+};
+
+std::string_view slice(std::string_view file, const Section& section) {
+    if (section.offset > file.size() || section.size > file.size() - section.offset) return {};
+    return file.substr(section.offset, section.size);
+}
+
+bool inside(const Section& section, size_t fileSize) {
+    return section.offset <= fileSize && section.size <= fileSize - section.offset;
+}
+
+}
+
+std::unique_ptr<Program> CacheEntry::program() const {
+    if (astSection.empty()) return nullptr;
+    return readProgram(astSection);
+}
+
+std::vector<Diagnostic> CacheEntry::diagnostics() const {
+    std::vector<Diagnostic> result;
+    ByteReader in(diagnosticSection);
+    uint64_t count = in.varint();
+    for (uint64_t i = 0; i < count && !in.failed(); ++i) {
+        Diagnostic diagnostic;
+        diagnostic.phase = static_cast<Diagnostic::Phase>(in.byte());
+        diagnostic.line = in.varint();
+        diagnostic.column = in.varint();
+        diagnostic.message = std::string(in.string());
+        result.push_back(std::move(diagnostic));
+    }
+    return result;
+}
+
+CompileCache::CompileCache(std::string directory, uint64_t limitBytes)
+    : root(std::move(directory)), limit(limitBytes) {
+    std::error_code ec;
+    fs::create_directories(root, ec);
+    usable = !ec && fs::is_directory(root, ec);
+}
+
+ContentHash CompileCache::keyFor(std::string_view source, const CompileOptions& options) {
+    static const std::string version = std::string("alterion " ALTERION_VERSION " entry ") + std::to_string(EntryFormat);
+    // Both limits cut the program and diagnostics short.
+    size_t nesting = options.nestingLimit != 0 ? options.nestingLimit : Parser::DefaultNestingLimit;
+    return contentHash(source, version + " errors " + std::to_string(options.errorLimit) + " nesting " +
+                                   std::to_string(nesting));
+}
+
+std::string CompileCache::pathFor(const ContentHash& key) const {
+    return (fs::path(root) / (key.hex() + Extension)).string();
+}
+
+std::unique_ptr<CacheEntry> CompileCache::find(const ContentHash& key) {
+    if (!usable) {
+        misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    std::string path = pathFor(key);
+    std::error_code ec;
+    if (!fs::is_regular_file(path, ec)) {
+        misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    auto file = SourceBuffer::fromFile(path);
+    EntryHeader header{};
+    bool valid = file != nullptr && file->size() >= sizeof header;
+    if (valid) {
+        std::string_view bytes = file->text();
+        std::memcpy(&header, bytes.data(), sizeof header);
+        valid = std::equal(std::begin(Magic), std::end(Magic), header.magic) && header.format == EntryFormat &&
+                header.keyHigh == key.high && header.keyLow == key.low && inside(header.ast, bytes.size()) &&
+                inside(header.diagnostics, bytes.size()) &&
+                xxhash64(bytes.substr(sizeof header)) == header.checksum;
+    }
+    if (!valid) {
+        // Truncated by a crash, written by another format, or bit rot.
+        file.reset();
+        fs::remove(path, ec);
+        misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    auto entry = std::make_unique<CacheEntry>();
+    std::string_view bytes = file->text();
+    entry->astSection = slice(bytes, header.ast);
+    entry->diagnosticSection = slice(bytes, header.diagnostics);
+    entry->file = std::move(file);
+
+    // Recently used entries are the last to be evicted.
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    hits.fetch_add(1, std::memory_order_relaxed);
+    return entry;
+}
+
+void CompileCache::store(const ContentHash& key, const Program* program, const std::vector<Diagnostic>& diagnostics) {
+    if (!usable) return;
+    PhaseTimer timer("serialize");
+
+    std::string astBytes;
+    if (program != nullptr && !writeProgram(*program, astBytes)) return;
+
+    std::string diagnosticBytes;
+    ByteWriter diagnosticOut(diagnosticBytes);
+    diagnosticOut.varint(diagnostics.size());
+    for (const Diagnostic& diagnostic : diagnostics) {
+        diagnosticOut.byte(static_cast<uint8_t>(diagnostic.phase));
+        diagnosticOut.varint(diagnostic.line);
+        diagnosticOut.varint(diagnostic.column);
+        diagnosticOut.string(diagnostic.message);
+    }
+
+    EntryHeader header{};
+    std::copy(std::begin(Magic), std::end(Magic), header.magic);
+    header.format = EntryFormat;
+    header.keyHigh = key.high;
+    header.keyLow = key.low;
+    uint64_t offset = sizeof header;
+    header.ast = {offset, astBytes.size()};
+    offset += astBytes.size();
+    header.diagnostics = {offset, diagnosticBytes.size()};
+
+    std::string body;
+    body.reserve(offset + diagnosticBytes.size() - sizeof header);
+    body += astBytes;
+    body += diagnosticBytes;
+    header.checksum = xxhash64(body);
+
+    // Unique per process and thread, so concurrent writers of the same key
+    // each rename a complete file into place and the last one wins.
+    std::string path = pathFor(key);
+    std::string temporary = path + ".tmp" +
+                            std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+                                           static_cast<size_t>(std::chrono::steady_clock::now().time_since_epoch().count())) +
+                            "-" + std::to_string(temporaryId.fetch_add(1, std::memory_order_relaxed));
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof header);
+        out.write(body.data(), static_cast<std::streamsize>(body.size()));
+        if (!out) {
+            out.close();
+            std::error_code ec;
+            fs::remove(temporary, ec);
+            return;
+        }
+    }
+    std::error_code ec;
+    fs::rename(temporary, path, ec);
+    if (ec) {
+        fs::remove(temporary, ec);
+        return;
+    }
+    stores.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t CompileCache::trim() {
+    if (!usable) return 0;
+
+    struct Candidate {
+        fs::path path;
+        uint64_t size;
+        fs::file_time_type used;
+    };
+    std::vector<Candidate> entries;
+    uint64_t total = 0;
+    std::error_code ec;
+    for (fs::directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+        std::error_code entryError;
+        if (!it->is_regular_file(entryError) || it->path().extension() != Extension) continue;
+        uint64_t size = it->file_size(entryError);
+        fs::file_time_type used = it->last_write_time(entryError);
+        if (entryError) continue;
+        entries.push_back({it->path(), size, used});
+        total += size;
+    }
+    if (total <= limit) return 0;
+
+    std::sort(entries.begin(), entries.end(),
+              [](const Candidate& a, const Candidate& b) { return a.used < b.used; });
+    uint64_t target = limit - limit / 10;
+    size_t removed = 0;
+    for (const Candidate& entry : entries) {
+        if (total <= target) break;
+        if (fs::remove(entry.path, ec)) {
+            total -= entry.size;
+            ++removed;
+        }
+    }
+    evictions.fetch_add(removed, std::memory_order_relaxed);
+    return removed;
+}
+
+CacheCounters CompileCache::counters() const {
+    CacheCounters result;
+    result.hits = hits.load(std::memory_order_relaxed);
+    result.misses = misses.load(std::memory_order_relaxed);
+    result.stores = stores.load(std::memory_order_relaxed);
+    result.evictions = evictions.load(std::memory_order_relaxed);
+    return result;
+}
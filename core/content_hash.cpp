@@ -0,0 +1,103 @@
+#include "content_hash.h"
+#include <cstring>
+
+namespace {
+
+constexpr uint64_t Prime1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t Prime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t Prime3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t Prime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t Prime5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline uint64_t read64(const unsigned char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof v);
+    return v;
+}
+
+inline uint32_t read32(const unsigned char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof v);
+    return v;
+}
+
+inline uint64_t mixLane(uint64_t acc, uint64_t input) {
+    acc += input * Prime2;
+    acc = rotl(acc, 31);
+    return acc * Prime1;
+}
+
+inline uint64_t mergeLane(uint64_t acc, uint64_t value) {
+    acc ^= mixLane(0, value);
+    return acc * Prime1 + Prime4;
+}
+
+}
+
+uint64_t xxhash64(const void* data, size_t size, uint64_t seed) {
+    const auto* p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + size;
+    uint64_t h;
+
+    if (size >= 32) {
+        // Four independent lanes over 32-byte stripes.
+        uint64_t v1 = seed + Prime1 + Prime2;
+        uint64_t v2 = seed + Prime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - Prime1;
+        const unsigned char* limit = end - 32;
+        do {
+            v1 = mixLane(v1, read64(p));
+            v2 = mixLane(v2, read64(p + 8));
+            v3 = mixLane(v3, read64(p + 16));
+            v4 = mixLane(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = mergeLane(h, v1);
+        h = mergeLane(h, v2);
+        h = mergeLane(h, v3);
+        h = mergeLane(h, v4);
+    } else {
+        h = seed + Prime5;
+    }
+    h += static_cast<uint64_t>(size);
+
+    for (; p + 8 <= end; p += 8) {
+        h ^= mixLane(0, read64(p));
+        h = rotl(h, 27) * Prime1 + Prime4;
+    }
+    if (p + 4 <= end) {
+        h ^= static_cast<uint64_t>(read32(p)) * Prime1;
+        h = rotl(h, 23) * Prime2 + Prime3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= *p * Prime5;
+        h = rotl(h, 11) * Prime1;
+    }
+
+    h ^= h >> 33;
+    h *= Prime2;
+    h ^= h >> 29;
+    h *= Prime3;
+    h ^= h >> 32;
+    return h;
+}
+
+std::string ContentHash::hex() const {
+    static const char digits[] = "0123456789abcdef";
+    std::string out(32, '0');
+    for (int i = 0; i < 16; ++i) {
+        out[15 - i] = digits[(high >> (4 * i)) & 0xF];
+        out[31 - i] = digits[(low >> (4 * i)) & 0xF];
+    }
+    return out;
+}
+
+ContentHash contentHash(std::string_view bytes, std::string_view salt) {
+    uint64_t seed = xxhash64(salt, 0x9E3779B97F4A7C15ULL);
+    return {xxhash64(bytes, seed), xxhash64(bytes, ~seed)};
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Opt-in heap allocation counters for the front end's phases.
+//
+// Counting needs the global operator new/delete replacement in
+// core/alloc_hook.cpp. A binary that does not link that file still builds
+// against this header, but available() is false and every count is zero.
+// Counters are per thread, so a scope sees only what its own thread
+// allocates, whatever the other workers are doing.
+//
+//     AllocationScope scope;
+//     auto tokens = lexer.tokenize();
+//     stats.add("lex", scope.counts());
+
+struct AllocationCounts {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    // Highest live heap size reached above the level the scope started at.
+    uint64_t peakLiveBytes = 0;
+
+    // Sums allocations and bytes; keeps the larger peak, as phases that run
+    // one after another (or on different threads) do not stack.
+    AllocationCounts& operator+=(const AllocationCounts& other);
+};
+
+namespace allocstats {
+
+// True if core/alloc_hook.cpp is linked in and counting.
+bool available();
+
+namespace detail {
+
+struct ThreadCounters {
+    uint64_t allocations;
+    uint64_t bytes;
+    int64_t live;   // can go negative on a thread that frees others' blocks
+    int64_t peak;
+};
+
+ThreadCounters& counters();
+void markAvailable();
+
+} // namespace detail
+} // namespace allocstats
+
+// Counts the calling thread's allocations from construction on. Scopes
+// nest: an inner scope's peak does not hide the outer one's.
+class AllocationScope {
+public:
+    AllocationScope();
+    ~AllocationScope();
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+    AllocationCounts counts() const;
+
+private:
+    uint64_t startAllocations;
+    uint64_t startBytes;
+    int64_t startLive;
+    int64_t outerPeak;
+};
+
+// Totals per named phase, safe to add to from several threads. Phases are
+// listed in the order they were first added.
+class AllocationStats {
+public:
+    struct Phase {
+        std::string name;
+        AllocationCounts counts;
+        uint64_t samples = 0;   // number of add() calls
+    };
+
+    void add(std::string_view phase, const AllocationCounts& counts);
+    void addInputBytes(uint64_t bytes);
+
+    std::vector<Phase> phases() const;
+    uint64_t inputBytes() const;
+
+    // One line per phase: allocations, bytes, peak live bytes, and
+    // allocations and bytes per input byte.
+    void print(std::ostream& out) const;
+
+private:
+    mutable std::mutex mutex;
+    std::vector<Phase> entries;
+    uint64_t input = 0;
+};
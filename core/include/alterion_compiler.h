@@ -0,0 +1,59 @@
+#pragma once
+#include "ast_complete.h"
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Front-end driver: lexes and parses many source files concurrently, one
+// Lexer/Parser per file on a work-stealing pool, and hands back results in
+// input order so that output never depends on scheduling.
+
+struct Diagnostic {
+    enum class Phase { Read, Lex, Parse };
+
+    Phase phase;
+    size_t line = 0;
+    size_t column = 0;
+    std::string message;
+};
+
+class AllocationStats;
+class CompileCache;
+
+struct FileResult {
+    std::string path;
+    size_t bytes = 0;
+    bool cached = false;                  // taken from the compile cache
+    std::unique_ptr<Program> program;     // null if the file could not be read
+    std::vector<Diagnostic> diagnostics;  // sorted by line, then column
+};
+
+struct CompileOptions {
+    unsigned jobs = 0;   // worker threads; 0 = one per hardware thread
+    // Optional. Unchanged files are loaded from it instead of being lexed and
+    // parsed, new results are stored, and it is trimmed after the run.
+    CompileCache* cache = nullptr;
+    // Optional. Heap allocations are added to it per phase ("lex", "parse",
+    // and with a cache "load" and "serialize"); counts stay zero unless the
+    // binary links the allocation hook.
+    AllocationStats* stats = nullptr;
+    // Parse errors per file after which the rest of the file is skipped;
+    // 0 = no limit.
+    size_t errorLimit = 0;
+    // Tag or expression nesting past which the parser reports an error
+    // (Parser::setNestingLimit); 0 = the parser's default.
+    size_t nestingLimit = 0;
+};
+
+// Expands directories (recursively, *.alt) and returns a sorted, de-duplicated
+// list of files. Paths that are neither files nor directories are kept so the
+// driver reports them as unreadable.
+std::vector<std::string> collectSourceFiles(const std::vector<std::string>& inputs);
+
+// Results are indexed like `files`, whatever order the tasks ran in.
+std::vector<FileResult> compileFiles(const std::vector<std::string>& files, const CompileOptions& options = {});
+
+// `path:line:column: error: message`, one line per diagnostic, files in order.
+void printDiagnostics(const std::vector<FileResult>& results, std::ostream& out);
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Bump allocator for data that lives exactly as long as one compilation unit.
+// Allocation is a pointer bump inside the current block; nothing is freed
+// individually, the whole arena goes away with its owner.
+class Arena {
+public:
+    explicit Arena(size_t blockSize = 64 * 1024) : blockSize(blockSize) {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    Arena(Arena&&) = default;
+    Arena& operator=(Arena&&) = default;
+
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        uintptr_t aligned = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~(uintptr_t(align) - 1);
+        if (cursor == nullptr || aligned + size > reinterpret_cast<uintptr_t>(limit)) {
+            grow(size + align);
+            aligned = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~(uintptr_t(align) - 1);
+        }
+        cursor = reinterpret_cast<char*>(aligned + size);
+        used += size;
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    // Copies the bytes into the arena and returns a view that stays valid
+    // for the lifetime of the arena.
+    std::string_view copy(std::string_view text) {
+        if (text.empty()) return {};
+        char* dest = static_cast<char*>(allocate(text.size(), 1));
+        std::memcpy(dest, text.data(), text.size());
+        return std::string_view(dest, text.size());
+    }
+
+    size_t bytesUsed() const { return used; }
+    size_t bytesReserved() const { return reserved; }
+
+private:
+    void grow(size_t minimum) {
+        size_t size = minimum > blockSize ? minimum : blockSize;
+        blocks.emplace_back(new char[size]);
+        cursor = blocks.back().get();
+        limit = cursor + size;
+        reserved += size;
+    }
+
+    size_t blockSize;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    size_t used = 0;
+    size_t reserved = 0;
+};
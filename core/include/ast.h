@@ -1,8 +1,13 @@
 #pragma once
+#include "arena.h"
+#include "json_writer.h"
+#include <cstddef>
+#include <cstdint>
+#include <new>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
-#include <memory>
-#include <optional>
 
 // AST Node Types
 enum class ASTNodeType {
@@ -27,18 +32,95 @@ enum class ASTNodeType {
     Error
 };
 
+// Generic tree node. Nodes are created by an ASTArena and live exactly as long
+// as it does: children are an intrusive list of raw pointers and all text is
+// interned in the arena, so a node owns nothing and is never destroyed on its
+// own. Dropping the arena frees the whole tree at once.
 struct ASTNode {
     ASTNodeType type;
-    std::string name;
-    std::vector<std::shared_ptr<ASTNode>> children;
-    std::optional<std::string> value;
-    size_t line = 0;
-    size_t column = 0;
-    std::optional<std::string> error;
-
-    ASTNode(ASTNodeType t, const std::string& n = "", size_t l = 0, size_t c = 0)
-        : type(t), name(n), line(l), column(c) {}
+    uint32_t line = 0;
+    uint32_t column = 0;
+    uint32_t childCount = 0;
+    std::string_view name;
+    // Unset when data() is null; an empty but present string has a non-null
+    // data() (see ASTArena::intern).
+    std::string_view value;
+    std::string_view error;
+    ASTNode* firstChild = nullptr;
+    ASTNode* lastChild = nullptr;
+    ASTNode* nextSibling = nullptr;
+
+    ASTNode(ASTNodeType t, std::string_view n, size_t l, size_t c)
+        : type(t), line(static_cast<uint32_t>(l)), column(static_cast<uint32_t>(c)), name(n) {}
+
+    bool hasValue() const { return value.data() != nullptr; }
+    bool hasError() const { return error.data() != nullptr; }
+
+    // Forward iteration over the direct children.
+    class ChildIterator {
+    public:
+        explicit ChildIterator(const ASTNode* n) : node(n) {}
+        const ASTNode& operator*() const { return *node; }
+        const ASTNode* operator->() const { return node; }
+        ChildIterator& operator++() { node = node->nextSibling; return *this; }
+        bool operator!=(const ChildIterator& other) const { return node != other.node; }
+    private:
+        const ASTNode* node;
+    };
+
+    struct ChildRange {
+        const ASTNode* first;
+        ChildIterator begin() const { return ChildIterator(first); }
+        ChildIterator end() const { return ChildIterator(nullptr); }
+    };
+
+    ChildRange children() const { return ChildRange{firstChild}; }
+};
+
+static_assert(std::is_trivially_destructible<ASTNode>::value,
+              "ASTNode must stay trivially destructible; the arena never runs destructors");
+
+// Owns every node and string of one compilation unit's tree.
+class ASTArena {
+public:
+    explicit ASTArena(size_t blockSize = 256 * 1024) : arena(blockSize) {}
+
+    ASTArena(const ASTArena&) = delete;
+    ASTArena& operator=(const ASTArena&) = delete;
+
+    ASTNode* create(ASTNodeType type, std::string_view name = {}, size_t line = 0, size_t column = 0) {
+        void* memory = arena.allocate(sizeof(ASTNode), alignof(ASTNode));
+        ++nodes;
+        return new (memory) ASTNode(type, intern(name), line, column);
+    }
+
+    static void addChild(ASTNode* parent, ASTNode* child) {
+        if (parent->lastChild) parent->lastChild->nextSibling = child;
+        else parent->firstChild = child;
+        parent->lastChild = child;
+        ++parent->childCount;
+    }
+
+    void setValue(ASTNode* node, std::string_view text) { node->value = intern(text); }
+    void setError(ASTNode* node, std::string_view text) { node->error = intern(text); }
+
+    // Returns the arena's single copy of `text`. Equal strings share storage,
+    // so repeated identifiers and tag names cost one copy per unit.
+    std::string_view intern(std::string_view text);
+
+    size_t nodeCount() const { return nodes; }
+    size_t bytesUsed() const { return arena.bytesUsed(); }
+
+private:
+    void growTable();
+
+    Arena arena;
+    std::vector<std::string_view> table;   // open addressing, power-of-two size
+    size_t interned = 0;
+    size_t nodes = 0;
 };
 
-// Utility for JSON serialization
-std::string astToJson(const std::shared_ptr<ASTNode>& node, int indent = 0);
+// JSON serialization: one object per node with type, name, value (if set),
+// line, column, error (if set) and children.
+void writeASTJson(JsonWriter& json, const ASTNode& root);
+std::string astToJson(const ASTNode* node, JsonWriter::Style style = JsonWriter::Style::Pretty);
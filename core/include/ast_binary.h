@@ -0,0 +1,116 @@
+#pragma once
+#include "ast.h"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Flat binary form of an ASTNode tree, for tools that only read the tree
+// (the results dashboard, diffing, test snapshots). Where astToJson spells
+// every field out as text, this is a fixed-size record per node plus a
+// string table, and the reader works straight on the bytes: opening a file
+// validates it once and then allocates nothing.
+//
+// Layout, all integers little-endian:
+//
+//   header   magic "ALTA", u16 version, u16 header size, u32 node count,
+//            u32 node record size, u32 string count, u32 string bytes,
+//            u32 root node, u32 reserved                           (32 bytes)
+//   nodes    node count records of
+//            u8 type, u8 flags (1 = has value, 2 = has error), u16 0,
+//            u32 line, u32 column, u32 name, u32 value, u32 error,
+//            u32 first child, u32 child count                      (32 bytes)
+//   strings  string count pairs of u32 offset, u32 length, then the bytes
+//
+// Nodes are stored breadth-first, so the children of a node are the
+// consecutive records [first child, first child + child count). name, value
+// and error are string indices; string 0 is always the empty string. A
+// reader must skip header and record bytes past the sizes it knows, so
+// fields can be appended without bumping the version; anything else that
+// changes bumps ASTBinaryVersion.
+
+constexpr uint16_t ASTBinaryVersion = 1;
+
+// Appends the encoding of the tree under `root` to `out`. Iterative, so any
+// depth is fine.
+void writeASTBinary(const ASTNode& root, std::string& out);
+
+class ASTBinaryView {
+public:
+    // Checks the header, every child range and every string reference, so
+    // that nothing read through the view afterwards can go out of bounds.
+    // On failure returns nullopt and, if `error` is given, says why. The
+    // view points into `bytes`, which must outlive it.
+    static std::optional<ASTBinaryView> open(std::string_view bytes, std::string* error = nullptr);
+
+    class Node {
+    public:
+        ASTNodeType type() const { return static_cast<ASTNodeType>(static_cast<uint8_t>(record()[0])); }
+        uint32_t line() const { return field(4); }
+        uint32_t column() const { return field(8); }
+        std::string_view name() const { return view->string(field(12)); }
+        // Null data() when unset, like ASTNode::value.
+        std::string_view value() const { return hasValue() ? view->string(field(16)) : std::string_view(); }
+        std::string_view error() const { return hasError() ? view->string(field(20)) : std::string_view(); }
+        bool hasValue() const { return (record()[1] & 1) != 0; }
+        bool hasError() const { return (record()[1] & 2) != 0; }
+
+        uint32_t childCount() const { return field(28); }
+        Node child(uint32_t i) const { return Node(view, field(24) + i); }
+        uint32_t index() const { return position; }
+
+        class Iterator {
+        public:
+            Iterator(const ASTBinaryView* v, uint32_t i) : view(v), position(i) {}
+            Node operator*() const { return Node(view, position); }
+            Iterator& operator++() { ++position; return *this; }
+            bool operator!=(const Iterator& other) const { return position != other.position; }
+        private:
+            const ASTBinaryView* view;
+            uint32_t position;
+        };
+        struct Range {
+            Iterator first;
+            Iterator last;
+            Iterator begin() const { return first; }
+            Iterator end() const { return last; }
+        };
+        Range children() const {
+            return {Iterator(view, field(24)), Iterator(view, field(24) + field(28))};
+        }
+
+    private:
+        friend class ASTBinaryView;
+        Node(const ASTBinaryView* v, uint32_t i) : view(v), position(i) {}
+        const unsigned char* record() const { return view->nodes + size_t(position) * view->recordSize; }
+        uint32_t field(size_t offset) const { return ASTBinaryView::load32(record() + offset); }
+
+        const ASTBinaryView* view;
+        uint32_t position;
+    };
+
+    Node root() const { return Node(this, rootIndex); }
+    Node node(uint32_t index) const { return Node(this, index); }
+    uint32_t nodeCount() const { return count; }
+    uint16_t version() const { return formatVersion; }
+
+private:
+    ASTBinaryView() = default;
+
+    static uint32_t load32(const unsigned char* p) {
+        return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+    }
+    std::string_view string(uint32_t index) const {
+        const unsigned char* entry = strings + size_t(index) * 8;
+        return std::string_view(stringData + load32(entry), load32(entry + 4));
+    }
+
+    const unsigned char* nodes = nullptr;
+    const unsigned char* strings = nullptr;
+    const char* stringData = nullptr;
+    uint32_t count = 0;
+    uint32_t recordSize = 0;
+    uint32_t rootIndex = 0;
+    uint16_t formatVersion = 0;
+};
@@ -0,0 +1,319 @@
+#pragma once
+#include "ast.h"
+#include "line_table.h"
+#include "keywords.h"
+#include "token.h"
+#include "symbol_table.h"
+#include <functional>
+#include <string>
+#include <vector>
+#include <memory>
+
+// Typed AST produced by the Parser. Every node carries the generic
+// ASTNodeType it corresponds to so tools can treat it uniformly. Names
+// (identifiers, tags, attributes, parameters) are interned Symbols; use
+// symbolText() to get their spelling.
+
+struct Node {
+    static constexpr uint32_t NoOffset = LineTable::NoOffset;
+
+    ASTNodeType nodeType;
+    // Byte offset of the node's first token in the source; resolve it with
+    // SourceBuffer::lines().
+    uint32_t offset = NoOffset;
+
+    Node(ASTNodeType t, uint32_t at = NoOffset) : nodeType(t), offset(at) {}
+    virtual ~Node() = default;
+};
+
+struct Statement : Node {
+    using Node::Node;
+};
+
+struct Expression : Node {
+    using Node::Node;
+};
+
+using ASTNodePtr = std::unique_ptr<Node>;
+using StatementPtr = std::unique_ptr<Statement>;
+using ExpressionPtr = std::unique_ptr<Expression>;
+
+// ---- Expressions ----
+
+struct StringLiteral : Expression {
+    std::string value;
+    StringLiteral(std::string v, uint32_t at = NoOffset)
+        : Expression(ASTNodeType::Literal, at), value(std::move(v)) {}
+};
+
+struct NumberLiteral : Expression {
+    std::string value;
+    bool isFloat;
+    NumberLiteral(std::string v, bool f, uint32_t at = NoOffset)
+        : Expression(ASTNodeType::Literal, at), value(std::move(v)), isFloat(f) {}
+};
+
+struct BooleanLiteral : Expression {
+    bool value;
+    explicit BooleanLiteral(bool v, uint32_t at = NoOffset)
+        : Expression(ASTNodeType::Literal, at), value(v) {}
+};
+
+struct NullLiteral : Expression {
+    NullLiteral(uint32_t at = NoOffset) : Expression(ASTNodeType::Literal, at) {}
+};
+
+struct Identifier : Expression {
+    Symbol name;
+    Identifier(Symbol n, uint32_t at = NoOffset)
+        : Expression(ASTNodeType::Identifier, at), name(n) {}
+};
+
+// `!name` two-way binding to component state.
+struct ValueBinding : Expression {
+    Symbol name;
+    ValueBinding(Symbol n, uint32_t at = NoOffset)
+        : Expression(ASTNodeType::Identifier, at), name(n) {}
+};
+
+struct BinaryExpression : Expression {
+    ExpressionPtr left;
+    TokenType op;   // operatorText() gives the spelling
+    ExpressionPtr right;
+    BinaryExpression(ExpressionPtr lhs, TokenType o, ExpressionPtr rhs, uint32_t at = NoOffset)
+        : Expression(ASTNodeType::Expression, at), left(std::move(lhs)), op(o), right(std::move(rhs)) {}
+};
+
+struct UnaryExpression : Expression {
+    TokenType op;
+    ExpressionPtr operand;
+    UnaryExpression(TokenType o, ExpressionPtr e, uint32_t at = NoOffset)
+        : Expression(ASTNodeType::Expression, at), op(o), operand(std::move(e)) {}
+};
+
+struct CallExpression : Expression {
+    ExpressionPtr callee;
+    std::vector<ExpressionPtr> arguments;
+    CallExpression(ExpressionPtr fn, std::vector<ExpressionPtr> args, uint32_t at = NoOffset)
+        : Expression(ASTNodeType::Call, at), callee(std::move(fn)), arguments(std::move(args)) {}
+};
+
+struct MemberExpression : Expression {
+    ExpressionPtr object;
+    ExpressionPtr property;
+    bool computed;
+    MemberExpression(ExpressionPtr obj, ExpressionPtr prop, bool comp, uint32_t at = NoOffset)
+        : Expression(ASTNodeType::Expression, at), object(std::move(obj)), property(std::move(prop)), computed(comp) {}
+};
+
+struct ArrayExpression : Expression {
+    std::vector<ExpressionPtr> elements;
+    explicit ArrayExpression(std::vector<ExpressionPtr> e, uint32_t at = NoOffset)
+        : Expression(ASTNodeType::Expression, at), elements(std::move(e)) {}
+};
+
+struct ObjectProperty : Node {
+    ExpressionPtr key;
+    ExpressionPtr value;
+    ObjectProperty(ExpressionPtr k, ExpressionPtr v, uint32_t at = NoOffset)
+        : Node(ASTNodeType::Expression, at), key(std::move(k)), value(std::move(v)) {}
+};
+
+struct ObjectExpression : Expression {
+    std::vector<std::unique_ptr<ObjectProperty>> properties;
+    explicit ObjectExpression(std::vector<std::unique_ptr<ObjectProperty>> p, uint32_t at = NoOffset)
+        : Expression(ASTNodeType::Expression, at), properties(std::move(p)) {}
+};
+
+// Stands in for an expression the parser could not read; the matching
+// diagnostic is in Parser::errors().
+struct ErrorExpression : Expression {
+    ErrorExpression(uint32_t at = NoOffset) : Expression(ASTNodeType::Error, at) {}
+};
+
+// ---- Statements ----
+
+struct ExpressionStatement : Statement {
+    ExpressionPtr expression;
+    explicit ExpressionStatement(ExpressionPtr e, uint32_t at = NoOffset)
+        : Statement(ASTNodeType::Statement, at), expression(std::move(e)) {}
+};
+
+struct BlockStatement : Statement {
+    std::vector<StatementPtr> statements;
+    BlockStatement(std::vector<StatementPtr> s, uint32_t at = NoOffset)
+        : Statement(ASTNodeType::Block, at), statements(std::move(s)) {}
+};
+
+struct VariableDeclaration : Statement {
+    Symbol name;
+    ExpressionPtr initializer;
+    Keyword kind;   // Let, Const or Var
+    VariableDeclaration(Symbol n, ExpressionPtr init, Keyword k, uint32_t at = NoOffset)
+        : Statement(ASTNodeType::Variable, at), name(n), initializer(std::move(init)), kind(k) {}
+};
+
+struct Assignment : Statement {
+    Symbol target;
+    ExpressionPtr value;
+    TokenType op;   // Equals or one of the compound assignments
+    Assignment(Symbol t, ExpressionPtr v, TokenType o, uint32_t at = NoOffset)
+        : Statement(ASTNodeType::Assignment, at), target(t), value(std::move(v)), op(o) {}
+};
+
+struct IfStatement : Statement {
+    ExpressionPtr condition;
+    StatementPtr thenBranch;
+    StatementPtr elseBranch;
+    IfStatement(ExpressionPtr cond, StatementPtr thenB, StatementPtr elseB, uint32_t at = NoOffset)
+        : Statement(ASTNodeType::If, at), condition(std::move(cond)), thenBranch(std::move(thenB)), elseBranch(std::move(elseB)) {}
+};
+
+struct WhileStatement : Statement {
+    ExpressionPtr condition;
+    StatementPtr body;
+    WhileStatement(ExpressionPtr cond, StatementPtr b, uint32_t at = NoOffset)
+        : Statement(ASTNodeType::While, at), condition(std::move(cond)), body(std::move(b)) {}
+};
+
+struct ForStatement : Statement {
+    StatementPtr init;
+    ExpressionPtr condition;
+    ExpressionPtr update;
+    StatementPtr body;
+    ForStatement(StatementPtr i, ExpressionPtr cond, ExpressionPtr u, StatementPtr b, uint32_t at = NoOffset)
+        : Statement(ASTNodeType::For, at), init(std::move(i)), condition(std::move(cond)), update(std::move(u)), body(std::move(b)) {}
+};
+
+struct ForInStatement : Statement {
+    Symbol variable;
+    ExpressionPtr iterable;
+    StatementPtr body;
+    ForInStatement(Symbol v, ExpressionPtr it, StatementPtr b, uint32_t at = NoOffset)
+        : Statement(ASTNodeType::For, at), variable(v), iterable(std::move(it)), body(std::move(b)) {}
+};
+
+struct ReturnStatement : Statement {
+    ExpressionPtr value;
+    ReturnStatement(ExpressionPtr v, uint32_t at = NoOffset)
+        : Statement(ASTNodeType::Return, at), value(std::move(v)) {}
+};
+
+struct BreakStatement : Statement {
+    BreakStatement(uint32_t at = NoOffset) : Statement(ASTNodeType::Statement, at) {}
+};
+
+struct ContinueStatement : Statement {
+    ContinueStatement(uint32_t at = NoOffset) : Statement(ASTNodeType::Statement, at) {}
+};
+
+struct TryStatement : Statement {
+    StatementPtr block;
+    Symbol catchVariable;
+    StatementPtr catchBlock;
+    StatementPtr finallyBlock;
+    TryStatement(StatementPtr b, uint32_t at = NoOffset)
+        : Statement(ASTNodeType::Statement, at), block(std::move(b)) {}
+};
+
+struct ThrowStatement : Statement {
+    ExpressionPtr value;
+    ThrowStatement(ExpressionPtr v, uint32_t at = NoOffset)
+        : Statement(ASTNodeType::Statement, at), value(std::move(v)) {}
+};
+
+struct Import : Statement {
+    std::vector<Symbol> bindings;
+    std::string source;
+    bool isDefault;
+    Import(std::vector<Symbol> b, std::string s, bool d, uint32_t at = NoOffset)
+        : Statement(ASTNodeType::Statement, at), bindings(std::move(b)), source(std::move(s)), isDefault(d) {}
+};
+
+struct Export : Statement {
+    StatementPtr declaration;
+    bool isDefault;
+    Export(StatementPtr decl, bool d, uint32_t at = NoOffset)
+        : Statement(ASTNodeType::Statement, at), declaration(std::move(decl)), isDefault(d) {}
+};
+
+enum class FunctionType {
+    REGULAR,
+    ASYNC,
+    ARROW
+};
+
+struct Function : Statement {
+    Symbol name;
+    std::vector<Symbol> parameters;
+    StatementPtr body;
+    FunctionType functionType;
+    Function(Symbol n, std::vector<Symbol> params, StatementPtr b, FunctionType ft, uint32_t at = NoOffset)
+        : Statement(ASTNodeType::Function, at), name(n), parameters(std::move(params)), body(std::move(b)), functionType(ft) {}
+};
+
+using FunctionPtr = std::unique_ptr<Function>;
+
+// ---- ALTX ----
+
+struct StyleProperty {
+    std::string property;
+    std::string value;
+    StyleProperty(std::string p, std::string v) : property(std::move(p)), value(std::move(v)) {}
+};
+
+struct Attribute : Node {
+    Symbol name;
+    ExpressionPtr value;
+    Attribute(Symbol n, ExpressionPtr v, uint32_t at = NoOffset)
+        : Node(ASTNodeType::Attribute, at), name(n), value(std::move(v)) {}
+};
+
+struct TextContent : Node {
+    std::string text;
+    TextContent(std::string t, uint32_t at = NoOffset)
+        : Node(ASTNodeType::Literal, at), text(std::move(t)) {}
+};
+
+struct Tag : Node {
+    Symbol tagName;
+    std::vector<std::unique_ptr<Attribute>> attributes;
+    std::vector<StyleProperty> styles;
+    std::vector<ASTNodePtr> children;
+    bool isSelfClosing = false;
+    Tag(Symbol name, uint32_t at = NoOffset)
+        : Node(ASTNodeType::Tag, at), tagName(name) {}
+};
+
+using TagPtr = std::unique_ptr<Tag>;
+
+// ---- Top level ----
+
+enum class ComponentType {
+    UI,
+    LOGIC,
+    MIXED
+};
+
+struct Component : Statement {
+    Symbol name;
+    ComponentType componentType;
+    std::vector<StatementPtr> statements;
+    std::vector<ASTNodePtr> body;
+    Component(Symbol n, ComponentType ct, uint32_t at = NoOffset)
+        : Statement(ASTNodeType::Component, at), name(n), componentType(ct) {}
+};
+
+using ComponentPtr = std::unique_ptr<Component>;
+
+struct Program : Node {
+    std::vector<ComponentPtr> components;
+    std::vector<FunctionPtr> functions;
+    std::vector<StatementPtr> globalStatements;
+    Program() : Node(ASTNodeType::Program) {}
+};
+
+// Calls `visit` on every direct child of `node` (operands, statements,
+// attributes, tag children, ...) in source order. Null children are skipped.
+void forEachChild(Node& node, const std::function<void(Node&)>& visit);
+void forEachChild(const Node& node, const std::function<void(const Node&)>& visit);
@@ -0,0 +1,22 @@
+#pragma once
+#include "ast_complete.h"
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Compact binary encoding of a parsed Program, used by the compile cache to
+// hand back a tree without lexing or parsing. Nodes are written in pre-order
+// as a kind byte, a varint source offset, then their fields and children.
+// Each name is spelled out once; later uses refer back to it, and reading
+// interns it again, since Symbol ids are only meaningful within a process.
+//
+// The encoding has no version of its own: whoever stores it (CompileCache)
+// versions the container.
+
+// Appends the encoding of `program` to `out`. Returns false, and appends
+// nothing, for trees nested more than 10000 levels deep.
+bool writeProgram(const Program& program, std::string& out);
+
+// Rebuilds a Program from writeProgram()'s output. Returns nullptr if the
+// bytes are truncated or malformed; never reads past `bytes`.
+std::unique_ptr<Program> readProgram(std::string_view bytes);
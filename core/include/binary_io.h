@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// Little helpers for the compiler's on-disk formats. Integers are LEB128
+// varints, so small line numbers, counts and enum values take one byte.
+// Fixed-width fields are written in host byte order; these files are caches
+// for the machine that wrote them, not an interchange format.
+
+class ByteWriter {
+public:
+    explicit ByteWriter(std::string& out) : out(out) {}
+
+    void byte(uint8_t value) { out.push_back(static_cast<char>(value)); }
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            byte(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        byte(static_cast<uint8_t>(value));
+    }
+    void string(std::string_view text) {
+        varint(text.size());
+        out.append(text.data(), text.size());
+    }
+    template <typename T>
+    void fixed(T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof value);
+    }
+    size_t size() const { return out.size(); }
+
+private:
+    std::string& out;
+};
+
+// Reads what ByteWriter wrote. Running past the end or reading a malformed
+// varint sets failed() and yields zeros, so callers can decode a whole
+// record and check once at the end.
+class ByteReader {
+public:
+    explicit ByteReader(std::string_view bytes) : data(bytes) {}
+
+    uint8_t byte() {
+        if (position >= data.size()) {
+            fail();
+            return 0;
+        }
+        return static_cast<uint8_t>(data[position++]);
+    }
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t b = byte();
+            value |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if ((b & 0x80) == 0) return value;
+        }
+        fail();
+        return 0;
+    }
+    // Views into the underlying bytes; nothing is copied.
+    std::string_view string() {
+        uint64_t size = varint();
+        return bytes(size);
+    }
+    std::string_view bytes(uint64_t size) {
+        if (size > data.size() - position) {
+            fail();
+            return {};
+        }
+        std::string_view result = data.substr(position, size);
+        position += size;
+        return result;
+    }
+    template <typename T>
+    T fixed() {
+        T value{};
+        std::string_view raw = bytes(sizeof value);
+        if (!raw.empty()) std::memcpy(&value, raw.data(), sizeof value);
+        return value;
+    }
+
+    bool failed() const { return error; }
+    bool atEnd() const { return position == data.size(); }
+    size_t offset() const { return position; }
+    void fail() { error = true; position = data.size(); }
+
+private:
+    std::string_view data;
+    size_t position = 0;
+    bool error = false;
+};
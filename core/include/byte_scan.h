@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Vectorised byte scanners for the lexer's hot loops (whitespace, comment and
+// string bodies, ALTX text). Each returns the offset of the first byte in
+// [data, data + size) that stops the scan, or size if none does.
+//
+// A byte with the high bit set always stops a scan: the caller steps over
+// the UTF-8 sequence itself so columns stay counted in codepoints. '\n'
+// stops every scan as well, so a run that was scanned over can be added to
+// the column in one go.
+//
+// The implementation (AVX2, SSE2 or scalar) is picked on first use from what
+// the CPU supports. Setting ALTERION_SCAN=scalar|sse2|avx2 overrides that.
+namespace bytescan {
+
+// Stops at anything other than ' ', '\t', '\r', '\v' and '\f'.
+size_t skipBlanks(const char* data, size_t size);
+
+// Stops at any of the four given bytes (repeat one to search for fewer).
+size_t findAny(const char* data, size_t size, char a, char b, char c, char d);
+
+// Stops at anything that can start an ALTX token, i.e. at anything other than
+// ASCII control characters, ' ', '`', '\\' and DEL.
+size_t skipText(const char* data, size_t size);
+
+// Stops at the bytes a JSON string must escape: '"', '\\' and control
+// characters below 0x20. Unlike the scans above, bytes with the high bit set
+// do not stop it; UTF-8 is copied through as it is.
+size_t findJsonEscape(const char* data, size_t size);
+
+// Appends `base + i + 1` to `starts` for every '\n' at data[i], i.e. where
+// each following line begins. Not a scan that stops: it runs to the end.
+void appendLineStarts(const char* data, size_t size, uint32_t base, std::vector<uint32_t>& starts);
+
+enum class Implementation { Scalar, SSE2, AVX2 };
+
+Implementation active();
+bool isSupported(Implementation impl);
+// Switches the implementation used by the functions above. Returns false,
+// leaving the selection unchanged, if the CPU does not support it.
+bool select(Implementation impl);
+const char* name(Implementation impl);
+
+} // namespace bytescan
@@ -0,0 +1,88 @@
+#pragma once
+#include "alterion_compiler.h"
+#include "content_hash.h"
+#include "source_buffer.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// On-disk cache of front-end results, addressed by the content of the source
+// file. The key hashes the source bytes together with the compiler version,
+// the entry format and the options that change what the parser produces, so
+// an unchanged file is recognised however it was renamed or touched, and
+// neither a compiler upgrade nor a different --max-errors or --max-nesting
+// reads stale entries.
+//
+// An entry holds the file's AST (ast_serialization.h) and its diagnostics,
+// which is all the driver needs from a hit. Entries are written to a
+// temporary file and renamed into place, so concurrent writers, including
+// other processes sharing the directory, never expose a partial entry. Hits are memory-mapped and
+// checksummed before use; a damaged entry counts as a miss and is deleted.
+//
+// The directory is kept under a size limit by trim(), which evicts the
+// least recently used entries (a hit refreshes its entry's mtime).
+
+struct CacheCounters {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t stores = 0;
+    size_t evictions = 0;
+};
+
+// A mapped cache hit.
+class CacheEntry {
+public:
+    // nullptr if the entry was stored without a program.
+    std::unique_ptr<Program> program() const;
+    std::vector<Diagnostic> diagnostics() const;
+
+private:
+    friend class CompileCache;
+
+    std::shared_ptr<const SourceBuffer> file;
+    std::string_view astSection;
+    std::string_view diagnosticSection;
+};
+
+class CompileCache {
+public:
+    static constexpr uint64_t DefaultLimit = 512ull << 20;
+
+    // Creates `directory` if needed. If that fails the cache stays disabled:
+    // every lookup misses and nothing is stored.
+    explicit CompileCache(std::string directory, uint64_t limitBytes = DefaultLimit);
+
+    CompileCache(const CompileCache&) = delete;
+    CompileCache& operator=(const CompileCache&) = delete;
+
+    bool enabled() const { return usable; }
+    const std::string& directory() const { return root; }
+
+    static ContentHash keyFor(std::string_view source, const CompileOptions& options = {});
+
+    // Safe to call from several threads at once.
+    std::unique_ptr<CacheEntry> find(const ContentHash& key);
+    void store(const ContentHash& key, const Program* program, const std::vector<Diagnostic>& diagnostics);
+
+    // Evicts least recently used entries until the directory holds at most
+    // the limit, leaving some headroom so that the next run does not have
+    // to evict again straight away. Returns the number of entries removed.
+    size_t trim();
+
+    CacheCounters counters() const;
+
+private:
+    std::string pathFor(const ContentHash& key) const;
+
+    std::string root;
+    uint64_t limit;
+    bool usable = false;
+    std::atomic<size_t> hits{0};
+    std::atomic<size_t> misses{0};
+    std::atomic<size_t> stores{0};
+    std::atomic<size_t> evictions{0};
+    std::atomic<uint64_t> temporaryId{0};
+};
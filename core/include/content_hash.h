@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// XXH64 (xxHash, 64-bit variant). Not cryptographic; fast enough that hashing
+// a source file costs a fraction of lexing it. Produces the reference
+// implementation's values on little-endian hosts.
+uint64_t xxhash64(const void* data, size_t size, uint64_t seed = 0);
+
+inline uint64_t xxhash64(std::string_view text, uint64_t seed = 0) {
+    return xxhash64(text.data(), text.size(), seed);
+}
+
+// 128-bit content address built from two independently seeded XXH64 runs,
+// so accidental collisions are out of the question for a build cache.
+struct ContentHash {
+    uint64_t high = 0;
+    uint64_t low = 0;
+
+    // 32 lowercase hex digits.
+    std::string hex() const;
+
+    friend bool operator==(const ContentHash& a, const ContentHash& b) { return a.high == b.high && a.low == b.low; }
+    friend bool operator!=(const ContentHash& a, const ContentHash& b) { return !(a == b); }
+};
+
+// `salt` is mixed into both halves (e.g. the compiler version), so the same
+// bytes hash differently under a different salt.
+ContentHash contentHash(std::string_view bytes, std::string_view salt = {});
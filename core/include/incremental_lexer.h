@@ -0,0 +1,135 @@
+#pragma once
+#include "arena.h"
+#include "lexer.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// The token stream of one editable document, kept up to date across text
+// edits without re-lexing the whole text.
+//
+// Every token remembers the lexer checkpoint it was lexed from. An edit
+// re-lexes from the last checkpoint the edit cannot have influenced and
+// stops as soon as the new lexer reaches an old checkpoint past the edit in
+// the same state; everything after that is reused. The result is always
+// identical to lexing the new text from scratch: tokens() and errors() match
+// Lexer::tokenize() and Lexer::errors() field for field.
+//
+// Tokens live in a gap buffer positioned at the last edit. Entries after the
+// gap store their offset, line and error count relative to the end of the
+// document, so an edit shifts nothing it did not re-lex and consecutive
+// keystrokes in one place cost the same however long the file is.
+class IncrementalLexer {
+public:
+    // What the last edit cost: tokens [firstToken, firstToken + relexed) are
+    // new, `replaced` old ones were dropped, and the rest were reused.
+    struct EditStats {
+        size_t firstToken = 0;
+        size_t replaced = 0;
+        size_t relexed = 0;
+    };
+
+    explicit IncrementalLexer(std::string text = {});
+    IncrementalLexer(const IncrementalLexer&) = delete;
+    IncrementalLexer& operator=(const IncrementalLexer&) = delete;
+
+    // Replaces the whole text and lexes it from scratch.
+    void reset(std::string text);
+
+    // Replaces `removed` bytes at byte `offset` with `inserted`. Offsets past
+    // the end are clamped.
+    EditStats edit(size_t offset, size_t removed, std::string_view inserted);
+
+    // Replaces the whole text with `text` as a single edit of the range
+    // between their common prefix and suffix, e.g. for a file reloaded from
+    // disk or a full-document LSP sync.
+    EditStats assign(std::string_view text);
+
+    std::string_view text() const { return source; }
+    size_t size() const { return entries.size() - (gapEnd - gapStart); }
+    // Token views point into text() or into this object and stay valid until
+    // the next edit. tokens() builds the whole stream and costs O(size()).
+    Token token(size_t index) const;
+    std::vector<Token> tokens() const;
+    const std::vector<LexError>& errors() const { return errorTable; }
+
+    // Byte offset of the first byte of 1-based `line`, or text().size() if
+    // the text has fewer lines.
+    size_t lineOffset(size_t line) const;
+    // Line and column of a token or error offset in the current text. Like
+    // lineOffset(), it costs one token's worth of text, not the file's.
+    SourceLocation locate(size_t offset) const;
+
+private:
+    // The lexer checkpoint in front of a token, the line it is on, the number
+    // of errors reported before it, and the token relative to that point.
+    // position, line and errorsBefore are counted back from the document's
+    // end behind the gap. Lines are only kept for lineOffset() and locate();
+    // tokens carry offsets.
+    struct Entry {
+        uint32_t position;
+        uint32_t line;
+        uint32_t errorsBefore;
+        uint32_t snapshot;          // mode stack, interned in `snapshots`
+        TokenType type;
+        Keyword keyword;
+        bool external;              // value is externalValues[valueOffset]
+        Symbol symbol;
+        uint32_t valueOffset;       // from `position`
+        uint32_t valueLength;
+        uint32_t tokenOffset;       // from `position`
+        uint32_t errorOffset;       // from `errorsBefore`, or Token::NoError
+    };
+
+    // An entry's checkpoint with absolute values.
+    struct Boundary {
+        size_t position;
+        size_t line;
+        size_t errorsBefore;
+        uint32_t snapshot;
+    };
+
+    const Entry& entry(size_t index) const {
+        return entries[index < gapStart ? index : index + (gapEnd - gapStart)];
+    }
+    Boundary boundary(size_t index) const;
+    // First token whose checkpoint lies after `position`.
+    size_t upperBound(size_t position) const;
+    void moveGap(size_t index);
+
+    uint32_t internSnapshot(const Lexer& lexer);
+    LexerCheckpoint checkpointAt(const Boundary& boundary) const;
+    // Lexes the current text from `from` (on line `fromLine`) until the lexer
+    // is back in step with an old boundary past the edited range
+    // [.., oldEnd) -> [.., newEnd) and returns that boundary's index, or
+    // size() at EOF.
+    size_t relex(const LexerCheckpoint& from, size_t fromLine, size_t errorBase, size_t first, size_t newEnd,
+                 size_t oldEnd, std::ptrdiff_t delta, std::vector<Entry>& newEntries,
+                 std::vector<LexError>& newErrors);
+
+    std::string source;
+    std::vector<Entry> entries;
+    size_t gapStart = 0;
+    size_t gapEnd = 0;
+    // The document end that entries behind the gap are counted back from.
+    size_t endPosition = 0;
+    size_t endLine = 1;
+    size_t endErrors = 0;
+    std::vector<LexError> errorTable;
+
+    // Token text that is not a slice of `source` (escape-processed strings,
+    // fixed punctuation), one copy per distinct value. Only grows; reset()
+    // starts it afresh.
+    Arena strings;
+    std::vector<std::string_view> externalValues;
+    std::unordered_map<std::string_view, uint32_t> externalIds;
+    // Mode stacks with the current mode appended, as seen between tokens.
+    std::vector<std::vector<LexerState>> snapshots;
+    std::map<std::vector<LexerState>, uint32_t> snapshotIds;
+    std::vector<LexerState> scratchSnapshot;
+    uint32_t lastSnapshot = 0;
+};
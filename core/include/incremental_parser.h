@@ -0,0 +1,50 @@
+#pragma once
+#include "ast_complete.h"
+#include "incremental_lexer.h"
+#include "parser.h"
+#include <memory>
+#include <vector>
+
+// Re-parses an IncrementalLexer's document after edits, reusing top-level
+// components and functions from the previous parse.
+//
+// Every component and function that parsed without errors is remembered
+// with its token span. Edits reported through noteEdit() mark the spans
+// they touch (plus one token of parser lookahead) dirty and shift the rest.
+// On the next parse(), whenever the parser reaches the start of a clean span
+// the old subtree is moved into the new Program and the parser skips to the
+// span's end; everything else is parsed as usual. The resulting Program and
+// errors() are the same as a full parse of the current tokens.
+class IncrementalParser {
+public:
+    struct Stats {
+        size_t reused = 0;   // top-level subtrees carried over
+        size_t parsed = 0;   // top-level items parsed
+    };
+
+    // Records an edit applied to the document since the last parse().
+    void noteEdit(const IncrementalLexer::EditStats& edit);
+    // Forgets the previous parse; the next parse() starts from scratch.
+    void invalidate();
+
+    const Program& parse(const IncrementalLexer& document);
+
+    const Program* program() const { return current.get(); }
+    const std::vector<ParseError>& errors() const { return diagnostics; }
+    Stats lastStats() const { return stats; }
+
+private:
+    struct Item {
+        size_t begin;        // token index of `component` / `function`
+        size_t end;          // one past the closing brace
+        uint32_t offset;     // of the first token, when last parsed
+        bool isFunction;
+        size_t slot;         // index in Program::components or ::functions
+        bool dirty;
+    };
+
+    std::unique_ptr<Program> current;
+    std::vector<Item> items;
+    std::vector<ParseError> diagnostics;
+    Stats stats;
+};
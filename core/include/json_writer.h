@@ -0,0 +1,97 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Streaming JSON writer shared by the AST and token dumps. Values are
+// appended to one buffer as they are written, with no intermediate strings
+// per field or per node, so the cost is linear in the output size.
+//
+// Writing to a string fills that string. Writing to a file descriptor keeps
+// a private buffer and hands it to write() whenever it grows past
+// FlushThreshold, so memory stays bounded however large the dump is.
+//
+// The writer inserts commas, newlines and indentation itself; callers only
+// say what comes next:
+//
+//     json.beginObject().field("name", name).key("children").beginArray();
+//     ...
+//     json.endArray().endObject();
+//
+// Keys and strings are escaped as JSON requires. Bytes from 0x80 upwards
+// are copied as they are, so UTF-8 text stays UTF-8.
+class JsonWriter {
+public:
+    enum class Style {
+        Pretty,    // one member per line, two-space indent
+        Compact    // no whitespace at all
+    };
+
+    static constexpr size_t FlushThreshold = 1 << 20;
+
+    explicit JsonWriter(std::string& out, Style style = Style::Pretty);
+    explicit JsonWriter(int fd, Style style = Style::Pretty);
+    // Flushes whatever is still buffered for a file descriptor.
+    ~JsonWriter();
+
+    JsonWriter(const JsonWriter&) = delete;
+    JsonWriter& operator=(const JsonWriter&) = delete;
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+    JsonWriter& key(std::string_view name);
+
+    JsonWriter& value(std::string_view text);
+    JsonWriter& value(const char* text) { return value(std::string_view(text)); }
+    JsonWriter& value(const std::string& text) { return value(std::string_view(text)); }
+    JsonWriter& value(bool flag);
+    JsonWriter& value(double number);   // non-finite numbers are written as null
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+    JsonWriter& value(T number) {
+        if constexpr (std::is_signed_v<T>) return integer(static_cast<int64_t>(number));
+        else return unsignedInteger(static_cast<uint64_t>(number));
+    }
+    JsonWriter& null();
+
+    template <typename T>
+    JsonWriter& field(std::string_view name, const T& v) {
+        key(name);
+        return value(v);
+    }
+
+    // Pushes buffered output to the file descriptor. Returns false once any
+    // write has failed; output after that is dropped. For a string target
+    // this does nothing and returns true.
+    bool flush();
+    bool failed() const { return writeFailed; }
+    // Everything written so far, flushed or not.
+    uint64_t bytesWritten() const { return flushed + out.size(); }
+
+private:
+    JsonWriter& integer(int64_t number);
+    JsonWriter& unsignedInteger(uint64_t number);
+    void beforeValue();
+    void newline(size_t depth);
+    void close(char bracket);
+    void maybeFlush() {
+        if (fd >= 0 && out.size() >= FlushThreshold) flush();
+    }
+
+    std::string own;
+    std::string& out;
+    int fd = -1;
+    Style style;
+    uint64_t flushed = 0;
+    bool writeFailed = false;
+    bool afterKey = false;
+    // One entry per open object or array: whether it has members yet.
+    std::vector<bool> open;
+};
+
+// Appends `text` as the body of a JSON string (no surrounding quotes).
+void appendJsonEscaped(std::string& out, std::string_view text);
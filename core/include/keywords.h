@@ -0,0 +1,125 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Reserved words of the language. Keyword tokens carry one of these in
+// Token::keyword so the parser can switch on it instead of comparing text.
+enum class Keyword : uint8_t
+{
+    NotKeyword,
+
+    Async, Component, Import, Extern, For, If, Else, While,
+    Return, Break, Continue, Yield, Await, Throw, Try, Catch, Finally,
+
+    Render, Script, Function, Fn, Method,
+
+    Type, Interface, Struct, Enum, Union,
+
+    From, Export, Use, Pub, Mod, Namespace,
+
+    Move, Copy, Ref, Deref, Owned, Borrowed, Shared, Weak,
+
+    True, False, Null, None, Undefined,
+
+    This, Super, Self, SelfType, Match, Case, Default,
+    Let, Const, Var, New, Delete, As, Is, Typeof,
+    Print, Println,
+
+    Count
+};
+
+// Compile-time perfect hash over the keyword spellings. lookupKeyword() costs
+// one hash, one table load and at most one string compare; nothing is built
+// or allocated at runtime.
+namespace keyword_table {
+
+    struct Entry {
+        std::string_view text;
+        Keyword keyword;
+    };
+
+    // Same order as the Keyword enum.
+    inline constexpr Entry entries[] = {
+        {"async", Keyword::Async}, {"component", Keyword::Component}, {"import", Keyword::Import},
+        {"extern", Keyword::Extern}, {"for", Keyword::For}, {"if", Keyword::If},
+        {"else", Keyword::Else}, {"while", Keyword::While}, {"return", Keyword::Return},
+        {"break", Keyword::Break}, {"continue", Keyword::Continue}, {"yield", Keyword::Yield},
+        {"await", Keyword::Await}, {"throw", Keyword::Throw}, {"try", Keyword::Try},
+        {"catch", Keyword::Catch}, {"finally", Keyword::Finally},
+        {"render", Keyword::Render}, {"script", Keyword::Script}, {"function", Keyword::Function},
+        {"fn", Keyword::Fn}, {"method", Keyword::Method},
+        {"type", Keyword::Type}, {"interface", Keyword::Interface}, {"struct", Keyword::Struct},
+        {"enum", Keyword::Enum}, {"union", Keyword::Union},
+        {"from", Keyword::From}, {"export", Keyword::Export}, {"use", Keyword::Use},
+        {"pub", Keyword::Pub}, {"mod", Keyword::Mod}, {"namespace", Keyword::Namespace},
+        {"move", Keyword::Move}, {"copy", Keyword::Copy}, {"ref", Keyword::Ref},
+        {"deref", Keyword::Deref}, {"owned", Keyword::Owned}, {"borrowed", Keyword::Borrowed},
+        {"shared", Keyword::Shared}, {"weak", Keyword::Weak},
+        {"true", Keyword::True}, {"false", Keyword::False}, {"null", Keyword::Null},
+        {"none", Keyword::None}, {"undefined", Keyword::Undefined},
+        {"this", Keyword::This}, {"super", Keyword::Super}, {"self", Keyword::Self},
+        {"Self", Keyword::SelfType}, {"match", Keyword::Match}, {"case", Keyword::Case},
+        {"default", Keyword::Default}, {"let", Keyword::Let}, {"const", Keyword::Const},
+        {"var", Keyword::Var}, {"new", Keyword::New}, {"delete", Keyword::Delete},
+        {"as", Keyword::As}, {"is", Keyword::Is}, {"typeof", Keyword::Typeof},
+        {"print", Keyword::Print}, {"println", Keyword::Println},
+    };
+
+    inline constexpr size_t EntryCount = sizeof(entries) / sizeof(entries[0]);
+    inline constexpr size_t MinLength = 2;
+    inline constexpr size_t MaxLength = 9;
+    inline constexpr size_t TableSize = 256;
+
+    // Multipliers were searched offline so every keyword lands in its own
+    // slot; the static_assert below fires if a new keyword collides.
+    constexpr size_t hash(std::string_view word) {
+        return (word.size() * 2 + static_cast<unsigned char>(word[0]) * 35 +
+                static_cast<unsigned char>(word[1]) * 21 +
+                static_cast<unsigned char>(word[word.size() - 1])) & (TableSize - 1);
+    }
+
+    struct Table {
+        Keyword slots[TableSize] = {};
+        bool collision = false;
+    };
+
+    constexpr Table build() {
+        Table table;
+        for (size_t i = 0; i < EntryCount; ++i) {
+            size_t slot = hash(entries[i].text);
+            if (table.slots[slot] != Keyword::NotKeyword) table.collision = true;
+            table.slots[slot] = entries[i].keyword;
+        }
+        return table;
+    }
+
+    constexpr bool inEnumOrder() {
+        for (size_t i = 0; i < EntryCount; ++i) {
+            if (static_cast<size_t>(entries[i].keyword) != i + 1) return false;
+        }
+        return EntryCount + 1 == static_cast<size_t>(Keyword::Count);
+    }
+
+    inline constexpr Table table = build();
+
+    static_assert(!table.collision, "keyword hash collision; pick new multipliers for hash()");
+    static_assert(inEnumOrder(), "entries[] must list every Keyword in enum order");
+}
+
+constexpr std::string_view keywordText(Keyword keyword) {
+    size_t index = static_cast<size_t>(keyword);
+    return index == 0 || index > keyword_table::EntryCount ? std::string_view() : keyword_table::entries[index - 1].text;
+}
+
+constexpr Keyword lookupKeyword(std::string_view word) {
+    if (word.size() < keyword_table::MinLength || word.size() > keyword_table::MaxLength) {
+        return Keyword::NotKeyword;
+    }
+    Keyword candidate = keyword_table::table.slots[keyword_table::hash(word)];
+    return keywordText(candidate) == word ? candidate : Keyword::NotKeyword;
+}
+
+static_assert(lookupKeyword("component") == Keyword::Component);
+static_assert(lookupKeyword("Self") == Keyword::SelfType);
+static_assert(lookupKeyword("components") == Keyword::NotKeyword);
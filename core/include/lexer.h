@@ -1,10 +1,36 @@
 #pragma once
 #include "token.h"
+#include "token_buffer.h"
+#include "arena.h"
+#include "source_buffer.h"
+#include "lexer_trace.h"
+#include <memory>
 #include <vector>
 #include <string>
 #include <optional>
 #include <cstdint>
 #include <stack>
+#include <iterator>
+#include <cstddef>
+
+class WorkStealingPool;
+
+// Side-table entry for a token produced with an error; Token::errorIndex
+// points into Lexer::errors().
+struct LexError {
+    uint32_t offset;
+    std::string message;
+};
+
+// A point between two tokens from which lexing can resume: the next byte
+// to read, and the lexer's mode with the modes it will return to (innermost
+// last). A Lexer built from a checkpoint produces the same tokens the lexer
+// it was taken from would have.
+struct LexerCheckpoint {
+    size_t position = 0;
+    LexerState state = LexerState::Normal;
+    std::vector<LexerState> stateStack;
+};
 
 class Lexer {
     // Processes single-line and multi-line comments and emits a Comment token.
@@ -15,13 +41,26 @@ private:
     uint32_t peekCodepoint() const;
     uint32_t peekAdvanceCodepoint() const;
     uint32_t advanceCodepoint();
-    std::string input;
+    std::shared_ptr<const SourceBuffer> source;
+    std::string_view input;
+    Arena strings;
+    std::string scratch;
+    std::vector<LexError> errorTable;
+    LexerTrace trace;
     size_t position;
-    size_t line;
-    size_t column;
     LexerState state;
     std::vector<LexerState> stateStack;
     bool isUTF8Error;
+    bool finished;
+    // Lexers that produced chunks for tokenizeParallel(); they own the arena
+    // text some of the returned tokens point into.
+    std::vector<std::unique_ptr<Lexer>> chunkLexers;
+
+    // True between tokens when no ALTX/expression mode is open, i.e. where a
+    // fresh Lexer would behave exactly like this one.
+    bool atTopLevel() const { return state == LexerState::Normal && stateStack.empty(); }
+    // The offset the next token would start at, as tokens carry it.
+    uint32_t here() const { return static_cast<uint32_t>(position); }
 
     
     char peek() const;
@@ -32,6 +71,8 @@ private:
     void enterState(LexerState newState);
     void exitState();
     void skipWhitespace();
+    // Steps over bytes a bytescan function has already checked: ASCII, no '\n'.
+    void advanceRun(size_t length);
 
     
     bool isDigit(char c) const;
@@ -56,7 +97,9 @@ private:
     Token nextToken();
 
     
-    Token createErrorToken(const std::string& lexeme, const std::string& message);
+    Token createErrorToken(std::string_view lexeme, const std::string& message);
+    Token createErrorToken(TokenType type, std::string_view lexeme, uint32_t errOffset, const std::string& message);
+    std::string_view sourceSlice(size_t start) const;
     void recoverFromError();
     Token safeNextToken();
 
@@ -66,5 +109,76 @@ private:
 
 public:
     explicit Lexer(const std::string& source);
+    // Lexes straight out of the buffer (e.g. a memory-mapped file) without
+    // copying it.
+    explicit Lexer(std::shared_ptr<const SourceBuffer> source);
+    // Resumes lexing `source` at a checkpoint taken from an earlier lexer of
+    // the same bytes (or of bytes identical from the checkpoint onwards).
+    Lexer(std::shared_ptr<const SourceBuffer> source, const LexerCheckpoint& from);
+    Lexer(const Lexer&) = delete;
+    Lexer& operator=(const Lexer&) = delete;
+
+    LexerCheckpoint checkpoint() const { return {position, state, stateStack}; }
+    // The parts of checkpoint() that can change between tokens, without the
+    // copy; IncrementalLexer compares them after every token.
+    size_t offset() const { return position; }
+    LexerState currentState() const { return state; }
+    const std::vector<LexerState>& enclosingStates() const { return stateStack; }
+
+    // Lexes the next token on demand. The last real token is followed by
+    // one EOFToken; after that every call returns EOFToken again.
+    Token next();
+
+    // Convenience wrapper: every token up to and including EOFToken.
     std::vector<Token> tokenize();
+    // The same tokens, stored column-wise with their source offsets, for
+    // Parser(TokenBuffer).
+    TokenBuffer tokenizeBuffer();
+
+    static constexpr size_t DefaultParallelChunk = 256 * 1024;
+
+    // Same tokens and errors() as tokenize(), but large inputs are split at
+    // top-level `component` declarations and the pieces lexed on `pool`.
+    // Inputs with no usable split points, or smaller than two chunks, are
+    // lexed sequentially. Must not be called from a task running on `pool`.
+    std::vector<Token> tokenizeParallel(WorkStealingPool& pool, size_t minChunkBytes = DefaultParallelChunk);
+
+    // Input iterator over next(): `for (const Token& t : lexer)` visits the
+    // same tokens tokenize() would return, without collecting them.
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Token;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Token*;
+        using reference = const Token&;
+
+        Iterator() : lexer(nullptr), current(TokenType::EOFToken, "", 0) {}
+        explicit Iterator(Lexer& source) : lexer(&source), current(source.next()) {}
+
+        reference operator*() const { return current; }
+        pointer operator->() const { return &current; }
+        Iterator& operator++();
+        bool operator==(const Iterator& other) const { return lexer == other.lexer; }
+        bool operator!=(const Iterator& other) const { return lexer != other.lexer; }
+
+    private:
+        Lexer* lexer;
+        Token current;
+    };
+
+    Iterator begin() { return Iterator(*this); }
+    Iterator end() { return Iterator(); }
+
+    // Opt-in tracing of this lexer's comments and errors (Debug) or of every
+    // token (Verbose). Output is buffered and flushed when tokenize() returns;
+    // the sink must outlive the lexer.
+    void setTrace(std::ostream& sink, TraceLevel level);
+
+    const std::vector<LexError>& errors() const { return errorTable; }
+    // Line starts of the source, for resolving token and error offsets.
+    const LineTable& lines() const { return source->lines(); }
+    const LexError* errorFor(const Token& token) const {
+        return token.hasError() ? &errorTable[token.errorIndex] : nullptr;
+    }
 };
\ No newline at end of file
@@ -0,0 +1,98 @@
+#pragma once
+#include "line_table.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// Opt-in tracing for a single Lexer. Events are formatted into an in-memory
+// buffer and written to the lexer's sink in large chunks (and on flush or
+// destruction), so tracing never costs a syscall per event.
+//
+// Levels are checked twice: against ALTERION_LEXER_TRACE_MAX_LEVEL at compile
+// time, which lets a build drop tracing entirely, and against the level the
+// lexer was given at runtime. With tracing off, each trace point is a single
+// well-predicted branch on a byte the lexer already has in cache.
+enum class TraceLevel : uint8_t
+{
+    Off,
+    Debug,    // comments, errors
+    Verbose   // every token and state change (enter, exit, switch)
+};
+
+#ifndef ALTERION_LEXER_TRACE_MAX_LEVEL
+#define ALTERION_LEXER_TRACE_MAX_LEVEL 2
+#endif
+
+class LexerTrace {
+public:
+    static constexpr TraceLevel MaxLevel = static_cast<TraceLevel>(ALTERION_LEXER_TRACE_MAX_LEVEL);
+    static constexpr size_t FlushThreshold = 64 * 1024;
+
+    LexerTrace() = default;
+    LexerTrace(const LexerTrace&) = delete;
+    LexerTrace& operator=(const LexerTrace&) = delete;
+    ~LexerTrace() { flush(); }
+
+    // The sink must outlive the trace (and so the Lexer that owns it).
+    void open(std::ostream& out, TraceLevel traceLevel) {
+        flush();
+        sink = &out;
+        level = traceLevel;
+    }
+
+    bool enabled(TraceLevel eventLevel) const {
+        if constexpr (MaxLevel == TraceLevel::Off) {
+            return false;
+        } else {
+            return eventLevel <= MaxLevel && eventLevel <= level;
+        }
+    }
+
+    // One line per event: `<line>:<column> <event> "<text>"`, with control
+    // characters in the text escaped so every event stays on one line.
+    void record(std::string_view event, std::string_view text, SourceLocation at) {
+        buffer += std::to_string(at.line);
+        buffer += ':';
+        buffer += std::to_string(at.column);
+        buffer += ' ';
+        buffer += event;
+        buffer += " \"";
+        for (char c : text) {
+            switch (c) {
+                case '\n': buffer += "\\n"; break;
+                case '\r': buffer += "\\r"; break;
+                case '\t': buffer += "\\t"; break;
+                case '"': buffer += "\\\""; break;
+                case '\\': buffer += "\\\\"; break;
+                default: buffer += c; break;
+            }
+        }
+        buffer += "\"\n";
+        if (buffer.size() >= FlushThreshold) flush();
+    }
+
+    void flush() {
+        if (sink && !buffer.empty()) {
+            sink->write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            sink->flush();
+        }
+        buffer.clear();
+    }
+
+private:
+    TraceLevel level = TraceLevel::Off;
+    std::ostream* sink = nullptr;
+    std::string buffer;
+};
+
+// Formats and records only when the level is enabled, so the arguments
+// (including the line-table lookup for `location`) are not evaluated on the
+// disabled path.
+#define LEXER_TRACE(trace, eventLevel, event, text, location)          \
+    do {                                                               \
+        if ((trace).enabled(eventLevel)) {                             \
+            (trace).record((event), (text), (location));               \
+        }                                                              \
+    } while (0)
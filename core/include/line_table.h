@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// A resolved source position: 1-based line, and 1-based column counted in
+// codepoints (an invalid UTF-8 byte counts as one), as the lexer reports.
+struct SourceLocation {
+    uint32_t line = 0;
+    uint32_t column = 0;
+};
+
+// Tokens, nodes and diagnostics carry a 32-bit byte offset into their source;
+// line and column are worked out here, only when something is shown to a
+// person. The table holds the offset where each line starts, found in one
+// vectorized pass over the text (bytescan::appendLineStarts), so locate() is
+// a binary search plus a codepoint count within one line.
+//
+// The table keeps a view of the text it was built from.
+class LineTable {
+public:
+    // The offset of something with no place in the source (a synthesized
+    // node); it locates to line 0, column 0.
+    static constexpr uint32_t NoOffset = UINT32_MAX;
+
+    explicit LineTable(std::string_view text);
+
+    // `offset` may be text.size() (the EOF token's position).
+    SourceLocation locate(uint32_t offset) const;
+
+    // Column of `offset` on the line of `text` starting at `lineStart`.
+    static uint32_t columnOf(std::string_view text, size_t lineStart, size_t offset);
+
+    size_t lineCount() const { return starts.size(); }
+    // Offset of the first byte of 1-based `line`.
+    uint32_t lineStart(size_t line) const { return starts[line - 1]; }
+
+private:
+    std::string_view text;
+    std::vector<uint32_t> starts;
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include "token.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Binary operator precedence and associativity, indexed by TokenType. The
+// parser's expression loop climbs this table (Pratt parsing) instead of
+// walking one function per precedence level, so each operator token costs a
+// single table load.
+enum class Associativity : uint8_t
+{
+    Left,
+    Right
+};
+
+struct BinaryOperator {
+    uint8_t precedence = 0;   // 0: not a binary operator
+    Associativity associativity = Associativity::Left;
+};
+
+namespace operator_table {
+
+    struct Entry {
+        TokenType type;
+        BinaryOperator info;
+        std::string_view text;
+    };
+
+    // Loosest binding first.
+    inline constexpr Entry entries[] = {
+        {TokenType::LogicalOr,    {1, Associativity::Left}, "||"},
+        {TokenType::LogicalAnd,   {2, Associativity::Left}, "&&"},
+        {TokenType::Equal,        {3, Associativity::Left}, "=="},
+        {TokenType::NotEqual,     {3, Associativity::Left}, "!="},
+        {TokenType::Less,         {4, Associativity::Left}, "<"},
+        {TokenType::LessEqual,    {4, Associativity::Left}, "<="},
+        {TokenType::Greater,      {4, Associativity::Left}, ">"},
+        {TokenType::GreaterEqual, {4, Associativity::Left}, ">="},
+        {TokenType::Plus,         {5, Associativity::Left}, "+"},
+        {TokenType::Minus,        {5, Associativity::Left}, "-"},
+        {TokenType::Multiply,     {6, Associativity::Left}, "*"},
+        {TokenType::Divide,       {6, Associativity::Left}, "/"},
+        {TokenType::Modulo,       {6, Associativity::Left}, "%"},
+        {TokenType::Power,        {7, Associativity::Right}, "**"},
+    };
+
+    inline constexpr size_t TableSize = 128;
+
+    struct Table {
+        BinaryOperator slots[TableSize] = {};
+        bool inRange = true;
+    };
+
+    constexpr Table build() {
+        Table table;
+        for (const Entry& entry : entries) {
+            size_t index = static_cast<size_t>(entry.type);
+            if (index >= TableSize) {
+                table.inRange = false;
+                continue;
+            }
+            table.slots[index] = entry.info;
+        }
+        return table;
+    }
+
+    inline constexpr Table table = build();
+
+    static_assert(table.inRange, "TokenType grew past operator_table::TableSize");
+}
+
+constexpr BinaryOperator binaryOperator(TokenType type) {
+    size_t index = static_cast<size_t>(type);
+    return index < operator_table::TableSize ? operator_table::table.slots[index] : BinaryOperator{};
+}
+
+// Spelling of an operator TokenType, for diagnostics and printing.
+constexpr std::string_view operatorText(TokenType type) {
+    for (const auto& entry : operator_table::entries) {
+        if (entry.type == type) return entry.text;
+    }
+    switch (type) {
+        case TokenType::LogicalNot: return "!";
+        case TokenType::Equals: return "=";
+        case TokenType::PlusAssign: return "+=";
+        case TokenType::MinusAssign: return "-=";
+        case TokenType::MultiplyAssign: return "*=";
+        case TokenType::DivideAssign: return "/=";
+        case TokenType::ModuloAssign: return "%=";
+        case TokenType::Increment: return "++";
+        case TokenType::Decrement: return "--";
+        default: return {};
+    }
+}
+
+static_assert(binaryOperator(TokenType::Multiply).precedence > binaryOperator(TokenType::Plus).precedence);
+static_assert(binaryOperator(TokenType::Power).associativity == Associativity::Right);
+static_assert(binaryOperator(TokenType::Identifier).precedence == 0);
@@ -0,0 +1,195 @@
+#pragma once
+#include "token.h"
+#include "ast_complete.h"
+#include "lexer.h"
+#include "token_stream.h"
+#include <vector>
+#include <string>
+#include <memory>
+#include <initializer_list>
+
+// `offset` is a byte offset into the parsed source; resolve it with
+// SourceBuffer::lines() (or Lexer::lines()) for display.
+struct ParseError {
+    std::string message;
+    uint32_t offset;
+
+    ParseError(std::string msg, uint32_t o) : message(std::move(msg)), offset(o) {}
+};
+
+// A function or method body skimmed by the parser (see
+// Parser::setSkimBodies): its tokens, braces included, are kept as they were
+// and parsed only when block() is first called. Until then the node has no
+// children, so forEachChild() and the AST serializer see a leaf.
+//
+// The tokens are views into the Lexer's source buffer, so the Lexer must stay
+// alive until every body that is going to be parsed has been. The body is
+// parsed under the error and nesting limits of the parser that skimmed it.
+struct DeferredBlock : Statement {
+    TokenBuffer tokens;   // emptied once parsed
+
+    explicit DeferredBlock(uint32_t at = NoOffset) : Statement(ASTNodeType::Block, at) {}
+
+    // The body's statements, parsing them on the first call. Not safe to
+    // call from several threads at once.
+    BlockStatement& block();
+    bool isParsed() const { return parsed != nullptr; }
+    // Syntax errors found by block(), in source order.
+    const std::vector<ParseError>& errors() const { return diagnostics; }
+
+private:
+    friend class Parser;
+
+    // Parses the tokens, reporting a missing '}' with `closeMessage`.
+    void parse(const std::string& closeMessage);
+
+    std::unique_ptr<BlockStatement> parsed;
+    std::vector<ParseError> diagnostics;
+    size_t errorLimit = 0;     // 0 = no limit
+    size_t nestingLimit = 0;   // 0 = the parser's default
+};
+
+// The statements of `function`'s body, whether it was parsed in place or
+// skimmed.
+BlockStatement& functionBody(Function& function);
+
+// Recursive-descent parser over the Lexer's token stream. Tokens are views
+// into the Lexer's source buffer, so the Lexer must stay alive while parsing.
+//
+// Syntax errors do not throw. The first error in a top-level item is
+// recorded and puts the parser in panic mode, where the token stream reads
+// as ended: every rule returns at once with what it has (an ErrorExpression
+// where an expression was missing) without reporting more. The item is kept,
+// and parsing resumes after synchronize() at the next statement boundary, so
+// a file with a thousand errors costs about what a clean one does.
+class Parser {
+public:
+    explicit Parser(std::vector<Token> tokens);
+    // Pulls tokens from the lexer as parsing proceeds; only the lookahead
+    // window is held in memory.
+    explicit Parser(Lexer& lexer);
+    // Reads an incrementally maintained token stream; see IncrementalParser.
+    explicit Parser(const IncrementalLexer& document);
+    // Reads the columns in place; lookahead checks touch only the type
+    // column. See Lexer::tokenizeBuffer().
+    explicit Parser(TokenBuffer tokens);
+    std::unique_ptr<Program> parse();
+
+    // Errors recovered from during parse(), in source order. Nothing is
+    // printed; drivers decide how and when to report them.
+    const std::vector<ParseError>& errors() const { return diagnostics; }
+
+    // Stops parsing once `limit` errors are recorded (0, the default, never
+    // stops); a final "too many errors" diagnostic marks where it stopped.
+    void setErrorLimit(size_t limit) { errorLimit = limit; }
+
+    // Skim mode, for consumers that need only the outline of a file
+    // (components, their methods, functions, imports and exports): function
+    // and method bodies are matched brace to brace without being parsed, and
+    // each becomes a DeferredBlock. Errors inside a body are reported by its
+    // DeferredBlock, not by errors().
+    void setSkimBodies(bool skim) { skimBodies = skim; }
+
+    static constexpr size_t DefaultNestingLimit = 1000;
+    // Tags nested more than `limit` deep, and expressions nested more than
+    // `limit` levels (brackets, unary operators, right-associative chains),
+    // are reported as errors instead of being parsed. Like any syntax error
+    // this ends the top-level item: the tags opened so far are kept, closed
+    // where they stand, and the rest of the component is skipped up to the
+    // next item synchronize() finds. Tag trees are parsed
+    // with an explicit stack and take any limit; expressions still recurse,
+    // about five calls per level. Destroying or walking the tree recurses
+    // too, so a much higher limit gives up that protection for them.
+    void setNestingLimit(size_t limit) { nestingLimit = limit; }
+
+private:
+    friend class IncrementalParser;
+    friend struct DeferredBlock;
+
+    TokenStream tokens;
+    std::vector<ParseError> diagnostics;
+    size_t errorLimit = 0;
+    // Set by error(); peek() then reports end of input until the top level
+    // recovers. With `halted` (the error limit was reached) it stays set.
+    bool panicking = false;
+    bool halted = false;
+    bool skimBodies = false;
+    size_t nestingLimit = DefaultNestingLimit;
+    size_t expressionDepth = 0;
+    Token endOfInput{TokenType::EOFToken, std::string_view(), LineTable::NoOffset};
+    // `in` is not reserved; for-in loops recognise it by symbol.
+    Symbol inSymbol = intern("in");
+
+    const Token& peek();
+    // Type of the current token (EOFToken while panicking), without
+    // building a Token.
+    TokenType peekType();
+    const Token& advance();
+    const Token& previous() const;
+    bool isAtEnd();
+    bool check(TokenType type);
+    bool checkNext(TokenType type);
+    bool match(std::initializer_list<TokenType> types);
+    bool checkKeyword(Keyword keyword);
+    // Consumes the keyword if it is next.
+    bool matchKeyword(Keyword keyword);
+    Token consume(TokenType type, const std::string& message);
+    Token consumeKeyword(Keyword keyword, const std::string& message);
+    bool checkOpenBrace();
+    bool checkCloseBrace();
+    bool matchOpenBrace();
+    Token consumeOpenBrace(const std::string& message);
+    Token consumeCloseBrace(const std::string& message);
+    // Records a diagnostic unless one is already pending, and panics.
+    void error(std::string message, uint32_t offset);
+    ExpressionPtr errorExpression();
+    void synchronize();
+
+    std::unique_ptr<Program> parseProgram();
+    // One top-level component, function, import, export or statement,
+    // appended to `program`. Errors are recorded and skipped past.
+    void parseTopLevel(Program& program);
+    ComponentPtr parseComponent();
+    std::vector<ASTNodePtr> parseALTXContent();
+    TagPtr parseTag();
+    // A tag's name, attributes and styles, through its '>' or '/>'.
+    TagPtr parseTagHead();
+    std::unique_ptr<Attribute> parseAttribute();
+    std::vector<StyleProperty> parseStyleProperty(std::string_view styleContent);
+    std::unique_ptr<TextContent> parseTextContent();
+    StatementPtr parseEmbeddedExpression();
+    StatementPtr parseImport();
+    std::vector<Symbol> parseImportList();
+    StatementPtr parseExport();
+    FunctionPtr parseFunction();
+    std::vector<Symbol> parseParameterList();
+    StatementPtr parseMethodDefinition();
+    // Skim mode: saves the body whose '{' was just consumed, up to its
+    // matching '}', as a DeferredBlock at `at`.
+    StatementPtr skimBody(uint32_t at, const std::string& closeMessage);
+    StatementPtr parseModifiedStatement();
+
+    StatementPtr parseStatement();
+    StatementPtr parseBlockStatement(const std::string& closeMessage = "Expected '}' after block");
+    StatementPtr parseIfStatement();
+    StatementPtr parseWhileStatement();
+    StatementPtr parseForStatement();
+    StatementPtr parseForInStatement();
+    StatementPtr parseReturnStatement();
+    StatementPtr parseTryStatement();
+    StatementPtr parseThrowStatement();
+    StatementPtr parseVariableDeclaration();
+    StatementPtr parseAssignment();
+
+    // Counts one level of expression nesting, or reports that the limit is
+    // reached and returns false. leaveExpression() undoes a successful call.
+    bool enterExpression();
+    void leaveExpression() { --expressionDepth; }
+    ExpressionPtr parseExpression();
+    ExpressionPtr parseBinary(int minPrecedence);
+    ExpressionPtr parseUnary();
+    ExpressionPtr parseCall();
+    ExpressionPtr parsePrimary();
+    ExpressionPtr parseArrayExpression();
+    ExpressionPtr parseObjectExpression();
+};
@@ -0,0 +1,131 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class JsonWriter;
+
+// Opt-in wall-clock timing of the front end's phases.
+//
+// PhaseTimer scopes sit around tokenize, parseProgram, parseComponent,
+// parseTag and serialization. They cost one relaxed atomic load and an
+// untaken branch until a PhaseTrace is installed; after that each scope
+// records a complete event, which the trace can write as Chrome trace-event
+// JSON (chrome://tracing, ui.perfetto.dev) or summarize per phase, per file
+// and per component.
+//
+//     PhaseTrace trace;
+//     PhaseTrace::install(&trace);
+//     compileFiles(files);
+//     PhaseTrace::install(nullptr);
+//     trace.printSummary(std::cerr);
+
+class PhaseTrace {
+public:
+    struct Event {
+        const char* name;     // static string: "lex", "parse", "parseTag", ...
+        std::string detail;   // component name, file path; may be empty
+        uint32_t file;        // index into files(), or NoFile
+        uint32_t thread;      // small id, in order of first use
+        int64_t start;        // ns since the trace was created
+        int64_t duration;     // ns
+        // Inside another open scope of the same name on this thread, so
+        // already part of that scope's time.
+        bool nested;
+    };
+
+    static constexpr uint32_t NoFile = UINT32_MAX;
+
+    PhaseTrace();
+    ~PhaseTrace();
+    PhaseTrace(const PhaseTrace&) = delete;
+    PhaseTrace& operator=(const PhaseTrace&) = delete;
+
+    // Starts (or, with nullptr, stops) recording into `trace`, process-wide.
+    // Swap only while no timed work is running.
+    static void install(PhaseTrace* trace);
+    static PhaseTrace* active() { return current.load(std::memory_order_relaxed); }
+
+    std::vector<Event> events() const;
+    std::vector<std::string> files() const;
+
+    // {"traceEvents": [...]} with one complete ("X") event per scope and a
+    // thread-name record per worker; args carry the file and detail.
+    void writeChromeTrace(JsonWriter& json) const;
+    // Total time per phase, then the `top` slowest files (with their lex,
+    // parse and serialize time) and components.
+    void printSummary(std::ostream& out, size_t top = 10) const;
+
+private:
+    friend class PhaseTimer;
+    friend class FileTimer;
+
+    static std::atomic<PhaseTrace*> current;
+
+    std::chrono::steady_clock::time_point origin;
+    mutable std::mutex mutex;
+    std::vector<Event> recorded;
+    std::vector<std::string> paths;
+
+    int64_t now() const;
+    uint32_t addFile(std::string_view path);
+    void append(std::vector<Event>& batch);
+};
+
+// Times the enclosing scope as one event named `name`, which must be a
+// string literal (or otherwise outlive the trace).
+class PhaseTimer {
+public:
+    explicit PhaseTimer(const char* name) {
+        if (PhaseTrace* trace = PhaseTrace::active()) begin(trace, name);
+    }
+    PhaseTimer(const char* name, std::string_view detail) {
+        if (PhaseTrace* trace = PhaseTrace::active()) {
+            begin(trace, name);
+            this->detail = detail;
+        }
+    }
+    ~PhaseTimer() {
+        if (trace != nullptr) end();
+    }
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+    // For details known only once the work has started, e.g. the name of the
+    // component being parsed.
+    void setDetail(std::string_view text) {
+        if (trace != nullptr) detail = text;
+    }
+
+private:
+    friend class FileTimer;
+
+    PhaseTrace* trace = nullptr;
+    const char* name = nullptr;
+    std::string detail;
+    int64_t start = 0;
+    bool nested = false;
+
+    void begin(PhaseTrace* active, const char* eventName);
+    void end();
+};
+
+// A "file" event for `path`; every timer this thread runs meanwhile is
+// attributed to that file in the summary.
+class FileTimer {
+public:
+    explicit FileTimer(std::string_view path);
+    ~FileTimer();
+    FileTimer(const FileTimer&) = delete;
+    FileTimer& operator=(const FileTimer&) = delete;
+
+private:
+    PhaseTimer timer;
+    uint32_t outerFile = PhaseTrace::NoFile;
+};
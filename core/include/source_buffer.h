@@ -0,0 +1,49 @@
+#pragma once
+#include "line_table.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+// Immutable bytes of one source file. Regular files are memory-mapped
+// read-only so the lexer works straight off the page cache; pipes, character
+// devices and stdin fall back to a buffered read. Tokens hold views into
+// text(), so the buffer is shared with every Lexer that reads it.
+class SourceBuffer {
+public:
+    // Offsets are 32-bit and LineTable::NoOffset is taken, so every offset up
+    // to and including EOF's must be below it.
+    static constexpr size_t MaxSize = LineTable::NoOffset - 1;
+
+    // Returns nullptr if the file cannot be opened or read, or is larger
+    // than MaxSize. "-" reads stdin.
+    static std::shared_ptr<const SourceBuffer> fromFile(const std::string& path);
+    static std::shared_ptr<const SourceBuffer> fromStdin();
+    static std::shared_ptr<const SourceBuffer> fromString(std::string text);
+    // Wraps bytes owned elsewhere without copying them. The caller keeps them
+    // alive and unchanged for as long as the buffer or any token is in use.
+    static std::shared_ptr<const SourceBuffer> borrow(std::string_view text);
+
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+    ~SourceBuffer();
+
+    std::string_view text() const { return view; }
+    size_t size() const { return view.size(); }
+    bool isMapped() const { return mapping != nullptr; }
+    // Line starts of text(), built on first use; safe to call from several
+    // threads at once.
+    const LineTable& lines() const;
+
+private:
+    SourceBuffer() = default;
+
+    static std::shared_ptr<const SourceBuffer> readStream(int fd);
+
+    std::string owned;
+    std::string_view view;
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+    mutable std::once_flag linesBuilt;
+    mutable std::unique_ptr<LineTable> lineTable;
+};
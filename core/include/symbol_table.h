@@ -0,0 +1,73 @@
+#pragma once
+#include "arena.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+// Interned name: identifiers, tag names and attribute names are stored once
+// process-wide and referred to by a 4-byte id, so comparing two names is an
+// integer compare. The default Symbol is the empty string.
+struct Symbol {
+    uint32_t id = 0;
+
+    bool empty() const { return id == 0; }
+    friend bool operator==(Symbol a, Symbol b) { return a.id == b.id; }
+    friend bool operator!=(Symbol a, Symbol b) { return a.id != b.id; }
+};
+
+// Process-wide, thread-safe string interner. Entries are never removed, so the
+// text of a symbol stays valid for the life of the process.
+//
+// The table is split into shards, each with its own lock, hash index and text
+// storage, so lexers on different threads rarely contend. Each thread also
+// keeps a small direct-mapped cache of recent lookups in front of the shards;
+// a hit there takes no lock at all. Looking up the text of a symbol never
+// locks either: the id encodes the shard and the slot, and slot storage is
+// allocated in fixed segments that never move once published.
+class SymbolTable {
+public:
+    static SymbolTable& global();
+
+    Symbol intern(std::string_view text);
+    std::string_view text(Symbol symbol) const;
+
+    // Number of distinct non-empty strings interned so far.
+    size_t size() const;
+
+    SymbolTable();
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+    ~SymbolTable();
+
+private:
+    static constexpr unsigned ShardBits = 4;
+    static constexpr size_t ShardCount = size_t(1) << ShardBits;
+    static constexpr unsigned SegmentBits = 12;
+    static constexpr size_t SegmentSize = size_t(1) << SegmentBits;
+    // Ids carry the slot index above the shard bits, which caps each shard
+    // at 2^28 entries; far more than MaxSegments * SegmentSize.
+    static constexpr size_t MaxSegments = 1024;
+
+    struct Shard {
+        mutable std::mutex mutex;
+        Arena storage;
+        // Open-addressed index into the slots: (index + 1), 0 when empty.
+        std::vector<uint32_t> index;
+        std::vector<uint32_t> hashes;
+        uint32_t count = 0;
+        std::array<std::atomic<std::string_view*>, MaxSegments> segments{};
+    };
+
+    Symbol insert(Shard& shard, size_t shardIndex, std::string_view text, uint64_t hash);
+    void growIndex(Shard& shard);
+    std::string_view slot(const Shard& shard, uint32_t slotIndex) const;
+
+    std::array<Shard, ShardCount> shards;
+};
+
+inline Symbol intern(std::string_view text) { return SymbolTable::global().intern(text); }
+inline std::string_view symbolText(Symbol symbol) { return SymbolTable::global().text(symbol); }
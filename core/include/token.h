@@ -1,6 +1,9 @@
 #pragma once
 #include <string>
-#include <optional>
+#include <string_view>
+#include <cstdint>
+#include "keywords.h"
+#include "symbol_table.h"
 
 enum class TokenType
 {
@@ -30,6 +33,7 @@ enum class TokenType
     MinusAssign,    
     MultiplyAssign, 
     DivideAssign,   
+    ModuloAssign,
     
     
     Equal,          
@@ -44,6 +48,9 @@ enum class TokenType
     LogicalOr,      
     LogicalNot,     
 
+    Increment,
+    Decrement,
+
     
     TagOpen,
     TagClose,
@@ -111,46 +118,63 @@ enum class LexerState
     StyleValue
 };
 
+// A token is a view into the source text retained by the Lexer that produced
+// it (or into the lexer's string arena for escape-processed literals), so the
+// Lexer must outlive every token it hands out. Error details are kept in the
+// lexer's side table and referenced by index. The position is a byte offset
+// into the source; SourceBuffer::lines() turns it into a line and column when
+// one is needed, which keeps sources to under 4 GiB (SourceBuffer::MaxSize).
 class Token
 {
 public:
+    static constexpr uint32_t NoError = UINT32_MAX;
+
     TokenType type;
-    std::string value;
-    size_t line;
-    size_t column;
-    std::optional<std::string> error;
-    std::string errorMessage;
+    Keyword keyword = Keyword::NotKeyword;
+    std::string_view value;
+    uint32_t offset;
+    uint32_t errorIndex;
+    // Interned name for Identifier, TagOpen, TagClose, AttributeName and
+    // ValueBinding tokens (without the '!'); empty for everything else.
+    Symbol symbol;
 
 public:
     
-    Token(TokenType t, const std::string &v, size_t l, size_t c)
-        : type(t), value(v), line(l), column(c), error(std::nullopt), errorMessage("") {}
+    Token(TokenType t, std::string_view v, uint32_t o, uint32_t err = NoError)
+        : type(t), value(v), offset(o), errorIndex(err) {}
 
-    
-    Token(TokenType t, const char *v, size_t l, size_t c)
-        : type(t), value(v), line(l), column(c), error(std::nullopt), errorMessage("") {}
 
-    
-    Token(TokenType t, const std::string &v, size_t l, size_t c, const std::string &errorMsg)
-        : type(t), value(v), line(l), column(c), error(std::make_optional(errorMsg)), errorMessage(errorMsg) {}
+    Token(TokenType t, const char *v, uint32_t o, uint32_t err = NoError)
+        : type(t), value(v), offset(o), errorIndex(err) {}
+
+    Token(Keyword kw, std::string_view v, uint32_t o)
+        : type(TokenType::Keyword), keyword(kw), value(v), offset(o), errorIndex(NoError) {}
+
+    Token(TokenType t, Symbol sym, std::string_view v, uint32_t o)
+        : type(t), value(v), offset(o), errorIndex(NoError), symbol(sym) {}
+
+    // Tokens never own their text; binding one to a temporary would dangle.
+    Token(TokenType t, std::string &&v, uint32_t o, uint32_t err = NoError) = delete;
 
     TokenType getType() const { return type; }
-    const std::string &getValue() const { return value; }
-    size_t getLine() const { return line; }
-    size_t getColumn() const { return column; }
-    const std::optional<std::string> &getError() const { return error; }
-    const std::string &getErrorMessage() const { return errorMessage; }
+    Keyword getKeyword() const { return keyword; }
+    Symbol getSymbol() const { return symbol; }
+    std::string_view getValue() const { return value; }
+    uint32_t getOffset() const { return offset; }
+    bool hasError() const { return errorIndex != NoError; }
+    uint32_t getErrorIndex() const { return errorIndex; }
     
     
     std::string toString() const {
-        std::string result = tokenTypeToString(type) + ": \"" + value + "\"";
-        if (error) {
-            result += " [ERROR: " + *error + "]";
+        std::string result = tokenTypeToString(type) + ": \"" + std::string(value) + "\"";
+        if (hasError()) {
+            result += " [ERROR #" + std::to_string(errorIndex) + "]";
         }
         return result;
     }
-    
-private:
+
+    // Upper-case name of `type`, as used by toString() and token dumps. No
+    // default case, so a new TokenType without a name is a -Wswitch warning.
     static std::string tokenTypeToString(TokenType type) {
         switch (type) {
             case TokenType::Identifier: return "IDENTIFIER";
@@ -159,28 +183,73 @@ private:
             case TokenType::String: return "STRING";
             case TokenType::Boolean: return "BOOLEAN";
             case TokenType::Null: return "NULL";
+            case TokenType::Operator: return "OPERATOR";
+            case TokenType::Arrow: return "ARROW";
             case TokenType::Plus: return "PLUS";
             case TokenType::Minus: return "MINUS";
             case TokenType::Multiply: return "MULTIPLY";
             case TokenType::Divide: return "DIVIDE";
+            case TokenType::Modulo: return "MODULO";
             case TokenType::Power: return "POWER";
             case TokenType::Assign: return "ASSIGN";
             case TokenType::PlusAssign: return "PLUS_ASSIGN";
+            case TokenType::MinusAssign: return "MINUS_ASSIGN";
+            case TokenType::MultiplyAssign: return "MULTIPLY_ASSIGN";
+            case TokenType::DivideAssign: return "DIVIDE_ASSIGN";
+            case TokenType::ModuloAssign: return "MODULO_ASSIGN";
             case TokenType::Equal: return "EQUAL";
             case TokenType::NotEqual: return "NOT_EQUAL";
+            case TokenType::Less: return "LESS";
+            case TokenType::LessEqual: return "LESS_EQUAL";
+            case TokenType::Greater: return "GREATER";
+            case TokenType::GreaterEqual: return "GREATER_EQUAL";
             case TokenType::LogicalAnd: return "LOGICAL_AND";
             case TokenType::LogicalOr: return "LOGICAL_OR";
-            case TokenType::AtModifier: return "AT_MODIFIER";
-            case TokenType::ValueBinding: return "VALUE_BINDING";
-            case TokenType::AsyncBlockStart: return "ASYNC_BLOCK_START";
+            case TokenType::LogicalNot: return "LOGICAL_NOT";
+            case TokenType::Increment: return "INCREMENT";
+            case TokenType::Decrement: return "DECREMENT";
+            case TokenType::TagOpen: return "TAG_OPEN";
+            case TokenType::TagClose: return "TAG_CLOSE";
+            case TokenType::TagSelfClose: return "TAG_SELF_CLOSE";
+            case TokenType::TagEnd: return "TAG_END";
+            case TokenType::AttributeName: return "ATTRIBUTE_NAME";
+            case TokenType::AttributeValue: return "ATTRIBUTE_VALUE";
+            case TokenType::Text: return "TEXT";
+            case TokenType::Comment: return "COMMENT";
+            case TokenType::ExpressionStart: return "EXPRESSION_START";
+            case TokenType::ExpressionEnd: return "EXPRESSION_END";
+            case TokenType::Equals: return "EQUALS";
             case TokenType::BraceOpen: return "BRACE_OPEN";
             case TokenType::BraceClose: return "BRACE_CLOSE";
+            case TokenType::Colon: return "COLON";
+            case TokenType::SemiColon: return "SEMICOLON";
             case TokenType::ParenOpen: return "PAREN_OPEN";
             case TokenType::ParenClose: return "PAREN_CLOSE";
             case TokenType::SquareBracketOpen: return "SQUARE_BRACKET_OPEN";
-            case TokenType::SquareBracketClose: return "BRACKET_CLOSE";
+            case TokenType::SquareBracketClose: return "SQUARE_BRACKET_CLOSE";
+            case TokenType::Comma: return "COMMA";
+            case TokenType::Dot: return "DOT";
+            case TokenType::AtModifier: return "AT_MODIFIER";
+            case TokenType::ValueBinding: return "VALUE_BINDING";
+            case TokenType::StyleProperty: return "STYLE_PROPERTY";
+            case TokenType::AsyncBlockStart: return "ASYNC_BLOCK_START";
+            case TokenType::AsyncTryStart: return "ASYNC_TRY_START";
+            case TokenType::AsyncCatchStart: return "ASYNC_CATCH_START";
+            case TokenType::AsyncFinallyStart: return "ASYNC_FINALLY_START";
+            case TokenType::AsyncBlockEnd: return "ASYNC_BLOCK_END";
+            case TokenType::IfStart: return "IF_START";
+            case TokenType::ForStart: return "FOR_START";
+            case TokenType::WhileStart: return "WHILE_START";
+            case TokenType::ControlBlockStart: return "CONTROL_BLOCK_START";
+            case TokenType::ControlBlockEnd: return "CONTROL_BLOCK_END";
             case TokenType::EOFToken: return "EOF";
-            default: return "UNKNOWN";
+            case TokenType::Unknown: return "UNKNOWN";
+            case TokenType::Error: return "ERROR";
+            case TokenType::ErrorRecovery: return "ERROR_RECOVERY";
+            case TokenType::PowerAssign: return "POWER_ASSIGN";
+            case TokenType::SlashGreater: return "SLASH_GREATER";
+            case TokenType::Slash: return "SLASH";
         }
+        return "UNKNOWN";
     }
 };
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+#include "token.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Tokens stored column-wise for the parser. Its lookahead predicates (check,
+// match, checkNext, isAtEnd) only ask "what type is the token n ahead", so
+// types get a dense byte array of their own: a cache line holds 64 of them,
+// where it held about one Token. Source offsets are a second dense column;
+// everything else (text, error index, symbol, keyword) is in a
+// side table that is read only when the parser consumes or reports a token.
+//
+// The type column is followed by Padding EOFToken bytes, so looking a few
+// tokens past the end needs no bounds check.
+class TokenBuffer {
+public:
+    static constexpr size_t Padding = 16;
+
+    struct Payload {
+        std::string_view value;
+        uint32_t errorIndex;
+        Symbol symbol;
+        Keyword keyword;
+    };
+
+    TokenBuffer() : typeColumn(Padding, static_cast<uint8_t>(TokenType::EOFToken)) {}
+
+    void reserve(size_t tokens) {
+        typeColumn.reserve(tokens + Padding);
+        offsetColumn.reserve(tokens);
+        payloads.reserve(tokens);
+    }
+
+    void push(const Token& token) {
+        // The slot after the last token is padding already; it becomes the
+        // token's and one more padding byte goes on the end.
+        typeColumn[payloads.size()] = static_cast<uint8_t>(token.type);
+        typeColumn.push_back(static_cast<uint8_t>(TokenType::EOFToken));
+        offsetColumn.push_back(token.offset);
+        payloads.push_back({token.value, token.errorIndex, token.symbol, token.keyword});
+    }
+
+    size_t size() const { return payloads.size(); }
+    bool empty() const { return payloads.empty(); }
+
+    TokenType type(size_t index) const { return static_cast<TokenType>(typeColumn[index]); }
+    // size() + Padding entries.
+    const uint8_t* types() const { return typeColumn.data(); }
+    uint32_t offset(size_t index) const { return offsetColumn[index]; }
+    const Payload& payload(size_t index) const { return payloads[index]; }
+
+    // The token at `index` as a Token, as Lexer::tokenize() would have
+    // returned it.
+    Token token(size_t index) const {
+        const Payload& p = payloads[index];
+        Token result(type(index), p.value, offsetColumn[index], p.errorIndex);
+        result.keyword = p.keyword;
+        result.symbol = p.symbol;
+        return result;
+    }
+
+private:
+    static_assert(static_cast<int>(TokenType::Slash) < 256, "token types must fit the byte column");
+
+    std::vector<uint8_t> typeColumn;
+    std::vector<uint32_t> offsetColumn;
+    std::vector<Payload> payloads;
+};
@@ -0,0 +1,153 @@
+#pragma once
+#include "incremental_lexer.h"
+#include "lexer.h"
+#include "token.h"
+#include "token_buffer.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+// Pull-based token source for the Parser. Tokens are taken from the Lexer
+// one at a time as the parser asks for them, and only the lookahead window
+// is buffered (a fixed ring of Capacity tokens), so memory no longer grows
+// with file size. A pre-lexed vector or an IncrementalLexer's stream can be
+// read the same way; those can also be skipped through (skipTo).
+//
+// A TokenBuffer is read in place instead: peekType() looks straight into its
+// type column, and peek() builds a Token from the columns only when the
+// parser asks for one.
+//
+// Once the end is reached every further token is EOFToken.
+class TokenStream {
+public:
+    static constexpr size_t Capacity = 8;
+
+    explicit TokenStream(Lexer& source)
+        : lexer(&source), ring(Capacity, endToken()), last(endToken()) {}
+
+    explicit TokenStream(std::vector<Token> tokens)
+        : buffered(std::move(tokens)), ring(Capacity, endToken()), last(endToken()) {}
+
+    explicit TokenStream(const IncrementalLexer& source)
+        : document(&source), ring(Capacity, endToken()), last(endToken()) {}
+
+    explicit TokenStream(TokenBuffer tokens)
+        : columns(std::move(tokens)), types(columns.types()), ring(Capacity, endToken()), last(endToken()) {
+        std::fill(std::begin(slotIndex), std::end(slotIndex), NoIndex);
+    }
+
+    TokenStream(const TokenStream&) = delete;
+    TokenStream& operator=(const TokenStream&) = delete;
+
+    // Token `ahead` positions past the current one; ahead < Capacity.
+    const Token& peek(size_t ahead = 0) {
+        if (types) return materialize(consumed + ahead);
+        return fill(ahead);
+    }
+
+    // Type of the token `ahead` positions past the current one; ahead <
+    // Capacity. Reads one byte when the tokens are in a TokenBuffer.
+    TokenType peekType(size_t ahead = 0) {
+        if (types) return static_cast<TokenType>(types[consumed + ahead]);
+        return fill(ahead).type;
+    }
+
+    // Keyword of the current token (NotKeyword for non-keywords).
+    Keyword peekKeyword() {
+        if (types) return consumed < columns.size() ? columns.payload(consumed).keyword : Keyword::NotKeyword;
+        return fill(0).keyword;
+    }
+
+    // Consumes the current token and returns it.
+    const Token& advance() {
+        if (types) {
+            if (consumed < columns.size()) ++consumed;
+            lastIndex = NoIndex;
+            return previous();
+        }
+        fill(0);
+        last = ring[head];
+        head = (head + 1) & Mask;
+        --count;
+        ++consumed;
+        return last;
+    }
+
+    // Index of the current token in the stream.
+    size_t position() const { return consumed; }
+
+    // Makes token `index` the current one, as if everything before it had
+    // been consumed. Not available when pulling from a Lexer.
+    void skipTo(size_t index) {
+        next = index;
+        count = 0;
+        consumed = index;
+        lastIndex = NoIndex;
+        if (!types) last = index > 0 ? at(index - 1) : endToken();
+    }
+
+    // The most recently consumed token (an EOFToken before the first).
+    const Token& previous() const {
+        if (types && lastIndex != consumed) {
+            last = consumed > 0 ? columns.token(consumed - 1) : endToken();
+            lastIndex = consumed;
+        }
+        return last;
+    }
+
+private:
+    static constexpr size_t Mask = Capacity - 1;
+    static_assert((Capacity & Mask) == 0, "Capacity must be a power of two");
+    static_assert(Capacity <= TokenBuffer::Padding, "peekType() may look Capacity tokens past the end");
+    static constexpr size_t NoIndex = SIZE_MAX;
+
+    static Token endToken() { return Token(TokenType::EOFToken, "", 0); }
+
+    Token pull() {
+        if (lexer) return lexer->next();
+        return at(next++);
+    }
+
+    // Fills the ring up to `ahead` from the source.
+    const Token& fill(size_t ahead) {
+        while (count <= ahead) {
+            ring[(head + count) & Mask] = pull();
+            ++count;
+        }
+        return ring[(head + ahead) & Mask];
+    }
+
+    // With a TokenBuffer the ring caches Tokens built from the columns, one
+    // slot per index modulo Capacity, so a reference from peek() lasts as
+    // long as it would with a Lexer.
+    const Token& materialize(size_t index) {
+        size_t slot = index & Mask;
+        if (slotIndex[slot] != index) {
+            ring[slot] = index < columns.size() ? columns.token(index) : endToken();
+            slotIndex[slot] = index;
+        }
+        return ring[slot];
+    }
+
+    Token at(size_t index) const {
+        if (document) return index < document->size() ? document->token(index) : endToken();
+        return index < buffered.size() ? buffered[index] : endToken();
+    }
+
+    Lexer* lexer = nullptr;
+    const IncrementalLexer* document = nullptr;
+    std::vector<Token> buffered;
+    TokenBuffer columns;
+    const uint8_t* types = nullptr;   // columns.types() when reading a TokenBuffer
+    size_t slotIndex[Capacity];
+    size_t next = 0;
+    size_t consumed = 0;
+
+    std::vector<Token> ring;
+    size_t head = 0;
+    size_t count = 0;
+    mutable Token last;
+    mutable size_t lastIndex = NoIndex;
+};
@@ -1,5 +1,9 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <utility>
 
 struct Utf8Char {
     std::string value;
@@ -8,7 +12,7 @@ struct Utf8Char {
     std::string error;
 };
 
-uint32_t decodeUTF8(const std::string &bytes)
+inline uint32_t decodeUTF8(const std::string &bytes)
 {
     const unsigned char *data = reinterpret_cast<const unsigned char *>(bytes.data());
     size_t len = bytes.size();
@@ -37,4 +41,44 @@ uint32_t decodeUTF8(const std::string &bytes)
     }
 
     return 0xFFFD;
-}
\ No newline at end of file
+}
+
+// Codepoint at input[pos] and its length in bytes. A lead byte followed by
+// the wrong continuation bytes, an overlong form or a value past U+10FFFF is
+// one invalid byte, decoded as U+FFFD. Past the end, {0, 0}.
+inline std::pair<uint32_t, size_t> decodeUTF8(std::string_view input, size_t pos)
+{
+    if (pos >= input.size()) return {0, 0};
+    unsigned char c = input[pos];
+    if (c < 0x80) return {c, 1};
+    if ((c & 0xE0) == 0xC0 && pos + 1 < input.size()) {
+        unsigned char c2 = input[pos + 1];
+        if ((c2 & 0xC0) == 0x80) {
+            uint32_t cp = ((c & 0x1F) << 6) | (c2 & 0x3F);
+            if (cp >= 0x80) return {cp, 2};
+        }
+    } else if ((c & 0xF0) == 0xE0 && pos + 2 < input.size()) {
+        unsigned char c2 = input[pos + 1];
+        unsigned char c3 = input[pos + 2];
+        if ((c2 & 0xC0) == 0x80 && (c3 & 0xC0) == 0x80) {
+            uint32_t cp = ((c & 0x0F) << 12) | ((c2 & 0x3F) << 6) | (c3 & 0x3F);
+            if (cp >= 0x800) return {cp, 3};
+        }
+    } else if ((c & 0xF8) == 0xF0 && pos + 3 < input.size()) {
+        unsigned char c2 = input[pos + 1];
+        unsigned char c3 = input[pos + 2];
+        unsigned char c4 = input[pos + 3];
+        if ((c2 & 0xC0) == 0x80 && (c3 & 0xC0) == 0x80 && (c4 & 0xC0) == 0x80) {
+            uint32_t cp = ((c & 0x07) << 18) | ((c2 & 0x3F) << 12) | ((c3 & 0x3F) << 6) | (c4 & 0x3F);
+            if (cp >= 0x10000 && cp <= 0x10FFFF) return {cp, 4};
+        }
+    }
+    return {0xFFFD, 1};
+}
+
+// Bytes in the codepoint at input[pos], by the rules above.
+inline size_t utf8SequenceLength(std::string_view input, size_t pos)
+{
+    if (pos < input.size() && static_cast<unsigned char>(input[pos]) < 0x80) return 1;
+    return decodeUTF8(input, pos).second;
+}
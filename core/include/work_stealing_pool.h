@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size thread pool where every worker owns a task deque. A worker
+// takes its newest task first (LIFO, so work it spawned is still in cache);
+// when its deque is empty it steals the oldest task from another worker
+// (FIFO, so thieves take the large, not-yet-split pieces). Tasks submitted
+// from outside the pool are dealt round-robin across the deques.
+//
+// Each deque has its own lock, so workers only contend when one steals from
+// another, which happens only once the work has run out. The task counters
+// are atomics; the shared stateMutex is taken only to sleep, to wake a
+// sleeper, and to record a task's exception.
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    // threads == 0 uses one worker per hardware thread.
+    explicit WorkStealingPool(unsigned threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Safe to call from any thread, including from inside a running task.
+    void submit(Task task);
+
+    // Blocks until every submitted task (and every task those submitted) has
+    // finished. Rethrows the first exception a task let escape, if any.
+    // Must not be called from inside a task.
+    void wait();
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run(unsigned index);
+    bool popLocal(unsigned index, Task& task);
+    bool steal(unsigned thief, Task& task);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    std::atomic<size_t> queued{0};       // tasks sitting in deques
+    std::atomic<size_t> unfinished{0};   // submitted but not yet completed
+    std::atomic<unsigned> sleeping{0};   // workers waiting on workAvailable
+    bool stopping = false;               // guarded by stateMutex
+    std::exception_ptr firstError;
+
+    std::atomic<unsigned> nextWorker{0};
+};
@@ -0,0 +1,197 @@
+#include "json_writer.h"
+#include "byte_scan.h"
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        int chunk = _write(fd, data, static_cast<unsigned>(size < (1u << 30) ? size : (1u << 30)));
+#else
+        ssize_t chunk = ::write(fd, data, size);
+#endif
+        if (chunk < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += chunk;
+        size -= static_cast<size_t>(chunk);
+    }
+    return true;
+}
+
+constexpr char Hex[] = "0123456789abcdef";
+
+}
+
+void appendJsonEscaped(std::string& out, std::string_view text) {
+    const char* data = text.data();
+    size_t size = text.size();
+    while (size > 0) {
+        // Plain runs are copied whole; only the rare special byte is handled
+        // one at a time.
+        size_t run = bytescan::findJsonEscape(data, size);
+        out.append(data, run);
+        if (run == size) break;
+        unsigned char c = static_cast<unsigned char>(data[run]);
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default: {
+                char escape[6] = {'\\', 'u', '0', '0', Hex[c >> 4], Hex[c & 0xF]};
+                out.append(escape, sizeof escape);
+                break;
+            }
+        }
+        data += run + 1;
+        size -= run + 1;
+    }
+}
+
+JsonWriter::JsonWriter(std::string& target, Style style) : out(target), style(style) {}
+
+JsonWriter::JsonWriter(int descriptor, Style style) : out(own), fd(descriptor), style(style) {
+    own.reserve(FlushThreshold + 64 * 1024);
+}
+
+JsonWriter::~JsonWriter() {
+    flush();
+}
+
+bool JsonWriter::flush() {
+    if (fd < 0) return true;
+    if (!writeFailed && !out.empty() && !writeAll(fd, out.data(), out.size())) writeFailed = true;
+    flushed += out.size();
+    out.clear();
+    return !writeFailed;
+}
+
+void JsonWriter::newline(size_t depth) {
+    static constexpr char Spaces[] = "                                                                ";
+    out += '\n';
+    for (size_t indent = depth * 2; indent > 0;) {
+        size_t n = indent < sizeof Spaces - 1 ? indent : sizeof Spaces - 1;
+        out.append(Spaces, n);
+        indent -= n;
+    }
+}
+
+void JsonWriter::beforeValue() {
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+    if (open.empty()) return;
+    if (open.back()) out += ',';
+    open.back() = true;
+    if (style == Style::Pretty) newline(open.size());
+}
+
+void JsonWriter::close(char bracket) {
+    bool hadMembers = open.back();
+    open.pop_back();
+    if (hadMembers && style == Style::Pretty) newline(open.size());
+    out += bracket;
+    if (open.empty() && style == Style::Pretty) out += '\n';
+    maybeFlush();
+}
+
+JsonWriter& JsonWriter::beginObject() {
+    beforeValue();
+    out += '{';
+    open.push_back(false);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    close('}');
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+    beforeValue();
+    out += '[';
+    open.push_back(false);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    close(']');
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(std::string_view name) {
+    beforeValue();
+    out += '"';
+    appendJsonEscaped(out, name);
+    out += style == Style::Pretty ? "\": " : "\":";
+    afterKey = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(std::string_view text) {
+    beforeValue();
+    out += '"';
+    appendJsonEscaped(out, text);
+    out += '"';
+    maybeFlush();
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool flag) {
+    beforeValue();
+    out += flag ? "true" : "false";
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double number) {
+    if (!std::isfinite(number)) return null();
+    beforeValue();
+    char digits[32];
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    // Shortest text that reads back as the same double.
+    auto result = std::to_chars(digits, digits + sizeof digits, number);
+    out.append(digits, result.ptr);
+#else
+    int length = std::snprintf(digits, sizeof digits, "%.17g", number);
+    out.append(digits, static_cast<size_t>(length));
+#endif
+    return *this;
+}
+
+JsonWriter& JsonWriter::integer(int64_t number) {
+    beforeValue();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof digits, number);
+    out.append(digits, result.ptr);
+    return *this;
+}
+
+JsonWriter& JsonWriter::unsignedInteger(uint64_t number) {
+    beforeValue();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof digits, number);
+    out.append(digits, result.ptr);
+    return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+    beforeValue();
+    out += "null";
+    return *this;
+}
@@ -0,0 +1,381 @@
+#include "../include/byte_scan.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#define BYTESCAN_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BYTESCAN_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define BYTESCAN_TARGET_AVX2
+#endif
+
+namespace bytescan {
+namespace {
+
+    inline bool isBlank(unsigned char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    inline bool isTextByte(unsigned char c) {
+        return (c <= 0x20 && c != '\n') || c == 0x7F || c == '`' || c == '\\';
+    }
+
+    size_t skipBlanksScalar(const char* data, size_t size) {
+        size_t i = 0;
+        while (i < size && isBlank(static_cast<unsigned char>(data[i]))) ++i;
+        return i;
+    }
+
+    size_t findAnyScalar(const char* data, size_t size, char a, char b, char c, char d) {
+        for (size_t i = 0; i < size; ++i) {
+            char ch = data[i];
+            if (ch == a || ch == b || ch == c || ch == d || ch == '\n' ||
+                static_cast<unsigned char>(ch) >= 0x80) {
+                return i;
+            }
+        }
+        return size;
+    }
+
+    size_t skipTextScalar(const char* data, size_t size) {
+        size_t i = 0;
+        while (i < size && isTextByte(static_cast<unsigned char>(data[i]))) ++i;
+        return i;
+    }
+
+    size_t findJsonEscapeScalar(const char* data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            unsigned char c = static_cast<unsigned char>(data[i]);
+            if (c < 0x20 || c == '"' || c == '\\') return i;
+        }
+        return size;
+    }
+
+    void appendLineStartsScalar(const char* data, size_t size, uint32_t base, std::vector<uint32_t>& starts) {
+        for (size_t i = 0; i < size; ++i) {
+            if (data[i] == '\n') starts.push_back(base + static_cast<uint32_t>(i) + 1);
+        }
+    }
+
+#ifdef BYTESCAN_X86
+
+    inline unsigned lowestBit(uint32_t mask) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+    }
+
+    // movemask() picks up each byte's high bit, so OR-ing the raw input into
+    // a match mask makes non-ASCII bytes stop the scan for free.
+    //
+    // The AVX2 scans finish their tail with the SSE2 ones, which are compiled
+    // without VEX encoding. They clear the upper halves of the ymm registers
+    // first: calling legacy SSE code with them dirty costs a state transition
+    // on every call, which swamps short scans.
+
+    size_t skipBlanksSSE2(const char* data, size_t size) {
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i tab = _mm_set1_epi8('\t');
+        const __m128i cr = _mm_set1_epi8('\r');
+        const __m128i vt = _mm_set1_epi8('\v');
+        const __m128i ff = _mm_set1_epi8('\f');
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i blank = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+                _mm_or_si128(_mm_cmpeq_epi8(v, cr),
+                             _mm_or_si128(_mm_cmpeq_epi8(v, vt), _mm_cmpeq_epi8(v, ff))));
+            uint32_t stop = ~static_cast<uint32_t>(_mm_movemask_epi8(blank)) & 0xFFFFu;
+            if (stop) return i + lowestBit(stop);
+        }
+        return i + skipBlanksScalar(data + i, size - i);
+    }
+
+    size_t findAnySSE2(const char* data, size_t size, char a, char b, char c, char d) {
+        const __m128i va = _mm_set1_epi8(a);
+        const __m128i vb = _mm_set1_epi8(b);
+        const __m128i vc = _mm_set1_epi8(c);
+        const __m128i vd = _mm_set1_epi8(d);
+        const __m128i nl = _mm_set1_epi8('\n');
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i hit = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)),
+                _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, vc), _mm_cmpeq_epi8(v, vd)),
+                             _mm_or_si128(_mm_cmpeq_epi8(v, nl), v)));
+            uint32_t stop = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+            if (stop) return i + lowestBit(stop);
+        }
+        return i + findAnyScalar(data + i, size - i, a, b, c, d);
+    }
+
+    size_t skipTextSSE2(const char* data, size_t size) {
+        const __m128i space = _mm_set1_epi8(0x20);
+        const __m128i nl = _mm_set1_epi8('\n');
+        const __m128i del = _mm_set1_epi8(0x7F);
+        const __m128i tick = _mm_set1_epi8('`');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i low = _mm_andnot_si128(_mm_cmpeq_epi8(v, nl),
+                                           _mm_cmpeq_epi8(_mm_min_epu8(v, space), v));
+            __m128i text = _mm_or_si128(
+                low, _mm_or_si128(_mm_cmpeq_epi8(v, del),
+                                  _mm_or_si128(_mm_cmpeq_epi8(v, tick), _mm_cmpeq_epi8(v, backslash))));
+            uint32_t stop = ~static_cast<uint32_t>(_mm_movemask_epi8(text)) & 0xFFFFu;
+            if (stop) return i + lowestBit(stop);
+        }
+        return i + skipTextScalar(data + i, size - i);
+    }
+
+    size_t findJsonEscapeSSE2(const char* data, size_t size) {
+        const __m128i control = _mm_set1_epi8(0x1F);
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(v, control), v),
+                                       _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)));
+            uint32_t stop = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+            if (stop) return i + lowestBit(stop);
+        }
+        return i + findJsonEscapeScalar(data + i, size - i);
+    }
+
+    void appendLineStartsSSE2(const char* data, size_t size, uint32_t base, std::vector<uint32_t>& starts) {
+        const __m128i nl = _mm_set1_epi8('\n');
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            uint32_t hits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)));
+            for (; hits != 0; hits &= hits - 1) starts.push_back(base + static_cast<uint32_t>(i + lowestBit(hits)) + 1);
+        }
+        appendLineStartsScalar(data + i, size - i, base + static_cast<uint32_t>(i), starts);
+    }
+
+    BYTESCAN_TARGET_AVX2 size_t skipBlanksAVX2(const char* data, size_t size) {
+        const __m256i space = _mm256_set1_epi8(' ');
+        const __m256i tab = _mm256_set1_epi8('\t');
+        const __m256i cr = _mm256_set1_epi8('\r');
+        const __m256i vt = _mm256_set1_epi8('\v');
+        const __m256i ff = _mm256_set1_epi8('\f');
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            __m256i blank = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, space), _mm256_cmpeq_epi8(v, tab)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, cr),
+                                _mm256_or_si256(_mm256_cmpeq_epi8(v, vt), _mm256_cmpeq_epi8(v, ff))));
+            uint32_t stop = ~static_cast<uint32_t>(_mm256_movemask_epi8(blank));
+            if (stop) return i + lowestBit(stop);
+        }
+        _mm256_zeroupper();
+        return i + skipBlanksSSE2(data + i, size - i);
+    }
+
+    BYTESCAN_TARGET_AVX2 size_t findAnyAVX2(const char* data, size_t size, char a, char b, char c, char d) {
+        const __m256i va = _mm256_set1_epi8(a);
+        const __m256i vb = _mm256_set1_epi8(b);
+        const __m256i vc = _mm256_set1_epi8(c);
+        const __m256i vd = _mm256_set1_epi8(d);
+        const __m256i nl = _mm256_set1_epi8('\n');
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            __m256i hit = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb)),
+                _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, vc), _mm256_cmpeq_epi8(v, vd)),
+                                _mm256_or_si256(_mm256_cmpeq_epi8(v, nl), v)));
+            uint32_t stop = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+            if (stop) return i + lowestBit(stop);
+        }
+        _mm256_zeroupper();
+        return i + findAnySSE2(data + i, size - i, a, b, c, d);
+    }
+
+    BYTESCAN_TARGET_AVX2 size_t skipTextAVX2(const char* data, size_t size) {
+        const __m256i space = _mm256_set1_epi8(0x20);
+        const __m256i nl = _mm256_set1_epi8('\n');
+        const __m256i del = _mm256_set1_epi8(0x7F);
+        const __m256i tick = _mm256_set1_epi8('`');
+        const __m256i backslash = _mm256_set1_epi8('\\');
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            __m256i low = _mm256_andnot_si256(_mm256_cmpeq_epi8(v, nl),
+                                              _mm256_cmpeq_epi8(_mm256_min_epu8(v, space), v));
+            __m256i text = _mm256_or_si256(
+                low, _mm256_or_si256(_mm256_cmpeq_epi8(v, del),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(v, tick), _mm256_cmpeq_epi8(v, backslash))));
+            uint32_t stop = ~static_cast<uint32_t>(_mm256_movemask_epi8(text));
+            if (stop) return i + lowestBit(stop);
+        }
+        _mm256_zeroupper();
+        return i + skipTextSSE2(data + i, size - i);
+    }
+
+    BYTESCAN_TARGET_AVX2 size_t findJsonEscapeAVX2(const char* data, size_t size) {
+        const __m256i control = _mm256_set1_epi8(0x1F);
+        const __m256i quote = _mm256_set1_epi8('"');
+        const __m256i backslash = _mm256_set1_epi8('\\');
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            __m256i hit = _mm256_or_si256(
+                _mm256_cmpeq_epi8(_mm256_min_epu8(v, control), v),
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)));
+            uint32_t stop = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+            if (stop) return i + lowestBit(stop);
+        }
+        _mm256_zeroupper();
+        return i + findJsonEscapeSSE2(data + i, size - i);
+    }
+
+    BYTESCAN_TARGET_AVX2 void appendLineStartsAVX2(const char* data, size_t size, uint32_t base,
+                                                   std::vector<uint32_t>& starts) {
+        const __m256i nl = _mm256_set1_epi8('\n');
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            uint32_t hits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nl)));
+            for (; hits != 0; hits &= hits - 1) starts.push_back(base + static_cast<uint32_t>(i + lowestBit(hits)) + 1);
+        }
+        _mm256_zeroupper();
+        appendLineStartsSSE2(data + i, size - i, base + static_cast<uint32_t>(i), starts);
+    }
+
+    bool cpuHasAVX2() {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+#endif // BYTESCAN_X86
+
+    struct Kernels {
+        Implementation impl;
+        size_t (*skipBlanks)(const char*, size_t);
+        size_t (*findAny)(const char*, size_t, char, char, char, char);
+        size_t (*skipText)(const char*, size_t);
+        size_t (*findJsonEscape)(const char*, size_t);
+        void (*appendLineStarts)(const char*, size_t, uint32_t, std::vector<uint32_t>&);
+    };
+
+    const Kernels scalarKernels{Implementation::Scalar, skipBlanksScalar, findAnyScalar, skipTextScalar,
+                                 findJsonEscapeScalar, appendLineStartsScalar};
+#ifdef BYTESCAN_X86
+    const Kernels sse2Kernels{Implementation::SSE2, skipBlanksSSE2, findAnySSE2, skipTextSSE2, findJsonEscapeSSE2,
+                              appendLineStartsSSE2};
+    const Kernels avx2Kernels{Implementation::AVX2, skipBlanksAVX2, findAnyAVX2, skipTextAVX2, findJsonEscapeAVX2,
+                              appendLineStartsAVX2};
+#endif
+
+    const Kernels* kernelsFor(Implementation impl) {
+        switch (impl) {
+#ifdef BYTESCAN_X86
+            case Implementation::AVX2: return cpuHasAVX2() ? &avx2Kernels : nullptr;
+            case Implementation::SSE2: return &sse2Kernels;
+#endif
+            case Implementation::Scalar: return &scalarKernels;
+            default: return nullptr;
+        }
+    }
+
+    const Kernels* detect() {
+        if (const char* forced = std::getenv("ALTERION_SCAN")) {
+            for (Implementation impl : {Implementation::Scalar, Implementation::SSE2, Implementation::AVX2}) {
+                if (std::strcmp(forced, name(impl)) == 0) {
+                    if (const Kernels* k = kernelsFor(impl)) return k;
+                }
+            }
+        }
+        for (Implementation impl : {Implementation::AVX2, Implementation::SSE2}) {
+            if (const Kernels* k = kernelsFor(impl)) return k;
+        }
+        return &scalarKernels;
+    }
+
+    std::atomic<const Kernels*> current{nullptr};
+
+    inline const Kernels& kernels() {
+        const Kernels* k = current.load(std::memory_order_relaxed);
+        if (!k) {
+            k = detect();
+            current.store(k, std::memory_order_relaxed);
+        }
+        return *k;
+    }
+}
+
+size_t skipBlanks(const char* data, size_t size) {
+    return kernels().skipBlanks(data, size);
+}
+
+size_t findAny(const char* data, size_t size, char a, char b, char c, char d) {
+    return kernels().findAny(data, size, a, b, c, d);
+}
+
+size_t skipText(const char* data, size_t size) {
+    return kernels().skipText(data, size);
+}
+
+size_t findJsonEscape(const char* data, size_t size) {
+    return kernels().findJsonEscape(data, size);
+}
+
+void appendLineStarts(const char* data, size_t size, uint32_t base, std::vector<uint32_t>& starts) {
+    kernels().appendLineStarts(data, size, base, starts);
+}
+
+Implementation active() {
+    return kernels().impl;
+}
+
+bool isSupported(Implementation impl) {
+    return kernelsFor(impl) != nullptr;
+}
+
+bool select(Implementation impl) {
+    const Kernels* k = kernelsFor(impl);
+    if (!k) return false;
+    current.store(k, std::memory_order_relaxed);
+    return true;
+}
+
+const char* name(Implementation impl) {
+    switch (impl) {
+        case Implementation::SSE2: return "sse2";
+        case Implementation::AVX2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+} // namespace bytescan
@@ -0,0 +1,282 @@
+#include "../include/incremental_lexer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// The lexer decides where a token ends by looking at most one codepoint past
+// it (peekAdvance), so a token whose lexing stopped this many bytes before an
+// edit cannot have seen the edited bytes.
+constexpr size_t LookAhead = 8;
+
+bool inside(std::string_view text, std::string_view value) {
+    auto begin = reinterpret_cast<uintptr_t>(text.data());
+    auto pointer = reinterpret_cast<uintptr_t>(value.data());
+    return pointer >= begin && pointer + value.size() <= begin + text.size();
+}
+
+}
+
+IncrementalLexer::IncrementalLexer(std::string text) {
+    reset(std::move(text));
+}
+
+void IncrementalLexer::reset(std::string text) {
+    source = std::move(text);
+    entries.clear();
+    errorTable.clear();
+    strings = Arena();
+    externalValues.clear();
+    externalIds.clear();
+    snapshots.clear();
+    snapshotIds.clear();
+    gapStart = gapEnd = 0;
+
+    std::vector<Entry> newEntries;
+    relex(LexerCheckpoint{}, 1, 0, 0, SIZE_MAX, SIZE_MAX, 0, newEntries, errorTable);
+    entries = std::move(newEntries);
+    gapStart = gapEnd = entries.size();
+    endPosition = source.size();
+    endLine = 1 + std::count(source.begin(), source.end(), '\n');
+    endErrors = errorTable.size();
+}
+
+IncrementalLexer::EditStats IncrementalLexer::edit(size_t offset, size_t removed, std::string_view inserted) {
+    offset = std::min(offset, source.size());
+    removed = std::min(removed, source.size() - offset);
+    size_t oldEnd = offset + removed;
+    size_t newEnd = offset + inserted.size();
+    std::ptrdiff_t delta = static_cast<std::ptrdiff_t>(inserted.size()) - static_cast<std::ptrdiff_t>(removed);
+    std::ptrdiff_t lineDelta = std::count(inserted.begin(), inserted.end(), '\n') -
+                               std::count(source.begin() + offset, source.begin() + oldEnd, '\n');
+
+    // Resume at the last boundary that lies LookAhead bytes before the edit;
+    // the first token's is at offset 0, so there always is one.
+    size_t first = upperBound(offset > LookAhead ? offset - LookAhead : 0) - 1;
+    Boundary restart = boundary(first);
+
+    source.replace(offset, removed, inserted.data(), inserted.size());
+
+    std::vector<Entry> newEntries;
+    std::vector<LexError> newErrors;
+    size_t resume = relex(checkpointAt(restart), restart.line, restart.errorsBefore, first, newEnd, oldEnd, delta,
+                          newEntries, newErrors);
+    size_t oldErrorsEnd = resume < size() ? boundary(resume).errorsBefore : endErrors;
+
+    // Drop the replaced entries from the front of the gap and fill it with
+    // the new ones. Everything behind the gap is counted from the end, which
+    // moves by exactly the edit's deltas, so none of it needs touching.
+    moveGap(first);
+    gapEnd += resume - first;
+    if (gapEnd - gapStart < newEntries.size()) {
+        size_t tail = entries.size() - gapEnd;
+        std::vector<Entry> grown(std::max(entries.size() * 2, gapStart + newEntries.size() + tail + 64));
+        std::copy(entries.begin(), entries.begin() + gapStart, grown.begin());
+        std::copy(entries.begin() + gapEnd, entries.end(), grown.end() - tail);
+        entries = std::move(grown);
+        gapEnd = entries.size() - tail;
+    }
+    std::copy(newEntries.begin(), newEntries.end(), entries.begin() + gapStart);
+    gapStart += newEntries.size();
+
+    errorTable.erase(errorTable.begin() + restart.errorsBefore, errorTable.begin() + oldErrorsEnd);
+    errorTable.insert(errorTable.begin() + restart.errorsBefore, newErrors.begin(), newErrors.end());
+    for (size_t i = restart.errorsBefore + newErrors.size(); i < errorTable.size(); ++i) {
+        errorTable[i].offset += static_cast<uint32_t>(delta);
+    }
+
+    endPosition = source.size();
+    endLine += lineDelta;
+    endErrors = errorTable.size();
+    return {first, resume - first, newEntries.size()};
+}
+
+IncrementalLexer::EditStats IncrementalLexer::assign(std::string_view text) {
+    size_t limit = std::min(text.size(), source.size());
+    size_t prefix = std::mismatch(text.begin(), text.begin() + limit, source.begin()).first - text.begin();
+    size_t suffix = 0;
+    while (suffix < limit - prefix && text[text.size() - 1 - suffix] == source[source.size() - 1 - suffix]) ++suffix;
+    return edit(prefix, source.size() - prefix - suffix, text.substr(prefix, text.size() - prefix - suffix));
+}
+
+size_t IncrementalLexer::relex(const LexerCheckpoint& from, size_t fromLine, size_t errorBase, size_t first,
+                               size_t newEnd, size_t oldEnd, std::ptrdiff_t delta, std::vector<Entry>& newEntries,
+                               std::vector<LexError>& newErrors) {
+    // Tokens carry byte offsets, so an old boundary can be reused as soon as
+    // the new lexer is past the edit at the same place in the same mode.
+    size_t line = fromLine;
+    size_t counted = from.position;
+    size_t count = size();
+    size_t candidate = std::max(first, oldEnd == 0 ? size_t(0) : upperBound(oldEnd - 1));
+
+    Lexer lexer(SourceBuffer::borrow(source), from);
+    while (true) {
+        size_t position = lexer.offset();
+        uint32_t snapshot = internSnapshot(lexer);
+        if (position >= newEnd) {
+            size_t oldPosition = position - delta;
+            while (candidate < count && boundary(candidate).position < oldPosition) ++candidate;
+            for (size_t at = candidate; at < count; ++at) {
+                Boundary old = boundary(at);
+                if (old.position != oldPosition) break;
+                if (old.snapshot == snapshot) {
+                    newErrors.insert(newErrors.end(), lexer.errors().begin(), lexer.errors().end());
+                    return at;
+                }
+            }
+        }
+
+        line += std::count(source.begin() + counted, source.begin() + position, '\n');
+        counted = position;
+
+        Entry entry{};
+        entry.position = static_cast<uint32_t>(position);
+        entry.line = static_cast<uint32_t>(line);
+        entry.errorsBefore = static_cast<uint32_t>(errorBase + lexer.errors().size());
+        entry.snapshot = snapshot;
+
+        size_t errorsBefore = lexer.errors().size();
+        Token token = lexer.next();
+        entry.type = token.type;
+        entry.keyword = token.keyword;
+        entry.symbol = token.symbol;
+        entry.valueLength = static_cast<uint32_t>(token.value.size());
+        if (inside(source, token.value)) {
+            entry.valueOffset = static_cast<uint32_t>(token.value.data() - source.data() - position);
+        } else {
+            // Punctuation literals and escape-processed strings repeat; keep
+            // one copy of each.
+            auto found = externalIds.find(token.value);
+            if (found == externalIds.end()) {
+                externalValues.push_back(strings.copy(token.value));
+                found = externalIds.emplace(externalValues.back(), static_cast<uint32_t>(externalValues.size() - 1)).first;
+            }
+            entry.external = true;
+            entry.valueOffset = found->second;
+        }
+        entry.tokenOffset = static_cast<uint32_t>(token.offset - position);
+        entry.errorOffset = token.hasError() ? static_cast<uint32_t>(token.errorIndex - errorsBefore) : Token::NoError;
+        newEntries.push_back(entry);
+        if (token.type == TokenType::EOFToken) break;
+    }
+    newErrors.insert(newErrors.end(), lexer.errors().begin(), lexer.errors().end());
+    return count;
+}
+
+IncrementalLexer::Boundary IncrementalLexer::boundary(size_t index) const {
+    const Entry& e = entry(index);
+    if (index < gapStart) return {e.position, e.line, e.errorsBefore, e.snapshot};
+    return {endPosition - e.position, endLine - e.line, endErrors - e.errorsBefore, e.snapshot};
+}
+
+size_t IncrementalLexer::upperBound(size_t position) const {
+    size_t low = 0, high = size();
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (boundary(middle).position <= position) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+void IncrementalLexer::moveGap(size_t index) {
+    while (gapStart > index) {
+        Entry e = entries[--gapStart];
+        e.position = static_cast<uint32_t>(endPosition - e.position);
+        e.line = static_cast<uint32_t>(endLine - e.line);
+        e.errorsBefore = static_cast<uint32_t>(endErrors - e.errorsBefore);
+        entries[--gapEnd] = e;
+    }
+    while (gapStart < index) {
+        Entry e = entries[gapEnd++];
+        e.position = static_cast<uint32_t>(endPosition - e.position);
+        e.line = static_cast<uint32_t>(endLine - e.line);
+        e.errorsBefore = static_cast<uint32_t>(endErrors - e.errorsBefore);
+        entries[gapStart++] = e;
+    }
+}
+
+Token IncrementalLexer::token(size_t index) const {
+    const Entry& e = entry(index);
+    Boundary b = boundary(index);
+    std::string_view value = e.external ? externalValues[e.valueOffset]
+                                        : std::string_view(source).substr(b.position + e.valueOffset, e.valueLength);
+    uint32_t error = e.errorOffset == Token::NoError ? Token::NoError
+                                                     : static_cast<uint32_t>(b.errorsBefore + e.errorOffset);
+    Token result(e.type, value, static_cast<uint32_t>(b.position + e.tokenOffset), error);
+    result.keyword = e.keyword;
+    result.symbol = e.symbol;
+    return result;
+}
+
+std::vector<Token> IncrementalLexer::tokens() const {
+    std::vector<Token> result;
+    result.reserve(size());
+    for (size_t i = 0; i < size(); ++i) result.push_back(token(i));
+    return result;
+}
+
+uint32_t IncrementalLexer::internSnapshot(const Lexer& lexer) {
+    scratchSnapshot.assign(lexer.enclosingStates().begin(), lexer.enclosingStates().end());
+    scratchSnapshot.push_back(lexer.currentState());
+    // Consecutive tokens nearly always share one; skip the map for those.
+    if (!snapshots.empty() && snapshots[lastSnapshot] == scratchSnapshot) return lastSnapshot;
+    auto found = snapshotIds.find(scratchSnapshot);
+    if (found == snapshotIds.end()) {
+        found = snapshotIds.emplace(scratchSnapshot, static_cast<uint32_t>(snapshots.size())).first;
+        snapshots.push_back(scratchSnapshot);
+    }
+    lastSnapshot = found->second;
+    return lastSnapshot;
+}
+
+LexerCheckpoint IncrementalLexer::checkpointAt(const Boundary& boundary) const {
+    const std::vector<LexerState>& states = snapshots[boundary.snapshot];
+    return {boundary.position, states.back(), std::vector<LexerState>(states.begin(), states.end() - 1)};
+}
+
+size_t IncrementalLexer::lineOffset(size_t line) const {
+    if (line <= 1) return 0;
+    // Start from the last token boundary before the line and count newlines
+    // from there, so the cost is one token's worth of text, not the file's.
+    size_t low = 0, high = size();
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (boundary(middle).line < line) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    size_t position = 0;
+    size_t current = 1;
+    if (low > 0) {
+        Boundary before = boundary(low - 1);
+        position = before.position;
+        current = before.line;
+    }
+    while (current < line) {
+        const void* newline = std::memchr(source.data() + position, '\n', source.size() - position);
+        if (newline == nullptr) return source.size();
+        position = static_cast<const char*>(newline) - source.data() + 1;
+        ++current;
+    }
+    return position;
+}
+
+SourceLocation IncrementalLexer::locate(size_t offset) const {
+    offset = std::min(offset, source.size());
+    size_t index = upperBound(offset);
+    size_t line = 1;
+    size_t position = 0;
+    if (index > 0) {
+        Boundary before = boundary(index - 1);
+        line = before.line;
+        position = before.position;
+    }
+    line += std::count(source.begin() + position, source.begin() + offset, '\n');
+    return {static_cast<uint32_t>(line), LineTable::columnOf(source, lineOffset(line), offset)};
+}
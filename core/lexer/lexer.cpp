@@ -1,138 +1,131 @@
 #include "../include/lexer.h"
+#include "../include/byte_scan.h"
+#include "../include/phase_timer.h"
+#include "../include/utf8_utils.h"
 #include <cctype>
 #include <iostream>
 #include <iomanip>
-#include <fstream>
-#include <unordered_set>
-#include <unordered_map>
 #include <algorithm>
 #include <cstdint>
 
 namespace {
-    
-    
-    
-    std::pair<uint32_t, size_t> decodeUTF8(const std::string& input, size_t pos) {
-        if (pos >= input.size()) return {0, 0};
-        unsigned char c = input[pos];
-        if (c < 0x80) return {c, 1};
-        if ((c & 0xE0) == 0xC0 && pos + 1 < input.size()) {
-            unsigned char c2 = input[pos + 1];
-            if ((c2 & 0xC0) == 0x80) {
-                uint32_t cp = ((c & 0x1F) << 6) | (c2 & 0x3F);
-                if (cp >= 0x80) return {cp, 2};
-            }
-        } else if ((c & 0xF0) == 0xE0 && pos + 2 < input.size()) {
-            unsigned char c2 = input[pos + 1];
-            unsigned char c3 = input[pos + 2];
-            if ((c2 & 0xC0) == 0x80 && (c3 & 0xC0) == 0x80) {
-                uint32_t cp = ((c & 0x0F) << 12) | ((c2 & 0x3F) << 6) | (c3 & 0x3F);
-                if (cp >= 0x800) return {cp, 3};
-            }
-        } else if ((c & 0xF8) == 0xF0 && pos + 3 < input.size()) {
-            unsigned char c2 = input[pos + 1];
-            unsigned char c3 = input[pos + 2];
-            unsigned char c4 = input[pos + 3];
-            if ((c2 & 0xC0) == 0x80 && (c3 & 0xC0) == 0x80 && (c4 & 0xC0) == 0x80) {
-                uint32_t cp = ((c & 0x07) << 18) | ((c2 & 0x3F) << 12) | ((c3 & 0x3F) << 6) | (c4 & 0x3F);
-                if (cp >= 0x10000 && cp <= 0x10FFFF) return {cp, 4};
-            }
+    // Two-character operators, switched on the pair directly. Returns
+    // TokenType::Unknown when the pair is not an operator.
+    constexpr TokenType twoCharOperator(char first, char second) {
+        switch (first) {
+            case '=': return second == '>' ? TokenType::Arrow : second == '=' ? TokenType::Equal : TokenType::Unknown;
+            case '-':
+                switch (second) {
+                    case '>': return TokenType::Arrow;
+                    case '-': return TokenType::Decrement;
+                    case '=': return TokenType::MinusAssign;
+                    default: return TokenType::Unknown;
+                }
+            case '+': return second == '+' ? TokenType::Increment : second == '=' ? TokenType::PlusAssign : TokenType::Unknown;
+            case '*': return second == '*' ? TokenType::Power : second == '=' ? TokenType::MultiplyAssign : TokenType::Unknown;
+            case '/': return second == '=' ? TokenType::DivideAssign : TokenType::Unknown;
+            case '%': return second == '=' ? TokenType::ModuloAssign : TokenType::Unknown;
+            case '!': return second == '=' ? TokenType::NotEqual : TokenType::Unknown;
+            case '<': return second == '=' ? TokenType::LessEqual : TokenType::Unknown;
+            case '>': return second == '=' ? TokenType::GreaterEqual : TokenType::Unknown;
+            case '&': return second == '&' ? TokenType::LogicalAnd : TokenType::Unknown;
+            case '|': return second == '|' ? TokenType::LogicalOr : TokenType::Unknown;
+            default: return TokenType::Unknown;
         }
-        
-        return {0xFFFD, 1};
     }
-}
 
-namespace {
-    const std::unordered_set<std::string> KEYWORDS = {
-        
-        "async", "component", "import", "extern", "for", "if", "else", "while", 
-        "return", "break", "continue", "yield", "await", "throw", "try", "catch", "finally",
-        
-        
-        "render", "script", "function", "fn", "method",
-        
-        
-        "type", "interface", "struct", "enum", "union",
-        
-        
-        "from", "export", "use", "pub", "mod", "namespace",
-        
-        
-        "move", "copy", "ref", "deref", "owned", "borrowed", "shared", "weak",
-        
-        
-        "true", "false", "null", "none", "undefined",
-        
-        
-        "this", "super", "self", "Self", "match", "case", "default",
-        "let", "const", "var", "new", "delete", "as", "is", "typeof",
-        "print", "println"
-    };
-
-    const std::unordered_map<std::string, TokenType> MULTI_CHAR_OPERATORS = {
-        {"=>", TokenType::Arrow},
-        {"->", TokenType::Arrow}, 
-        {"==", TokenType::Operator},
-        {"!=", TokenType::Operator},
-        {"<=", TokenType::Operator},
-        {">=", TokenType::Operator},
-        {"&&", TokenType::Operator},
-        {"||", TokenType::Operator},
-        {"**", TokenType::Operator},
-        {"++", TokenType::Operator},
-        {"--", TokenType::Operator},
-        {"+=", TokenType::Operator},
-        {"-=", TokenType::Operator},
-        {"*=", TokenType::Operator},
-        {"/=", TokenType::Operator},
-        {"%=", TokenType::Operator}
-    };
+    static_assert(twoCharOperator('+', '=') == TokenType::PlusAssign);
+    static_assert(twoCharOperator('+', '+') == TokenType::Increment);
+    static_assert(twoCharOperator('&', '|') == TokenType::Unknown);
+
+    // Names for the Verbose trace's state events.
+    const char* stateName(LexerState state) {
+        switch (state) {
+            case LexerState::Normal: return "Normal";
+            case LexerState::ALTXAttribute: return "ALTXAttribute";
+            case LexerState::ALTXContent: return "ALTXContent";
+            case LexerState::ALTSScript: return "ALTSScript";
+            case LexerState::Expression: return "Expression";
+            case LexerState::StyleValue: return "StyleValue";
+        }
+        return "Unknown";
+    }
 }
 
 Lexer::Lexer(const std::string& source) 
-    : input(source), position(0), line(1), column(1), state(LexerState::Normal), isUTF8Error(false) {
+    : Lexer(SourceBuffer::fromString(source)) {}
+
+Lexer::Lexer(std::shared_ptr<const SourceBuffer> buffer) 
+    : source(std::move(buffer)), input(source->text()), position(0), state(LexerState::Normal), isUTF8Error(false), finished(false) {
     stateStack.reserve(8);
+    // A borrowed or in-memory buffer can be any size; past MaxSize offsets
+    // would wrap, so such a source is lexed as empty.
+    if (input.size() > SourceBuffer::MaxSize) {
+        errorTable.push_back({0, "Source is " + std::to_string(input.size()) + " bytes; at most " +
+                                     std::to_string(SourceBuffer::MaxSize) + " are supported"});
+        input = std::string_view();
+    }
+}
+
+Lexer::Lexer(std::shared_ptr<const SourceBuffer> buffer, const LexerCheckpoint& from)
+    : Lexer(std::move(buffer)) {
+    position = from.position;
+    state = from.state;
+    stateStack = from.stateStack;
 }
 
 
 uint32_t Lexer::peekCodepoint() const {
-    auto [cp, len] = decodeUTF8(input, position);
-    return cp;
+    if (position >= input.size()) return 0;
+    unsigned char c = static_cast<unsigned char>(input[position]);
+    if (c < 0x80) return c;
+    return decodeUTF8(input, position).first;
 }
 
 
 uint32_t Lexer::peekAdvanceCodepoint() const {
-    auto [cp1, len1] = decodeUTF8(input, position);
-    auto [cp2, len2] = decodeUTF8(input, position + len1);
-    return cp2;
+    if (position >= input.size()) return 0;
+    size_t next = position + utf8SequenceLength(input, position);
+    if (next >= input.size()) return 0;
+    unsigned char c = static_cast<unsigned char>(input[next]);
+    if (c < 0x80) return c;
+    return decodeUTF8(input, next).first;
 }
 
 
 
 uint32_t Lexer::advanceCodepoint() {
+    if (position >= input.size()) return 0;
+    unsigned char c = static_cast<unsigned char>(input[position]);
+    if (c < 0x80) {
+        ++position;
+        return c;
+    }
     auto [cp, len] = decodeUTF8(input, position);
     position += len;
-    if (cp == 0xFFFD) isUTF8Error = true;
-    if (cp == '\n') {
-        ++line;
-        column = 1;
-    } else {
-        ++column;
-    }
+    if (cp == 0xFFFD && len == 1) isUTF8Error = true;
     return cp;
 }
 
+// Character access is byte-level. ASCII comes back as-is; for a multi-byte
+// sequence the lead byte is returned, which always has the high bit set and
+// so classifies as an identifier character. Only advance() and peekAdvance()
+// decode, and only when the high bit is set, to step over whole codepoints.
 char Lexer::peek() const {
-    return static_cast<char>(peekCodepoint());
+    return position < input.size() ? input[position] : '\0';
 }
 
 char Lexer::peekAdvance() const {
-    return static_cast<char>(peekAdvanceCodepoint());
+    if (position >= input.size()) return '\0';
+    size_t next = position + utf8SequenceLength(input, position);
+    return next < input.size() ? input[next] : '\0';
 }
 
 char Lexer::advance() {
-    return static_cast<char>(advanceCodepoint());
+    if (position >= input.size()) return '\0';
+    char c = input[position];
+    advanceCodepoint();
+    return c;
 }
 
 bool Lexer::match(char expected) {
@@ -148,6 +141,7 @@ bool Lexer::eof() const {
 void Lexer::enterState(LexerState newState) {
     stateStack.push_back(state);
     state = newState;
+    LEXER_TRACE(trace, TraceLevel::Verbose, "state.enter", stateName(state), lines().locate(here()));
 }
 
 void Lexer::exitState() {
@@ -157,18 +151,19 @@ void Lexer::exitState() {
     } else {
         state = LexerState::Normal;
     }
+    LEXER_TRACE(trace, TraceLevel::Verbose, "state.exit", stateName(state), lines().locate(here()));
 }
 
 
+void Lexer::advanceRun(size_t length) {
+    position += length;
+}
+
 void Lexer::skipWhitespace() {
     while (!eof()) {
-        char c = peek();
-        unsigned char uc = static_cast<unsigned char>(c);
-        if (uc <= 127 && std::isspace(uc)) {
-            advance();
-        } else {
-            break;
-        }
+        advanceRun(bytescan::skipBlanks(input.data() + position, input.size() - position));
+        if (eof() || peek() != '\n') break;
+        advance();
     }
 }
 
@@ -194,128 +189,149 @@ bool Lexer::isOperatorStartChar(char c) const {
 
 
 Token Lexer::processNumber() {
-    size_t startLine = line, startColumn = column;
-    std::string number;
+    uint32_t tokenStart = here();
+    size_t start = position;
     bool hasDecimal = false;
     bool hasExponent = false;
     
     
     if (peek() == '0') {
-        number += advance();
+        advance();
         if (peek() == 'x' || peek() == 'X') {
             
-            number += advance();
+            advance();
             while (!eof() && (isDigit(peek()) || (peek() >= 'a' && peek() <= 'f') || (peek() >= 'A' && peek() <= 'F'))) {
-                number += advance();
+                advance();
             }
         } else if (peek() == 'b' || peek() == 'B') {
             
-            number += advance();
+            advance();
             while (!eof() && (peek() == '0' || peek() == '1')) {
-                number += advance();
+                advance();
             }
         } else {
             
             while (!eof() && isDigit(peek())) {
-                number += advance();
+                advance();
             }
         }
     } else {
         
         while (!eof() && isDigit(peek())) {
-            number += advance();
+            advance();
         }
     }
     
     
     if (peek() == '.' && isDigit(peekAdvance())) {
         hasDecimal = true;
-        number += advance(); 
+        advance(); 
         while (!eof() && isDigit(peek())) {
-            number += advance();
+            advance();
         }
     }
     
     
     if (peek() == 'e' || peek() == 'E') {
         hasExponent = true;
-        number += advance();
+        advance();
         if (peek() == '+' || peek() == '-') {
-            number += advance();
+            advance();
         }
         while (!eof() && isDigit(peek())) {
-            number += advance();
+            advance();
         }
     }
     
-    return Token(TokenType::Number, number, startLine, startColumn);
+    return Token(TokenType::Number, sourceSlice(start), tokenStart);
 }
 
 
 Token Lexer::processIdentifierOrKeyword() {
-    size_t startLine = line, startColumn = column;
-    std::string text;
+    uint32_t tokenStart = here();
+    size_t start = position;
     
     while (!eof() && (isAlphaNumeric(peek()) || peek() == '-')) {
-        text += advance();
+        advance();
     }
+    std::string_view text = sourceSlice(start);
     
     
-    if (KEYWORDS.count(text)) {
-        return Token(TokenType::Keyword, text, startLine, startColumn);
+    if (Keyword keyword = lookupKeyword(text); keyword != Keyword::NotKeyword) {
+        return Token(keyword, text, tokenStart);
     }
     
-    return Token(TokenType::Identifier, text, startLine, startColumn);
+    return Token(TokenType::Identifier, intern(text), text, tokenStart);
 }
 
 
 Token Lexer::processString() {
-    size_t startLine = line, startColumn = column;
+    uint32_t tokenStart = here();
     char quote = peek(); 
     advance(); 
     
-    std::string value;
+    // The body is a plain view into the source until the first escape
+    // sequence; from there on it is rebuilt in scratch and copied into the
+    // string arena once complete.
+    size_t bodyStart = position;
+    bool materialized = false;
     
     bool closed = false;
     while (!eof()) {
+        size_t run = bytescan::findAny(input.data() + position, input.size() - position, quote, '\\', '\r', '\r');
+        if (materialized) {
+            scratch.append(input, position, run);
+        }
+        advanceRun(run);
+        if (eof()) break;
         if (peek() == quote) {
             closed = true;
-            advance();
             break;
         }
         if (peek() == '\\') {
+            if (!materialized) {
+                scratch.assign(input, bodyStart, position - bodyStart);
+                materialized = true;
+            }
             advance();
             if (eof()) break;
+            size_t escapeStart = position;
             char escaped = advance();
             switch (escaped) {
-                case 'n': value += '\n'; break;
-                case 't': value += '\t'; break;
-                case 'r': value += '\r'; break;
-                case '\\': value += '\\'; break;
-                case '\'': value += '\''; break;
-                case '"': value += '"'; break;
-                case '0': value += '\0'; break;
-                default: value += escaped; break;
+                case 'n': scratch += '\n'; break;
+                case 't': scratch += '\t'; break;
+                case 'r': scratch += '\r'; break;
+                case '\\': scratch += '\\'; break;
+                case '\'': scratch += '\''; break;
+                case '"': scratch += '"'; break;
+                case '0': scratch += '\0'; break;
+                default: scratch.append(input, escapeStart, position - escapeStart); break;
             }
         } else {
             
             if (peek() == '\n' || peek() == '\r') {
                 break;
             }
-            value += advance();
+            size_t charStart = position;
+            advance();
+            if (materialized) {
+                scratch.append(input, charStart, position - charStart);
+            }
         }
     }
+    std::string_view value = materialized ? strings.copy(scratch) : sourceSlice(bodyStart);
     if (!closed) {
         
         recoverFromError();
-        return Token(TokenType::Error, value, startLine, startColumn, "Unclosed or malformed string literal");
+        return createErrorToken(TokenType::Error, value, tokenStart, "Unclosed or malformed string literal");
     }
-    return Token(TokenType::String, value, startLine, startColumn);
+    advance();
+    return Token(TokenType::String, value, tokenStart);
 }
 
 
 Token Lexer::processOperator() {
-    size_t startLine = line, startColumn = column;
+    uint32_t tokenStart = here();
     char first = peek();
     char second = peekAdvance();
 
@@ -324,41 +340,45 @@ Token Lexer::processOperator() {
         return processComment();
     }
 
-    std::string twoChar;
-    twoChar += first;
-    twoChar += second;
-
-    if (MULTI_CHAR_OPERATORS.count(twoChar)) {
+    size_t start = position;
+    TokenType pairType = twoCharOperator(first, second);
+    if (pairType != TokenType::Unknown) {
         advance(); 
         advance(); 
-        return Token(MULTI_CHAR_OPERATORS.at(twoChar), twoChar, startLine, startColumn);
+        return Token(pairType, sourceSlice(start), tokenStart);
     }
 
     char op = advance();
     switch (op) {
-        case '=': return Token(TokenType::Equals, "=", startLine, startColumn);
-        case '+': case '-': case '*': case '/': case '%':
-        case '<': case '>': case '!': case '&': case '|':
-        case '^': case '~':
+        case '=': return Token(TokenType::Equals, "=", tokenStart);
+        case '+': return Token(TokenType::Plus, sourceSlice(start), tokenStart);
+        case '-': return Token(TokenType::Minus, sourceSlice(start), tokenStart);
+        case '*': return Token(TokenType::Multiply, sourceSlice(start), tokenStart);
+        case '/': return Token(TokenType::Divide, sourceSlice(start), tokenStart);
+        case '%': return Token(TokenType::Modulo, sourceSlice(start), tokenStart);
+        case '<': return Token(TokenType::Less, sourceSlice(start), tokenStart);
+        case '>': return Token(TokenType::Greater, sourceSlice(start), tokenStart);
+        case '!': return Token(TokenType::LogicalNot, sourceSlice(start), tokenStart);
+        case '&': case '|': case '^': case '~':
         case '#': case '$': case '?': case '@':
-            return Token(TokenType::Operator, std::string(1, op), startLine, startColumn);
-        case '(': return Token(TokenType::ParenOpen, "(", startLine, startColumn);
-        case ')': return Token(TokenType::ParenClose, ")", startLine, startColumn);
-        case '{': return Token(TokenType::BraceOpen, "{", startLine, startColumn);
-        case '}': return Token(TokenType::BraceClose, "}", startLine, startColumn);
-        case '[': return Token(TokenType::SquareBracketOpen, "[", startLine, startColumn);
-        case ']': return Token(TokenType::SquareBracketClose, "]", startLine, startColumn);
-        case ':': return Token(TokenType::Colon, ":", startLine, startColumn);
-        case ';': return Token(TokenType::SemiColon, ";", startLine, startColumn);
-        case ',': return Token(TokenType::Comma, ",", startLine, startColumn);
-        case '.': return Token(TokenType::Dot, ".", startLine, startColumn);
-        default: return Token(TokenType::Unknown, std::string(1, op), startLine, startColumn);
+            return Token(TokenType::Operator, sourceSlice(start), tokenStart);
+        case '(': return Token(TokenType::ParenOpen, "(", tokenStart);
+        case ')': return Token(TokenType::ParenClose, ")", tokenStart);
+        case '{': return Token(TokenType::BraceOpen, "{", tokenStart);
+        case '}': return Token(TokenType::BraceClose, "}", tokenStart);
+        case '[': return Token(TokenType::SquareBracketOpen, "[", tokenStart);
+        case ']': return Token(TokenType::SquareBracketClose, "]", tokenStart);
+        case ':': return Token(TokenType::Colon, ":", tokenStart);
+        case ';': return Token(TokenType::SemiColon, ";", tokenStart);
+        case ',': return Token(TokenType::Comma, ",", tokenStart);
+        case '.': return Token(TokenType::Dot, ".", tokenStart);
+        default: return Token(TokenType::Unknown, sourceSlice(start), tokenStart);
     }
 }
 
 
 Token Lexer::processTag() {
-    size_t startLine = line, startColumn = column;
+    uint32_t tokenStart = here();
     advance(); 
     
     
@@ -366,28 +386,30 @@ Token Lexer::processTag() {
         return processTagEnd();
     }
     
-    std::string tagName;
+    size_t nameStart = position;
     while (!eof() && (isAlphaNumeric(peek()) || peek() == '-')) {
-        tagName += advance();
+        advance();
     }
+    std::string_view tagName = sourceSlice(nameStart);
     
     if (tagName.empty()) {
-        return Token(TokenType::Error, "<", startLine, startColumn, "Invalid tag: expected tag name");
+        return createErrorToken(TokenType::Error, "<", tokenStart, "Invalid tag: expected tag name");
     }
     
     enterState(LexerState::ALTXAttribute);
-    return Token(TokenType::TagOpen, tagName, startLine, startColumn);
+    return Token(TokenType::TagOpen, intern(tagName), tagName, tokenStart);
 }
 
 
 Token Lexer::processTagEnd() {
-    size_t startLine = line, startColumn = column;
+    uint32_t tokenStart = here();
     advance(); 
     
-    std::string tagName;
+    size_t nameStart = position;
     while (!eof() && (isAlphaNumeric(peek()) || peek() == '-')) {
-        tagName += advance();
+        advance();
     }
+    std::string_view tagName = sourceSlice(nameStart);
     
     
     skipWhitespace();
@@ -399,80 +421,73 @@ Token Lexer::processTagEnd() {
         exitState();
     }
     
-    return Token(TokenType::TagClose, tagName, startLine, startColumn);
+    return Token(TokenType::TagClose, intern(tagName), tagName, tokenStart);
 }
 
 
 Token Lexer::processComment() {
-    size_t startLine = line, startColumn = column;
-    std::string commentText;
-    
-    std::ofstream debugLog("lexer-debug.log", std::ios::app);
+    uint32_t tokenStart = here();
+    size_t start = position;
     
     if (peek() == '/' && peekAdvance() == '/') {
-        commentText += advance(); 
-        commentText += advance(); 
-        while (!eof() && peek() != '\n') {
-            commentText += advance();
+        advance(); 
+        advance(); 
+        while (!eof()) {
+            advanceRun(bytescan::findAny(input.data() + position, input.size() - position, '\n', '\n', '\n', '\n'));
+            if (eof() || peek() == '\n') break;
+            advance();
         }
         
+        std::string_view commentText = sourceSlice(start);
+        
         if (!eof() && peek() == '\n') {
             advance();
         }
-        if (debugLog) {
-            debugLog << "[processComment] Single-line: '" << commentText << "' at " << startLine << ":" << startColumn << "\n";
-        }
-        return Token(TokenType::Comment, commentText, startLine, startColumn);
+        LEXER_TRACE(trace, TraceLevel::Debug, "comment.line", commentText, lines().locate(tokenStart));
+        return Token(TokenType::Comment, commentText, tokenStart);
     }
     
     if (peek() == '/' && peekAdvance() == '*') {
-        commentText += advance(); 
-        commentText += advance(); 
+        advance(); 
+        advance(); 
         while (!eof()) {
+            advanceRun(bytescan::findAny(input.data() + position, input.size() - position, '*', '*', '*', '*'));
+            if (eof()) break;
             if (peek() == '*' && peekAdvance() == '/') {
-                commentText += advance(); 
-                commentText += advance(); 
-                if (debugLog) {
-                    debugLog << "[processComment] Multi-line: '" << commentText << "' at " << startLine << ":" << startColumn << "\n";
-                }
-                return Token(TokenType::Comment, commentText, startLine, startColumn);
+                advance(); 
+                advance(); 
+                std::string_view commentText = sourceSlice(start);
+                LEXER_TRACE(trace, TraceLevel::Debug, "comment.block", commentText, lines().locate(tokenStart));
+                return Token(TokenType::Comment, commentText, tokenStart);
             }
-            commentText += advance();
+            advance();
         }
         
-        if (debugLog) {
-            debugLog << "[processComment] Unterminated multi-line: '" << commentText << "' at " << startLine << ":" << startColumn << "\n";
-        }
-        return Token(TokenType::Error, commentText, startLine, startColumn, "Unterminated multi-line comment");
+        std::string_view commentText = sourceSlice(start);
+        return createErrorToken(TokenType::Error, commentText, tokenStart, "Unterminated multi-line comment");
     }
     
-    char invalid = advance();
-    if (debugLog) {
-        debugLog << "[processComment] Invalid start: '" << invalid << "' at " << startLine << ":" << startColumn << "\n";
-    }
-    return Token(TokenType::Error, std::string(1, invalid), startLine, startColumn, "Invalid comment start");
+    advance();
+    return createErrorToken(TokenType::Error, sourceSlice(start), tokenStart, "Invalid comment start");
 }
 
 
 Token Lexer::processTextContent() {
-    size_t startLine = line, startColumn = column;
-    std::string text;
+    uint32_t tokenStart = here();
+    size_t start = position;
     
     
+    // Text runs over blanks, control characters, '`' and '\\'; every other
+    // byte can start a token (see processALTXContent).
     while (!eof()) {
-        char c = peek();
-        
-        if (isAlpha(c) || isDigit(c) || isOperatorStartChar(c) ||
-            c == '<' || c == '{' || c == '}' || c == '>' || c == '[' || c == ']' ||
-            c == '(' || c == ')' || c == '=' || c == ':' || c == ';' || c == ',' ||
-            c == '"' || c == '\'' || c == '/' || c == '@' || c == '!') {
-            break;
-        }
-        text += advance();
+        advanceRun(bytescan::skipText(input.data() + position, input.size() - position));
+        if (eof() || peek() != '\n') break;
+        advance();
     }
+    std::string_view text = sourceSlice(start);
     
     if (!text.empty()) {
-        return Token(TokenType::Text, text, startLine, startColumn);
+        return Token(TokenType::Text, text, tokenStart);
     }
     
     return nextToken();
@@ -480,32 +495,33 @@ Token Lexer::processTextContent() {
 
 
 Token Lexer::processValueBinding() {
-    size_t startLine = line, startColumn = column;
+    uint32_t tokenStart = here();
+    size_t start = position;
     advance(); 
     
-    std::string identifier;
+    size_t identifierStart = position;
     while (!eof() && (isAlphaNumeric(peek()) || peek() == '_')) {
-        identifier += advance();
+        advance();
     }
     
-    if (identifier.empty()) {
-        return Token(TokenType::Error, "!", startLine, startColumn, "Expected identifier after '!'");
+    if (position == identifierStart) {
+        return createErrorToken(TokenType::Error, "!", tokenStart, "Expected identifier after '!'");
     }
     
-    return Token(TokenType::ValueBinding, "!" + identifier, startLine, startColumn);
+    return Token(TokenType::ValueBinding, intern(sourceSlice(identifierStart)), sourceSlice(start), tokenStart);
 }
 
 
 Token Lexer::processStyleProperty() {
-    size_t startLine = line, startColumn = column;
-    std::string property;
+    uint32_t tokenStart = here();
+    size_t start = position;
     
     
-    while (!eof() && peek() != ':' && peek() != ';' && peek() != '}' && !std::isspace(peek())) {
-        property += advance();
+    while (!eof() && peek() != ':' && peek() != ';' && peek() != '}' && !std::isspace(static_cast<unsigned char>(peek()))) {
+        advance();
     }
     
-    return Token(TokenType::StyleProperty, property, startLine, startColumn);
+    return Token(TokenType::StyleProperty, sourceSlice(start), tokenStart);
 }
 
 
@@ -516,16 +532,16 @@ Token Lexer::nextToken() {
     while (!eof()) {
         skipWhitespace();
         if (eof()) {
-            return Token(TokenType::EOFToken, "", line, column);
+            return Token(TokenType::EOFToken, "", here());
         }
         char c = peek();
-        size_t startLine = line, startColumn = column;
+        uint32_t tokenStart = here();
         
         if (c == '/' && (peekAdvance() == '/' || peekAdvance() == '*')) {
             Token commentToken = processComment();
             
             skipWhitespace();
-            if (eof()) return Token(TokenType::EOFToken, "", line, column);
+            if (eof()) return Token(TokenType::EOFToken, "", here());
             return commentToken;
         }
         
@@ -555,45 +571,50 @@ Token Lexer::nextToken() {
         if (c == '"' || c == '\'') {
             return processString();
         }
-        if (c == '<') {
+        // `<` opens a tag only when a tag name or `/` follows; otherwise it
+        // is the comparison operator (`a < b`, `a <= b`).
+        if (c == '<' && (isAlpha(peekAdvance()) || peekAdvance() == '/')) {
             return processTag();
         }
         if (c == '@') {
+            size_t start = position;
             advance();
-            std::string modifier;
             while (!eof() && isAlphaNumeric(peek())) {
-                modifier += advance();
+                advance();
             }
-            return Token(TokenType::AtModifier, "@" + modifier, startLine, startColumn);
+            return Token(TokenType::AtModifier, sourceSlice(start), tokenStart);
         }
-        if (c == '!') {
+        // `!name` is a value binding; `!=` is an operator.
+        if (c == '!' && peekAdvance() != '=') {
             return processValueBinding();
         }
         if (c == '{') {
             advance();
             enterState(LexerState::Expression);
-            return Token(TokenType::ExpressionStart, "{", startLine, startColumn);
+            return Token(TokenType::ExpressionStart, "{", tokenStart);
         }
         if (c == '(') {
             advance();
-            return Token(TokenType::ParenOpen, "(", startLine, startColumn);
+            return Token(TokenType::ParenOpen, "(", tokenStart);
         }
         if (c == ')') {
             advance();
-            return Token(TokenType::ParenClose, ")", startLine, startColumn);
+            return Token(TokenType::ParenClose, ")", tokenStart);
         }
         if (c == '\\') {
             advance();
-            return Token(TokenType::Error, "\\", startLine, startColumn, "Unexpected backslash");
+            return createErrorToken(TokenType::Error, "\\", tokenStart, "Unexpected backslash");
         }
         if (isOperatorStartChar(c)) {
             return processOperator();
         }
         
-        return Token(TokenType::Unknown, std::string(1, advance()), startLine, startColumn);
+        size_t start = position;
+        advance();
+        return Token(TokenType::Unknown, sourceSlice(start), tokenStart);
     }
     
-    return Token(TokenType::EOFToken, "", line, column);
+    return Token(TokenType::EOFToken, "", here());
 }
 
 
@@ -602,25 +623,31 @@ Token Lexer::processALTXAttribute() {
     
     if (eof()) {
         exitState();
-        return Token(TokenType::EOFToken, "", line, column);
+        return Token(TokenType::EOFToken, "", here());
     }
     
     char c = peek();
-    size_t startLine = line, startColumn = column;
+    uint32_t tokenStart = here();
     
     
     if (c == '/' && (peekAdvance() == '/' || peekAdvance() == '*')) {
         Token commentToken = processComment();
         skipWhitespace();
-        if (eof()) return Token(TokenType::EOFToken, "", line, column);
+        if (eof()) return Token(TokenType::EOFToken, "", here());
         return commentToken;
     }
+    if (c == '/' && peekAdvance() == '>') {
+        advance(); 
+        advance(); 
+        exitState();
+        return Token(TokenType::TagSelfClose, "/>", tokenStart);
+    }
     if (c == '/') {
         // Check for comment before operator
         if (peekAdvance() == '/' || peekAdvance() == '*') {
             Token commentToken = processComment();
             skipWhitespace();
-            if (eof()) return Token(TokenType::EOFToken, "", line, column);
+            if (eof()) return Token(TokenType::EOFToken, "", here());
             return commentToken;
         }
         return processOperator();
@@ -629,40 +656,35 @@ Token Lexer::processALTXAttribute() {
     
     if (c == '>') {
         advance();
-        state = LexerState::ALTXContent; 
-        return Token(TokenType::TagEnd, ">", startLine, startColumn);
-    }
-    
-    if (c == '/' && peekAdvance() == '>') {
-        advance(); 
-        advance(); 
-        exitState();
-        return Token(TokenType::TagSelfClose, "/>", startLine, startColumn);
+        state = LexerState::ALTXContent;
+        LEXER_TRACE(trace, TraceLevel::Verbose, "state.switch", stateName(state), lines().locate(here()));
+        return Token(TokenType::TagEnd, ">", tokenStart);
     }
     
     
     if (c == '{') {
         advance();
         enterState(LexerState::Expression);
-        return Token(TokenType::ExpressionStart, "{", startLine, startColumn);
+        return Token(TokenType::ExpressionStart, "{", tokenStart);
     }
     
     
     if (isAlpha(c)) {
-        std::string attrName;
+        size_t start = position;
         while (!eof() && (isAlphaNumeric(peek()) || peek() == '-' || peek() == '_')) {
-            attrName += advance();
+            advance();
         }
-        if (KEYWORDS.count(attrName)) {
-            return Token(TokenType::Keyword, attrName, startLine, startColumn);
+        std::string_view attrName = sourceSlice(start);
+        if (Keyword keyword = lookupKeyword(attrName); keyword != Keyword::NotKeyword) {
+            return Token(keyword, attrName, tokenStart);
         }
-        return Token(TokenType::AttributeName, attrName, startLine, startColumn);
+        return Token(TokenType::AttributeName, intern(attrName), attrName, tokenStart);
     }
     
     
     if (c == '=') {
         advance();
-        return Token(TokenType::Equals, "=", startLine, startColumn);
+        return Token(TokenType::Equals, "=", tokenStart);
     }
     
     if (c == '"' || c == '\'') {
@@ -680,16 +702,17 @@ Token Lexer::processALTXContent() {
     
     if (eof()) {
         exitState();
-        return Token(TokenType::EOFToken, "", line, column);
+        return Token(TokenType::EOFToken, "", here());
     }
     
     char c = peek();
+    uint32_t tokenStart = here();
     
     
     if (c == '/' && (peekAdvance() == '/' || peekAdvance() == '*')) {
         Token commentToken = processComment();
         skipWhitespace();
-        if (eof()) return Token(TokenType::EOFToken, "", line, column);
+        if (eof()) return Token(TokenType::EOFToken, "", here());
         return commentToken;
     }
     if (c == '/') {
@@ -697,7 +720,7 @@ Token Lexer::processALTXContent() {
         if (peekAdvance() == '/' || peekAdvance() == '*') {
             Token commentToken = processComment();
             skipWhitespace();
-            if (eof()) return Token(TokenType::EOFToken, "", line, column);
+            if (eof()) return Token(TokenType::EOFToken, "", here());
             return commentToken;
         }
         return processOperator();
@@ -708,6 +731,7 @@ Token Lexer::processALTXContent() {
         if (peekAdvance() == '/') {
             
             exitState();
+            advance();   // processTagEnd() starts at the '/'
             return processTagEnd();
         } else {
             
@@ -719,7 +743,7 @@ Token Lexer::processALTXContent() {
     if (c == '{') {
         advance();
         enterState(LexerState::Expression);
-        return Token(TokenType::ExpressionStart, "{", line, column);
+        return Token(TokenType::ExpressionStart, "{", tokenStart);
     }
     
     
@@ -758,17 +782,17 @@ Token Lexer::processExpression() {
     
     if (eof()) {
         exitState();
-        return Token(TokenType::EOFToken, "", line, column);
+        return Token(TokenType::EOFToken, "", here());
     }
     
     char c = peek();
-    size_t startLine = line, startColumn = column;
+    uint32_t tokenStart = here();
     
     
     if (c == '/' && (peekAdvance() == '/' || peekAdvance() == '*')) {
         Token commentToken = processComment();
         skipWhitespace();
-        if (eof()) return Token(TokenType::EOFToken, "", line, column);
+        if (eof()) return Token(TokenType::EOFToken, "", here());
         return commentToken;
     }
     if (c == '/') {
@@ -776,7 +800,7 @@ Token Lexer::processExpression() {
         if (peekAdvance() == '/' || peekAdvance() == '*') {
             Token commentToken = processComment();
             skipWhitespace();
-            if (eof()) return Token(TokenType::EOFToken, "", line, column);
+            if (eof()) return Token(TokenType::EOFToken, "", here());
             return commentToken;
         }
         return processOperator();
@@ -786,18 +810,18 @@ Token Lexer::processExpression() {
     if (c == '}') {
         advance();
         exitState();
-        return Token(TokenType::ExpressionEnd, "}", startLine, startColumn);
+        return Token(TokenType::ExpressionEnd, "}", tokenStart);
     }
     
     
     if (c == '(') {
         advance();
-        return Token(TokenType::ParenOpen, "(", startLine, startColumn);
+        return Token(TokenType::ParenOpen, "(", tokenStart);
     }
     
     if (c == ')') {
         advance();
-        return Token(TokenType::ParenClose, ")", startLine, startColumn);
+        return Token(TokenType::ParenClose, ")", tokenStart);
     }
     
     
@@ -813,7 +837,7 @@ Token Lexer::processExpression() {
         return processString();
     }
     
-    if (c == '!') {
+    if (c == '!' && peekAdvance() != '=') {
         return processValueBinding();
     }
     
@@ -822,7 +846,9 @@ Token Lexer::processExpression() {
     }
     
     
-    return Token(TokenType::Unknown, std::string(1, advance()), startLine, startColumn);
+    size_t start = position;
+    advance();
+    return Token(TokenType::Unknown, sourceSlice(start), tokenStart);
 }
 
 
@@ -833,11 +859,25 @@ Token Lexer::processStyleValue() {
 }
 
 
+Token Lexer::next() {
+    if (finished) {
+        return Token(TokenType::EOFToken, "", here());
+    }
+    Token token = nextToken();
+    LEXER_TRACE(trace, TraceLevel::Verbose, getTokenTypeName(token.type), token.value, lines().locate(token.offset));
+    if (token.type == TokenType::EOFToken) {
+        finished = true;
+        trace.flush();
+    }
+    return token;
+}
+
 std::vector<Token> Lexer::tokenize() {
+    PhaseTimer timer("lex");
     std::vector<Token> tokens;
     
     while (true) {
-        Token token = nextToken();
+        Token token = next();
         tokens.push_back(token);
         
         if (token.type == TokenType::EOFToken) {
@@ -848,6 +888,36 @@ std::vector<Token> Lexer::tokenize() {
     return tokens;
 }
 
+TokenBuffer Lexer::tokenizeBuffer() {
+    PhaseTimer timer("lex");
+    TokenBuffer tokens;
+
+    while (true) {
+        Token token = next();
+        bool end = token.type == TokenType::EOFToken;
+        tokens.push(token);
+
+        if (end) {
+            break;
+        }
+    }
+
+    return tokens;
+}
+
+Lexer::Iterator& Lexer::Iterator::operator++() {
+    if (current.type == TokenType::EOFToken) {
+        lexer = nullptr;
+    } else {
+        current = lexer->next();
+    }
+    return *this;
+}
+
+void Lexer::setTrace(std::ostream& sink, TraceLevel level) {
+    trace.open(sink, level);
+}
+
 std::string Lexer::getTokenTypeName(TokenType type) const {
     switch (type) {
         case TokenType::Identifier: return "Identifier";
@@ -856,6 +926,28 @@ std::string Lexer::getTokenTypeName(TokenType type) const {
         case TokenType::String: return "String";
         case TokenType::Operator: return "Operator";
         case TokenType::Arrow: return "Arrow";
+        case TokenType::Plus: return "Plus";
+        case TokenType::Minus: return "Minus";
+        case TokenType::Multiply: return "Multiply";
+        case TokenType::Divide: return "Divide";
+        case TokenType::Modulo: return "Modulo";
+        case TokenType::Power: return "Power";
+        case TokenType::PlusAssign: return "PlusAssign";
+        case TokenType::MinusAssign: return "MinusAssign";
+        case TokenType::MultiplyAssign: return "MultiplyAssign";
+        case TokenType::DivideAssign: return "DivideAssign";
+        case TokenType::ModuloAssign: return "ModuloAssign";
+        case TokenType::Equal: return "Equal";
+        case TokenType::NotEqual: return "NotEqual";
+        case TokenType::Less: return "Less";
+        case TokenType::LessEqual: return "LessEqual";
+        case TokenType::Greater: return "Greater";
+        case TokenType::GreaterEqual: return "GreaterEqual";
+        case TokenType::LogicalAnd: return "LogicalAnd";
+        case TokenType::LogicalOr: return "LogicalOr";
+        case TokenType::LogicalNot: return "LogicalNot";
+        case TokenType::Increment: return "Increment";
+        case TokenType::Decrement: return "Decrement";
         case TokenType::TagOpen: return "TagOpen";
         case TokenType::TagClose: return "TagClose";
         case TokenType::TagSelfClose: return "TagSelfClose";
@@ -897,18 +989,29 @@ void Lexer::debugPrintTokens(const std::vector<Token>& tokens) const {
                   << std::setw(15) << getTokenTypeName(token.type) 
                   << " '" << token.value << "'";
         
-        if (token.error.has_value()) {
-            std::cout << " [ERROR: " << *token.error << "]";
+        if (const LexError* error = errorFor(token)) {
+            std::cout << " [ERROR: " << error->message << "]";
         }
         
-        std::cout << " (" << token.line << ":" << token.column << ")" << std::endl;
+        SourceLocation at = lines().locate(token.offset);
+        std::cout << " (" << at.line << ":" << at.column << ")" << std::endl;
     }
     std::cout << "=== END TOKEN STREAM ===" << std::endl;
 }
 
 
-Token Lexer::createErrorToken(const std::string& lexeme, const std::string& message) {
-    return Token(TokenType::Error, lexeme, line, column, message);
+Token Lexer::createErrorToken(std::string_view lexeme, const std::string& message) {
+    return createErrorToken(TokenType::Error, lexeme, here(), message);
+}
+
+Token Lexer::createErrorToken(TokenType type, std::string_view lexeme, uint32_t errOffset, const std::string& message) {
+    LEXER_TRACE(trace, TraceLevel::Debug, "error", message, lines().locate(errOffset));
+    errorTable.push_back({errOffset, message});
+    return Token(type, lexeme, errOffset, static_cast<uint32_t>(errorTable.size() - 1));
+}
+
+std::string_view Lexer::sourceSlice(size_t start) const {
+    return input.substr(start, position - start);
 }
 
 
@@ -929,6 +1032,6 @@ Token Lexer::safeNextToken() {
         return nextToken();
     } catch (const std::exception& e) {
         recoverFromError();
-        return Token(TokenType::ErrorRecovery, "", line, column, e.what());
+        return createErrorToken(TokenType::ErrorRecovery, "", here(), e.what());
     }
 }
\ No newline at end of file
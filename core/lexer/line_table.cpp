@@ -0,0 +1,28 @@
+#include "../include/line_table.h"
+#include "../include/byte_scan.h"
+#include "../include/utf8_utils.h"
+#include <algorithm>
+
+LineTable::LineTable(std::string_view source) : text(source) {
+    // Typical sources run 20-40 bytes a line.
+    starts.reserve(text.size() / 32 + 1);
+    starts.push_back(0);
+    bytescan::appendLineStarts(text.data(), text.size(), 0, starts);
+}
+
+SourceLocation LineTable::locate(uint32_t offset) const {
+    if (offset == NoOffset) return {};
+    size_t end = std::min<size_t>(offset, text.size());
+    auto after = std::upper_bound(starts.begin(), starts.end(), static_cast<uint32_t>(end));
+    size_t line = static_cast<size_t>(after - starts.begin());
+    return {static_cast<uint32_t>(line), columnOf(text, starts[line - 1], end)};
+}
+
+uint32_t LineTable::columnOf(std::string_view text, size_t lineStart, size_t offset) {
+    size_t end = std::min(offset, text.size());
+    uint32_t column = 1;
+    for (size_t pos = lineStart; pos < end; ++column) {
+        pos += utf8SequenceLength(text, pos);
+    }
+    return column;
+}
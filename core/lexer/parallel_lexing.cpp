@@ -0,0 +1,174 @@
+#include "../include/lexer.h"
+#include "../include/work_stealing_pool.h"
+#include <algorithm>
+
+namespace {
+
+// Start of a line where a chunk may begin.
+struct SplitPoint {
+    size_t offset;
+};
+
+bool isIdentifierByte(char c) {
+    unsigned char uc = static_cast<unsigned char>(c);
+    return (uc >= 'a' && uc <= 'z') || (uc >= 'A' && uc <= 'Z') || (uc >= '0' && uc <= '9') ||
+           uc == '_' || uc == '-' || uc >= 0x80;
+}
+
+// Lines that begin with the `component` keyword at brace depth 0 (or with no
+// indentation at all), outside strings and comments. This is only a cheap
+// guess at where the lexer will be back at top level: tokenizeParallel()
+// confirms every split against the lexer's actual state, so a wrong guess
+// costs time, never correctness.
+// Strings are assumed to end at a newline so that an apostrophe in ALTX text
+// cannot hide the rest of the file.
+std::vector<SplitPoint> findSplitPoints(std::string_view text) {
+    static constexpr std::string_view keyword = "component";
+    std::vector<SplitPoint> points;
+    size_t n = text.size();
+    size_t i = 0;
+    int depth = 0;
+    bool atLineStart = true;
+    size_t lineOffset = 0;
+
+    while (i < n) {
+        if (atLineStart) {
+            atLineStart = false;
+            size_t j = i;
+            while (j < n && (text[j] == ' ' || text[j] == '\t')) ++j;
+            bool isComponent = text.compare(j, keyword.size(), keyword) == 0 &&
+                               (j + keyword.size() == n || !isIdentifierByte(text[j + keyword.size()]));
+            // An unindented `component` resynchronises the depth count, so one
+            // unbalanced brace does not rule out every later split.
+            if (isComponent && j == i) depth = 0;
+            if (isComponent && depth == 0 && lineOffset > 0) points.push_back({lineOffset});
+            i = j;
+            continue;
+        }
+
+        char c = text[i];
+        switch (c) {
+            case '\n':
+                atLineStart = true;
+                lineOffset = ++i;
+                break;
+            case '{':
+                ++depth;
+                ++i;
+                break;
+            case '}':
+                if (depth > 0) --depth;
+                ++i;
+                break;
+            case '"':
+            case '\'':
+            case '`':
+                ++i;
+                while (i < n && text[i] != c && text[i] != '\n') {
+                    i += (text[i] == '\\' && i + 1 < n && text[i + 1] != '\n') ? 2 : 1;
+                }
+                if (i < n && text[i] == c) ++i;
+                break;
+            case '/':
+                if (i + 1 < n && text[i + 1] == '/') {
+                    while (i < n && text[i] != '\n') ++i;
+                } else if (i + 1 < n && text[i + 1] == '*') {
+                    i += 2;
+                    while (i < n && !(text[i] == '*' && i + 1 < n && text[i + 1] == '/')) {
+                        ++i;
+                    }
+                    i = std::min(n, i + 2);
+                } else {
+                    ++i;
+                }
+                break;
+            default:
+                ++i;
+                break;
+        }
+    }
+    return points;
+}
+
+}
+
+std::vector<Token> Lexer::tokenizeParallel(WorkStealingPool& pool, size_t minChunkBytes) {
+    if (finished || position != 0) return tokenize();
+
+    size_t wanted = std::min(input.size() / std::max<size_t>(minChunkBytes, 1), size_t(pool.size()) * 4);
+    if (wanted < 2) return tokenize();
+
+    std::vector<SplitPoint> starts{{0}};
+    size_t spacing = input.size() / wanted;
+    for (const SplitPoint& point : findSplitPoints(input)) {
+        if (point.offset - starts.back().offset >= spacing) starts.push_back(point);
+    }
+    if (starts.size() < 2) return tokenize();
+
+    struct Chunk {
+        std::unique_ptr<Lexer> lexer;
+        std::vector<Token> tokens;
+        size_t errorCount = 0;   // errors belonging to `tokens`
+        size_t resumeAt = 0;     // chunk whose tokens follow these
+    };
+    std::vector<Chunk> chunks(starts.size());
+
+    // Each chunk is lexed from its own start until its lexer reaches a later
+    // split point while at top level with only whitespace since its previous
+    // token. There a fresh lexer (the later chunk's) produces exactly what this
+    // one would, so lexing stops. If the lexer is still inside ALTX or an
+    // expression at a split point, that point was a bad guess: this chunk keeps
+    // going and the later chunk's result is simply never used.
+    for (size_t k = 0; k < chunks.size(); ++k) {
+        pool.submit([this, &starts, &chunks, k] {
+            Chunk& chunk = chunks[k];
+            chunk.lexer.reset(new Lexer(source, LexerCheckpoint{starts[k].offset, LexerState::Normal, {}}));
+            Lexer& lexer = *chunk.lexer;
+            size_t next = k + 1;
+            while (true) {
+                bool topLevel = lexer.atTopLevel();
+                size_t before = lexer.position;
+                size_t errorsBefore = lexer.errorTable.size();
+                Token token = lexer.next();
+
+                bool stop = false;
+                while (next < starts.size() && token.offset >= starts[next].offset) {
+                    if (topLevel && before <= starts[next].offset) {
+                        stop = true;
+                        break;
+                    }
+                    ++next;
+                }
+                if (stop) {
+                    chunk.errorCount = errorsBefore;
+                    break;
+                }
+                chunk.tokens.push_back(token);
+                if (token.type == TokenType::EOFToken) {
+                    chunk.errorCount = lexer.errorTable.size();
+                    next = starts.size();
+                    break;
+                }
+            }
+            chunk.resumeAt = next;
+        });
+    }
+    pool.wait();
+
+    std::vector<Token> tokens;
+    for (size_t k = 0; k < chunks.size(); k = chunks[k].resumeAt) {
+        Chunk& chunk = chunks[k];
+        chunkLexers.push_back(std::move(chunk.lexer));
+        const Lexer& lexer = *chunkLexers.back();
+        uint32_t errorBase = static_cast<uint32_t>(errorTable.size());
+        errorTable.insert(errorTable.end(), lexer.errorTable.begin(), lexer.errorTable.begin() + chunk.errorCount);
+        for (Token token : chunk.tokens) {
+            if (token.hasError()) token.errorIndex += errorBase;
+            tokens.push_back(token);
+        }
+    }
+
+    position = input.size();
+    finished = true;
+    return tokens;
+}
@@ -0,0 +1,153 @@
+#include "../include/source_buffer.h"
+#include <cstdint>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::shared_ptr<const SourceBuffer> SourceBuffer::fromString(std::string text) {
+    std::shared_ptr<SourceBuffer> buffer(new SourceBuffer());
+    buffer->owned = std::move(text);
+    buffer->view = buffer->owned;
+    return buffer;
+}
+
+std::shared_ptr<const SourceBuffer> SourceBuffer::borrow(std::string_view text) {
+    std::shared_ptr<SourceBuffer> buffer(new SourceBuffer());
+    buffer->view = text;
+    return buffer;
+}
+
+const LineTable& SourceBuffer::lines() const {
+    std::call_once(linesBuilt, [this] { lineTable = std::make_unique<LineTable>(view); });
+    return *lineTable;
+}
+
+std::shared_ptr<const SourceBuffer> SourceBuffer::fromStdin() {
+#ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+    return readStream(_fileno(stdin));
+#else
+    return readStream(STDIN_FILENO);
+#endif
+}
+
+#ifdef _WIN32
+
+std::shared_ptr<const SourceBuffer> SourceBuffer::readStream(int fd) {
+    std::string data;
+    char chunk[64 * 1024];
+    int n;
+    while ((n = _read(fd, chunk, sizeof(chunk))) > 0) {
+        data.append(chunk, static_cast<size_t>(n));
+        if (data.size() > MaxSize) return nullptr;
+    }
+    if (n < 0) return nullptr;
+    return fromString(std::move(data));
+}
+
+std::shared_ptr<const SourceBuffer> SourceBuffer::fromFile(const std::string& path) {
+    if (path == "-") return fromStdin();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return nullptr;
+
+    LARGE_INTEGER size;
+    bool disk = GetFileType(file) == FILE_TYPE_DISK && GetFileSizeEx(file, &size);
+    if (disk && static_cast<uint64_t>(size.QuadPart) > MaxSize) {
+        CloseHandle(file);
+        return nullptr;
+    }
+    if (!disk || size.QuadPart == 0) {
+        int fd = _open_osfhandle(reinterpret_cast<intptr_t>(file), _O_RDONLY | _O_BINARY);
+        if (fd < 0) {
+            CloseHandle(file);
+            return nullptr;
+        }
+        auto buffer = readStream(fd);
+        _close(fd);
+        return buffer;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) return nullptr;
+    void* base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!base) return nullptr;
+
+    std::shared_ptr<SourceBuffer> buffer(new SourceBuffer());
+    buffer->mapping = base;
+    buffer->mappingSize = static_cast<size_t>(size.QuadPart);
+    buffer->view = std::string_view(static_cast<const char*>(base), buffer->mappingSize);
+    return buffer;
+}
+
+SourceBuffer::~SourceBuffer() {
+    if (mapping) UnmapViewOfFile(mapping);
+}
+
+#else
+
+std::shared_ptr<const SourceBuffer> SourceBuffer::readStream(int fd) {
+    std::string data;
+    char chunk[64 * 1024];
+    ssize_t n;
+    while ((n = read(fd, chunk, sizeof(chunk))) != 0) {
+        if (n < 0) return nullptr;
+        data.append(chunk, static_cast<size_t>(n));
+        if (data.size() > MaxSize) return nullptr;
+    }
+    return fromString(std::move(data));
+}
+
+std::shared_ptr<const SourceBuffer> SourceBuffer::fromFile(const std::string& path) {
+    if (path == "-") return fromStdin();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+        auto buffer = readStream(fd);
+        close(fd);
+        return buffer;
+    }
+
+    if (static_cast<uint64_t>(info.st_size) > MaxSize) {
+        close(fd);
+        return nullptr;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* base = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED) {
+        auto buffer = readStream(fd);
+        close(fd);
+        return buffer;
+    }
+    close(fd);
+#ifdef MADV_SEQUENTIAL
+    madvise(base, size, MADV_SEQUENTIAL);
+#endif
+
+    std::shared_ptr<SourceBuffer> buffer(new SourceBuffer());
+    buffer->mapping = base;
+    buffer->mappingSize = size;
+    buffer->view = std::string_view(static_cast<const char*>(base), size);
+    return buffer;
+}
+
+SourceBuffer::~SourceBuffer() {
+    if (mapping) munmap(mapping, mappingSize);
+}
+
+#endif
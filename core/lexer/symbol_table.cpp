@@ -0,0 +1,127 @@
+#include "../include/symbol_table.h"
+#include <stdexcept>
+
+namespace {
+
+uint64_t hashText(std::string_view text) {
+    uint64_t h = 14695981039346656037ull;
+    for (char c : text) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// Per-thread cache in front of the global table. Entries point at interned
+// text, which is never freed, so a stale entry is merely a miss.
+struct CacheEntry {
+    std::string_view text;
+    Symbol symbol;
+};
+
+constexpr size_t CacheSize = 1024;
+
+thread_local CacheEntry cache[CacheSize];
+
+}
+
+SymbolTable& SymbolTable::global() {
+    // Never destroyed: symbols and cached views must stay valid during
+    // static destruction and on threads that outlive main.
+    static SymbolTable* table = new SymbolTable();
+    return *table;
+}
+
+SymbolTable::SymbolTable() = default;
+
+SymbolTable::~SymbolTable() {
+    for (Shard& shard : shards) {
+        for (auto& segment : shard.segments) {
+            delete[] segment.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+Symbol SymbolTable::intern(std::string_view text) {
+    if (text.empty()) return Symbol{};
+
+    uint64_t hash = hashText(text);
+    bool cached = this == &global();
+    CacheEntry* entry = cached ? &cache[(hash >> 20) & (CacheSize - 1)] : nullptr;
+    if (entry && entry->text == text) return entry->symbol;
+
+    size_t shardIndex = hash & (ShardCount - 1);
+    Shard& shard = shards[shardIndex];
+    Symbol symbol;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        symbol = insert(shard, shardIndex, text, hash);
+    }
+
+    if (entry) *entry = CacheEntry{this->text(symbol), symbol};
+    return symbol;
+}
+
+std::string_view SymbolTable::text(Symbol symbol) const {
+    if (symbol.empty()) return {};
+    const Shard& shard = shards[symbol.id & (ShardCount - 1)];
+    return slot(shard, (symbol.id >> ShardBits) - 1);
+}
+
+size_t SymbolTable::size() const {
+    size_t total = 0;
+    for (const Shard& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.count;
+    }
+    return total;
+}
+
+Symbol SymbolTable::insert(Shard& shard, size_t shardIndex, std::string_view text, uint64_t hash) {
+    if ((shard.count + 1) * 4 > shard.index.size() * 3) growIndex(shard);
+
+    uint32_t shortHash = static_cast<uint32_t>(hash >> 32);
+    size_t mask = shard.index.size() - 1;
+    size_t position = (hash >> ShardBits) & mask;
+    for (;; position = (position + 1) & mask) {
+        uint32_t stored = shard.index[position];
+        if (stored == 0) break;
+        if (shard.hashes[stored - 1] == shortHash && slot(shard, stored - 1) == text) {
+            return Symbol{(stored << ShardBits) | static_cast<uint32_t>(shardIndex)};
+        }
+    }
+
+    uint32_t slotIndex = shard.count;
+    size_t segmentIndex = slotIndex >> SegmentBits;
+    if (segmentIndex >= MaxSegments) throw std::length_error("symbol table full");
+
+    std::string_view* segment = shard.segments[segmentIndex].load(std::memory_order_relaxed);
+    if (!segment) {
+        segment = new std::string_view[SegmentSize];
+        shard.segments[segmentIndex].store(segment, std::memory_order_release);
+    }
+    segment[slotIndex & (SegmentSize - 1)] = shard.storage.copy(text);
+    shard.hashes.push_back(shortHash);
+    shard.index[position] = slotIndex + 1;
+    ++shard.count;
+
+    return Symbol{((slotIndex + 1) << ShardBits) | static_cast<uint32_t>(shardIndex)};
+}
+
+void SymbolTable::growIndex(Shard& shard) {
+    std::vector<uint32_t> index(shard.index.empty() ? 256 : shard.index.size() * 2);
+    size_t mask = index.size() - 1;
+    for (uint32_t stored : shard.index) {
+        if (stored == 0) continue;
+        std::string_view entry = slot(shard, stored - 1);
+        size_t position = (hashText(entry) >> ShardBits) & mask;
+        while (index[position] != 0) position = (position + 1) & mask;
+        index[position] = stored;
+    }
+    shard.index.swap(index);
+}
+
+std::string_view SymbolTable::slot(const Shard& shard, uint32_t slotIndex) const {
+    const std::string_view* segment = shard.segments[slotIndex >> SegmentBits].load(std::memory_order_acquire);
+    return segment[slotIndex & (SegmentSize - 1)];
+}
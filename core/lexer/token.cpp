@@ -10,6 +10,28 @@ std::ostream& operator<<(std::ostream& os, const Token& token) {
         case TokenType::String:           os << "String"; break;
         case TokenType::Operator:         os << "Operator"; break;
         case TokenType::Arrow:            os << "Arrow"; break;
+        case TokenType::Plus:             os << "Plus"; break;
+        case TokenType::Minus:            os << "Minus"; break;
+        case TokenType::Multiply:         os << "Multiply"; break;
+        case TokenType::Divide:           os << "Divide"; break;
+        case TokenType::Modulo:           os << "Modulo"; break;
+        case TokenType::Power:            os << "Power"; break;
+        case TokenType::PlusAssign:       os << "PlusAssign"; break;
+        case TokenType::MinusAssign:      os << "MinusAssign"; break;
+        case TokenType::MultiplyAssign:   os << "MultiplyAssign"; break;
+        case TokenType::DivideAssign:     os << "DivideAssign"; break;
+        case TokenType::ModuloAssign:     os << "ModuloAssign"; break;
+        case TokenType::Equal:            os << "Equal"; break;
+        case TokenType::NotEqual:         os << "NotEqual"; break;
+        case TokenType::Less:             os << "Less"; break;
+        case TokenType::LessEqual:        os << "LessEqual"; break;
+        case TokenType::Greater:          os << "Greater"; break;
+        case TokenType::GreaterEqual:     os << "GreaterEqual"; break;
+        case TokenType::LogicalAnd:       os << "LogicalAnd"; break;
+        case TokenType::LogicalOr:        os << "LogicalOr"; break;
+        case TokenType::LogicalNot:       os << "LogicalNot"; break;
+        case TokenType::Increment:        os << "Increment"; break;
+        case TokenType::Decrement:        os << "Decrement"; break;
 
         case TokenType::BraceOpen:        os << "BraceOpen"; break;
         case TokenType::BraceClose:       os << "BraceClose"; break;
@@ -47,6 +69,6 @@ std::ostream& operator<<(std::ostream& os, const Token& token) {
 
         default:                         os << "Other"; break;
     }
-    os << ": '" << token.value << "' (Line " << token.line << ", Col " << token.column << ")]";
+    os << ": '" << token.value << "' (Offset " << token.offset << ")]";
     return os;
 }
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "../include/incremental_parser.h"
+
+namespace {
+
+void shiftOffsets(Node& node, uint32_t delta) {
+    // Unsigned wrap-around makes a negative delta work too.
+    if (node.offset != Node::NoOffset) node.offset += delta;
+    forEachChild(node, [delta](Node& child) { shiftOffsets(child, delta); });
+}
+
+}
+
+void IncrementalParser::noteEdit(const IncrementalLexer::EditStats& edit) {
+    size_t editEnd = edit.firstToken + edit.replaced;
+    std::ptrdiff_t delta = static_cast<std::ptrdiff_t>(edit.relexed) - static_cast<std::ptrdiff_t>(edit.replaced);
+    for (Item& item : items) {
+        if (item.begin >= editEnd) {
+            item.begin += delta;
+            item.end += delta;
+        } else if (item.end + 1 > edit.firstToken) {
+            item.dirty = true;
+        }
+    }
+}
+
+void IncrementalParser::invalidate() {
+    current.reset();
+    items.clear();
+}
+
+const Program& IncrementalParser::parse(const IncrementalLexer& document) {
+    Parser parser(document);
+    auto program = std::make_unique<Program>();
+    std::vector<Item> kept;
+    stats = Stats();
+
+    size_t next = 0;
+    while (!parser.isAtEnd()) {
+        size_t index = parser.tokens.position();
+        while (next < items.size() && items[next].begin < index) ++next;
+
+        if (next < items.size() && items[next].begin == index && !items[next].dirty) {
+            Item item = items[next++];
+            // None of the item's bytes changed, so an edit before it moved
+            // every offset in it by the same amount.
+            uint32_t delta = parser.peek().offset - item.offset;
+            Node* node;
+            if (item.isFunction) {
+                program->functions.push_back(std::move(current->functions[item.slot]));
+                item.slot = program->functions.size() - 1;
+                node = program->functions.back().get();
+            } else {
+                program->components.push_back(std::move(current->components[item.slot]));
+                item.slot = program->components.size() - 1;
+                node = program->components.back().get();
+            }
+            if (delta != 0) shiftOffsets(*node, delta);
+            item.offset += delta;
+            kept.push_back(item);
+            parser.tokens.skipTo(item.end);
+            ++stats.reused;
+            continue;
+        }
+
+        uint32_t offset = parser.peek().offset;
+        size_t components = program->components.size();
+        size_t functions = program->functions.size();
+        size_t errors = parser.diagnostics.size();
+        parser.parseTopLevel(*program);
+        ++stats.parsed;
+
+        if (parser.diagnostics.size() != errors) continue;
+        size_t end = parser.tokens.position();
+        if (program->components.size() > components) {
+            kept.push_back({index, end, offset, false, components, false});
+        } else if (program->functions.size() > functions) {
+            kept.push_back({index, end, offset, true, functions, false});
+        }
+    }
+
+    current = std::move(program);
+    items = std::move(kept);
+    diagnostics = parser.diagnostics;
+    return *current;
+}
@@ -1,37 +1,55 @@
 #include "../include/parser.h"
 #include "../include/ast_complete.h"
+#include "../include/operators.h"
+#include "../include/phase_timer.h"
 #include "../include/token.h"
 #include <algorithm>
 #include <cctype>
 #include <memory>
-#include <stdexcept>
-#include <iostream>
+#include <string>
 
+namespace {
 
+// How an error message names the token it stopped at.
+std::string describe(const Token& token) {
+    if (token.type == TokenType::EOFToken) return "end of input";
+    return "'" + std::string(token.value) + "'";
+}
 
-Parser::Parser(std::vector<Token> tokens) : tokens(std::move(tokens)), current(0) {}
+}
 
+Parser::Parser(std::vector<Token> tokens) : tokens(std::move(tokens)) {}
 
-Token& Parser::peek() {
-    if (current >= tokens.size()) {
-        static Token eofToken(TokenType::EOFToken, "", 0, 0);
-        return eofToken;
-    }
-    return tokens[current];
+Parser::Parser(Lexer& lexer) : tokens(lexer) {}
+
+Parser::Parser(const IncrementalLexer& document) : tokens(document) {}
+
+Parser::Parser(TokenBuffer buffer) : tokens(std::move(buffer)) {}
+
+
+const Token& Parser::peek() {
+    return panicking ? endOfInput : tokens.peek();
+}
+
+TokenType Parser::peekType() {
+    return panicking ? TokenType::EOFToken : tokens.peekType();
 }
 
-Token& Parser::advance() {
-    if (!isAtEnd()) current++;
-    return tokens[current - 1];
+const Token& Parser::advance() {
+    if (!isAtEnd()) tokens.advance();
+    return tokens.previous();
+}
+
+const Token& Parser::previous() const {
+    return tokens.previous();
 }
 
 bool Parser::isAtEnd() {
-    return current >= tokens.size() || peek().type == TokenType::EOFToken;
+    return peekType() == TokenType::EOFToken;
 }
 
 bool Parser::check(TokenType type) {
-    if (isAtEnd()) return false;
-    return peek().type == type;
+    return type != TokenType::EOFToken && peekType() == type;
 }
 
 bool Parser::match(std::initializer_list<TokenType> types) {
@@ -44,42 +62,105 @@ bool Parser::match(std::initializer_list<TokenType> types) {
     return false;
 }
 
-bool Parser::matchKeyword(const std::string& keyword) {
-    return check(TokenType::Keyword) && peek().value == keyword;
+bool Parser::checkKeyword(Keyword keyword) {
+    return check(TokenType::Keyword) && tokens.peekKeyword() == keyword;
+}
+
+bool Parser::matchKeyword(Keyword keyword) {
+    if (!checkKeyword(keyword)) return false;
+    advance();
+    return true;
 }
 
 Token Parser::consume(TokenType type, const std::string& message) {
     if (check(type)) return advance();
     
-    Token& currentToken = peek();
-    throw ParseError(message + ", got '" + currentToken.value + "'", currentToken.line, currentToken.column);
+    const Token& currentToken = peek();
+    if (!panicking) error(message + ", got " + describe(currentToken), currentToken.offset);
+    return currentToken;
+}
+
+// In Normal mode the lexer reports a brace as ExpressionStart/ExpressionEnd
+// (it cannot tell a block from an embedded expression); inside an
+// expression it reports BraceOpen/BraceClose. The grammar accepts either.
+bool Parser::checkOpenBrace() {
+    return check(TokenType::BraceOpen) || check(TokenType::ExpressionStart);
 }
 
-Token Parser::consumeKeyword(const std::string& keyword, const std::string& message) {
-    if (matchKeyword(keyword)) return advance();
+bool Parser::checkCloseBrace() {
+    return check(TokenType::BraceClose) || check(TokenType::ExpressionEnd);
+}
+
+bool Parser::matchOpenBrace() {
+    return match({TokenType::BraceOpen, TokenType::ExpressionStart});
+}
+
+Token Parser::consumeOpenBrace(const std::string& message) {
+    if (checkOpenBrace()) return advance();
+    return consume(TokenType::BraceOpen, message);
+}
+
+Token Parser::consumeCloseBrace(const std::string& message) {
+    if (checkCloseBrace()) return advance();
+    return consume(TokenType::BraceClose, message);
+}
+
+Token Parser::consumeKeyword(Keyword keyword, const std::string& message) {
+    if (checkKeyword(keyword)) return advance();
     
-    Token& currentToken = peek();
-    throw ParseError(message + ", got '" + currentToken.value + "'", currentToken.line, currentToken.column);
+    const Token& currentToken = peek();
+    if (!panicking) error(message + ", got " + describe(currentToken), currentToken.offset);
+    return currentToken;
+}
+
+void Parser::error(std::string message, uint32_t offset) {
+    if (panicking) return;
+    diagnostics.emplace_back(std::move(message), offset);
+    panicking = true;
+    if (errorLimit != 0 && diagnostics.size() >= errorLimit) {
+        diagnostics.emplace_back("Too many errors, parsing stopped", offset);
+        halted = true;
+    }
+}
+
+ExpressionPtr Parser::errorExpression() {
+    const Token& at = peek();
+    if (!panicking) {
+        error(at.type == TokenType::EOFToken ? "Unexpected end of input in expression"
+                                             : "Unexpected token in expression: " + describe(at),
+              at.offset);
+    }
+    return std::make_unique<ErrorExpression>(at.offset);
 }
 
 void Parser::synchronize() {
     advance();
     
     while (!isAtEnd()) {
-        if (tokens[current - 1].type == TokenType::SemiColon) return;
+        if (previous().type == TokenType::SemiColon) return;
         
         switch (peek().type) {
             case TokenType::Keyword:
-                if (peek().value == "component" || peek().value == "import" || 
-                    peek().value == "function" || peek().value == "if" || 
-                    peek().value == "while" || peek().value == "for" || 
-                    peek().value == "return" || peek().value == "try") {
-                    return;
+                switch (peek().keyword) {
+                    case Keyword::Component: case Keyword::Import:
+                    case Keyword::Export: case Keyword::Function:
+                    case Keyword::Fn: case Keyword::If:
+                    case Keyword::While: case Keyword::For:
+                    case Keyword::Return: case Keyword::Try:
+                    case Keyword::Let: case Keyword::Const:
+                    case Keyword::Var:
+                        return;
+                    default:
+                        break;
                 }
                 break;
+            // Nothing at the top level starts with a closer, so the one that
+            // ends the broken item is skipped along with it.
             case TokenType::BraceClose:
+            case TokenType::ExpressionEnd:
             case TokenType::ParenClose:
-            case TokenType::BracketClose:
+            case TokenType::SquareBracketClose:
+                advance();
                 return;
             default:
                 break;
@@ -90,64 +171,68 @@ void Parser::synchronize() {
 
 
 std::unique_ptr<Program> Parser::parse() {
-    try {
-        return parseProgram();
-    } catch (const ParseError& error) {
-        std::cerr << "Parse Error at " << error.line << ":" << error.column << " - " << error.message << std::endl;
-        throw;
-    }
+    return parseProgram();
 }
 
 std::unique_ptr<Program> Parser::parseProgram() {
+    PhaseTimer timer("parse");
     auto program = std::make_unique<Program>();
     
     while (!isAtEnd()) {
-        try {
-            if (matchKeyword("component")) {
-                program->components.push_back(parseComponent());
-            } else if (matchKeyword("import")) {
-                program->globalStatements.push_back(parseImport());
-            } else if (matchKeyword("export")) {
-                program->globalStatements.push_back(parseExport());
-            } else if (matchKeyword("function") || matchKeyword("fn")) {
-                program->functions.push_back(parseFunction());
-            } else if (check(TokenType::AtModifier)) {
-                
-                program->globalStatements.push_back(parseModifiedStatement());
-            } else {
-                
-                program->globalStatements.push_back(parseStatement());
-            }
-        } catch (const ParseError& error) {
-            std::cerr << "Parse Error: " << error.message << " at " << error.line << ":" << error.column << std::endl;
-            synchronize();
-        }
+        parseTopLevel(*program);
     }
     
     return program;
 }
 
+void Parser::parseTopLevel(Program& program) {
+    if (checkKeyword(Keyword::Component)) {
+        program.components.push_back(parseComponent());
+    } else if (checkKeyword(Keyword::Import)) {
+        program.globalStatements.push_back(parseImport());
+    } else if (checkKeyword(Keyword::Export)) {
+        program.globalStatements.push_back(parseExport());
+    } else if (checkKeyword(Keyword::Function) || checkKeyword(Keyword::Fn)) {
+        program.functions.push_back(parseFunction());
+    } else if (check(TokenType::AtModifier)) {
+        
+        program.globalStatements.push_back(parseModifiedStatement());
+    } else {
+        
+        program.globalStatements.push_back(parseStatement());
+    }
+
+    // The item keeps whatever was parsed before the error; the rest of it
+    // is skipped.
+    if (panicking && !halted) {
+        panicking = false;
+        synchronize();
+    }
+}
+
 ComponentPtr Parser::parseComponent() {
-    Token componentToken = advance(); 
+    PhaseTimer timer("parseComponent");
+    advance();   // 'component'
     
     Token nameToken = consume(TokenType::Identifier, "Expected component name");
-    std::string componentName = nameToken.value;
+    timer.setDetail(nameToken.value);
     
-    consume(TokenType::BraceOpen, "Expected '{' after component name");
+    consumeOpenBrace("Expected '{' after component name");
     
-    auto component = std::make_unique<Component>(componentName, ComponentType::MIXED, 
-                                                nameToken.line, nameToken.column);
+    auto component = std::make_unique<Component>(nameToken.symbol, ComponentType::MIXED, 
+                                                nameToken.offset);
     
     
-    while (!check(TokenType::BraceClose) && !isAtEnd()) {
-        if (matchKeyword("render")) {
+    while (!checkCloseBrace() && !isAtEnd()) {
+        if (matchKeyword(Keyword::Render)) {
             
             consume(TokenType::Colon, "Expected ':' after 'render'");
             component->body = parseALTXContent();
         } else if (check(TokenType::Identifier) && checkNext(TokenType::Equals)) {
             
             component->statements.push_back(parseAssignment());
-        } else if (check(TokenType::Identifier) && checkNext(TokenType::BraceOpen)) {
+        } else if (check(TokenType::Identifier) &&
+                   (checkNext(TokenType::BraceOpen) || checkNext(TokenType::ExpressionStart))) {
             
             component->statements.push_back(parseMethodDefinition());
         } else if (check(TokenType::TagOpen)) {
@@ -159,15 +244,15 @@ ComponentPtr Parser::parseComponent() {
         }
     }
     
-    consume(TokenType::BraceClose, "Expected '}' after component body");
+    consumeCloseBrace("Expected '}' after component body");
     return component;
 }
 
 std::vector<ASTNodePtr> Parser::parseALTXContent() {
     std::vector<ASTNodePtr> content;
     
-    while (!check(TokenType::BraceClose) && !isAtEnd() && 
-           !matchKeyword("render") && !check(TokenType::Identifier)) {
+    while (!checkCloseBrace() && !isAtEnd() && 
+           !checkKeyword(Keyword::Render) && !check(TokenType::Identifier)) {
         
         if (check(TokenType::TagOpen)) {
             content.push_back(parseTag());
@@ -183,9 +268,56 @@ std::vector<ASTNodePtr> Parser::parseALTXContent() {
     return content;
 }
 
+// Open tags wait on an explicit stack while their children are parsed, so a
+// tree costs no call depth however deep it nests. A tag goes into its
+// parent's children once it is closed, which keeps them in source order.
 TagPtr Parser::parseTag() {
+    PhaseTimer timer("parseTag");
+    TagPtr root = parseTagHead();
+    if (root->isSelfClosing) return root;
+    
+    std::vector<TagPtr> open;
+    open.push_back(std::move(root));
+    while (true) {
+        Tag& tag = *open.back();
+        if (check(TokenType::TagOpen)) {
+            if (open.size() >= nestingLimit) {
+                // Panics, so every open tag is closed below.
+                error("Tags nested more than " + std::to_string(nestingLimit) + " levels deep", peek().offset);
+                continue;
+            }
+            TagPtr child = parseTagHead();
+            if (child->isSelfClosing) {
+                tag.children.push_back(std::move(child));
+            } else {
+                open.push_back(std::move(child));
+            }
+        } else if (check(TokenType::Text)) {
+            tag.children.push_back(parseTextContent());
+        } else if (check(TokenType::ExpressionStart)) {
+            tag.children.push_back(parseEmbeddedExpression());
+        } else if (check(TokenType::TagClose) || isAtEnd()) {
+            if (check(TokenType::TagClose)) {
+                Token closeTag = advance();
+                if (closeTag.symbol != tag.tagName) {
+                    error("Mismatched closing tag: expected </" + std::string(symbolText(tag.tagName)) + 
+                          "> but got </" + std::string(closeTag.value) + ">", 
+                          closeTag.offset);
+                }
+            }
+            TagPtr closed = std::move(open.back());
+            open.pop_back();
+            if (open.empty()) return closed;
+            open.back()->children.push_back(std::move(closed));
+        } else {
+            advance(); 
+        }
+    }
+}
+
+TagPtr Parser::parseTagHead() {
     Token tagToken = consume(TokenType::TagOpen, "Expected tag");
-    auto tag = std::make_unique<Tag>(tagToken.value, tagToken.line, tagToken.column);
+    auto tag = std::make_unique<Tag>(tagToken.symbol, tagToken.offset);
     
     
     while (!check(TokenType::TagEnd) && !check(TokenType::TagSelfClose) && !isAtEnd()) {
@@ -205,29 +337,6 @@ TagPtr Parser::parseTag() {
     }
     
     consume(TokenType::TagEnd, "Expected '>' after tag");
-    
-    
-    while (!check(TokenType::TagClose) && !isAtEnd()) {
-        if (check(TokenType::TagOpen)) {
-            tag->children.push_back(parseTag());
-        } else if (check(TokenType::Text)) {
-            tag->children.push_back(parseTextContent());
-        } else if (check(TokenType::ExpressionStart)) {
-            tag->children.push_back(parseEmbeddedExpression());
-        } else {
-            advance(); 
-        }
-    }
-    
-    if (check(TokenType::TagClose)) {
-        Token closeTag = advance();
-        if (closeTag.value != tag->tagName) {
-            throw ParseError("Mismatched closing tag: expected </" + tag->tagName + 
-                           "> but got </" + closeTag.value + ">", 
-                           closeTag.line, closeTag.column);
-        }
-    }
-    
     return tag;
 }
 
@@ -238,39 +347,38 @@ std::unique_ptr<Attribute> Parser::parseAttribute() {
         ExpressionPtr value;
         
         if (check(TokenType::String)) {
-            value = std::make_unique<StringLiteral>(advance().value);
+            value = std::make_unique<StringLiteral>(std::string(advance().value));
         } else if (check(TokenType::ExpressionStart)) {
             advance(); 
             value = parseExpression();
             consume(TokenType::ExpressionEnd, "Expected '}' after expression");
         } else if (check(TokenType::ValueBinding)) {
-            std::string binding = advance().value;
-            std::string bindingName = binding.substr(1); 
-            value = std::make_unique<ValueBinding>(bindingName);
+            value = std::make_unique<ValueBinding>(advance().symbol);
         } else if (check(TokenType::Identifier)) {
-            value = std::make_unique<Identifier>(advance().value);
+            value = std::make_unique<Identifier>(advance().symbol);
         } else {
-            throw ParseError("Expected attribute value after '='", peek().line, peek().column);
+            error("Expected attribute value after '='", peek().offset);
+            value = std::make_unique<ErrorExpression>(nameToken.offset);
         }
         
-        return std::make_unique<Attribute>(nameToken.value, std::move(value));
+        return std::make_unique<Attribute>(nameToken.symbol, std::move(value));
     } else {
         
-        return std::make_unique<Attribute>(nameToken.value, 
+        return std::make_unique<Attribute>(nameToken.symbol, 
                                          std::make_unique<BooleanLiteral>(true));
     }
 }
 
-std::vector<StyleProperty> Parser::parseStyleProperty(const std::string& styleContent) {
+std::vector<StyleProperty> Parser::parseStyleProperty(std::string_view styleContent) {
     std::vector<StyleProperty> styles;
     
     
     size_t pos = 0;
     while (pos < styleContent.length()) {
         size_t colonPos = styleContent.find(':', pos);
-        if (colonPos == std::string::npos) break;
+        if (colonPos == std::string_view::npos) break;
         
-        std::string property = styleContent.substr(pos, colonPos - pos);
+        std::string property(styleContent.substr(pos, colonPos - pos));
         
         
         property.erase(0, property.find_first_not_of(" \\t"));
@@ -278,9 +386,9 @@ std::vector<StyleProperty> Parser::parseStyleProperty(const std::string& styleCo
         
         pos = colonPos + 1;
         size_t semicolonPos = styleContent.find(';', pos);
-        if (semicolonPos == std::string::npos) semicolonPos = styleContent.length();
+        if (semicolonPos == std::string_view::npos) semicolonPos = styleContent.length();
         
-        std::string value = styleContent.substr(pos, semicolonPos - pos);
+        std::string value(styleContent.substr(pos, semicolonPos - pos));
         value.erase(0, value.find_first_not_of(" \\t"));
         value.erase(value.find_last_not_of(" \\t") + 1);
         
@@ -296,7 +404,7 @@ std::vector<StyleProperty> Parser::parseStyleProperty(const std::string& styleCo
 
 std::unique_ptr<TextContent> Parser::parseTextContent() {
     Token textToken = consume(TokenType::Text, "Expected text content");
-    return std::make_unique<TextContent>(textToken.value, textToken.line, textToken.column);
+    return std::make_unique<TextContent>(std::string(textToken.value), textToken.offset);
 }
 
 StatementPtr Parser::parseEmbeddedExpression() {
@@ -309,27 +417,27 @@ StatementPtr Parser::parseEmbeddedExpression() {
 StatementPtr Parser::parseImport() {
     Token importToken = advance(); 
     
-    consume(TokenType::BraceOpen, "Expected '{' after 'import'");
+    consumeOpenBrace("Expected '{' after 'import'");
     
-    std::vector<std::string> bindings = parseImportList();
+    std::vector<Symbol> bindings = parseImportList();
     
-    consume(TokenType::BraceClose, "Expected '}' after import list");
-    consumeKeyword("from", "Expected 'from' after import bindings");
+    consumeCloseBrace("Expected '}' after import list");
+    consumeKeyword(Keyword::From, "Expected 'from' after import bindings");
     
     Token sourceToken = consume(TokenType::String, "Expected module name");
-    std::string source = sourceToken.value;
+    std::string source(sourceToken.value);
     
     return std::make_unique<Import>(std::move(bindings), source, false, 
-                                   importToken.line, importToken.column);
+                                   importToken.offset);
 }
 
-std::vector<std::string> Parser::parseImportList() {
-    std::vector<std::string> bindings;
+std::vector<Symbol> Parser::parseImportList() {
+    std::vector<Symbol> bindings;
     
-    if (!check(TokenType::BraceClose)) {
+    if (!checkCloseBrace()) {
         do {
             Token identifier = consume(TokenType::Identifier, "Expected identifier in import list");
-            bindings.push_back(identifier.value);
+            bindings.push_back(identifier.symbol);
         } while (match({TokenType::Comma}));
     }
     
@@ -340,52 +448,55 @@ StatementPtr Parser::parseExport() {
     Token exportToken = advance(); 
     
     bool isDefault = false;
-    if (matchKeyword("default")) {
+    if (matchKeyword(Keyword::Default)) {
         isDefault = true;
     }
     
     StatementPtr declaration;
     
-    if (matchKeyword("function") || matchKeyword("fn")) {
+    if (checkKeyword(Keyword::Function) || checkKeyword(Keyword::Fn)) {
         declaration = parseFunction();
-    } else if (matchKeyword("component")) {
+    } else if (checkKeyword(Keyword::Component)) {
         declaration = parseComponent();
     } else if (check(TokenType::Identifier)) {
         
         declaration = parseStatement();
     } else {
-        throw ParseError("Expected declaration after 'export'", peek().line, peek().column);
+        error("Expected declaration after 'export'", peek().offset);
+        declaration = std::make_unique<ExpressionStatement>(
+            std::make_unique<ErrorExpression>(exportToken.offset));
     }
     
     return std::make_unique<Export>(std::move(declaration), isDefault, 
-                                   exportToken.line, exportToken.column);
+                                   exportToken.offset);
 }
 
 FunctionPtr Parser::parseFunction() {
     Token funcToken = advance(); 
     
     Token nameToken = consume(TokenType::Identifier, "Expected function name");
-    std::string functionName = nameToken.value;
     
     consume(TokenType::ParenOpen, "Expected '(' after function name");
     
-    std::vector<std::string> parameters = parseParameterList();
+    std::vector<Symbol> parameters = parseParameterList();
     
     consume(TokenType::ParenClose, "Expected ')' after parameters");
+    consumeOpenBrace("Expected '{' before function body");
     
-    StatementPtr body = parseBlockStatement();
+    StatementPtr body = skimBodies && !panicking ? skimBody(previous().offset, "Expected '}' after block")
+                                                 : parseBlockStatement();
     
-    return std::make_unique<Function>(functionName, std::move(parameters), std::move(body),
-                                     FunctionType::REGULAR, funcToken.line, funcToken.column);
+    return std::make_unique<Function>(nameToken.symbol, std::move(parameters), std::move(body),
+                                     FunctionType::REGULAR, funcToken.offset);
 }
 
-std::vector<std::string> Parser::parseParameterList() {
-    std::vector<std::string> parameters;
+std::vector<Symbol> Parser::parseParameterList() {
+    std::vector<Symbol> parameters;
     
     if (!check(TokenType::ParenClose)) {
         do {
             Token param = consume(TokenType::Identifier, "Expected parameter name");
-            parameters.push_back(param.value);
+            parameters.push_back(param.symbol);
             
             
             if (match({TokenType::Colon})) {
@@ -399,28 +510,84 @@ std::vector<std::string> Parser::parseParameterList() {
 
 StatementPtr Parser::parseMethodDefinition() {
     Token nameToken = consume(TokenType::Identifier, "Expected method name");
-    std::string methodName = nameToken.value;
     
-    consume(TokenType::BraceOpen, "Expected '{' after method name");
+    consumeOpenBrace("Expected '{' after method name");
     
-    std::vector<StatementPtr> statements;
-    while (!check(TokenType::BraceClose) && !isAtEnd()) {
-        statements.push_back(parseStatement());
+    StatementPtr body;
+    if (skimBodies && !panicking) {
+        body = skimBody(nameToken.offset, "Expected '}' after method body");
+    } else {
+        std::vector<StatementPtr> statements;
+        while (!checkCloseBrace() && !isAtEnd()) {
+            statements.push_back(parseStatement());
+        }
+        
+        consumeCloseBrace("Expected '}' after method body");
+        
+        body = std::make_unique<BlockStatement>(std::move(statements), nameToken.offset);
+    }
+    
+    return std::make_unique<Function>(nameToken.symbol, std::vector<Symbol>(), std::move(body),
+                                     FunctionType::REGULAR, nameToken.offset);
+}
+
+// Only token types are looked at until the matching brace. The closing brace
+// is saved with the body, so statements that take their offset from the
+// token after them get the same one when the body is parsed later. A body
+// that runs to the end of input is parsed here and its errors are reported
+// by this parser, as a full parse would, leaving none for block().
+StatementPtr Parser::skimBody(uint32_t at, const std::string& closeMessage) {
+    auto deferred = std::make_unique<DeferredBlock>(at);
+    deferred->errorLimit = errorLimit;
+    deferred->nestingLimit = nestingLimit;
+    TokenBuffer& body = deferred->tokens;
+    body.push(previous());
+    for (size_t depth = 0;;) {
+        TokenType type = peekType();
+        if (type == TokenType::EOFToken) {
+            body.push(peek());
+            deferred->parse(closeMessage);
+            for (const ParseError& found : deferred->diagnostics) error(found.message, found.offset);
+            deferred->diagnostics.clear();
+            break;
+        }
+        body.push(advance());
+        if (type == TokenType::BraceOpen || type == TokenType::ExpressionStart) {
+            ++depth;
+        } else if ((type == TokenType::BraceClose || type == TokenType::ExpressionEnd) && depth-- == 0) {
+            break;
+        }
     }
-    
-    consume(TokenType::BraceClose, "Expected '}' after method body");
-    
-    auto body = std::make_unique<BlockStatement>(std::move(statements), nameToken.line, nameToken.column);
-    
-    return std::make_unique<Function>(methodName, std::vector<std::string>(), std::move(body),
-                                     FunctionType::REGULAR, nameToken.line, nameToken.column);
+    return deferred;
+}
+
+BlockStatement& DeferredBlock::block() {
+    if (!parsed) parse("Expected '}' after block");
+    return *parsed;
+}
+
+void DeferredBlock::parse(const std::string& closeMessage) {
+    PhaseTimer timer("parseBody");
+    Parser parser(std::move(tokens));
+    tokens = TokenBuffer();
+    parser.setErrorLimit(errorLimit);
+    if (nestingLimit != 0) parser.setNestingLimit(nestingLimit);
+    parser.advance();   // the '{'
+    parsed.reset(static_cast<BlockStatement*>(parser.parseBlockStatement(closeMessage).release()));
+    parsed->offset = offset;
+    diagnostics = parser.errors();
+}
+
+BlockStatement& functionBody(Function& function) {
+    if (auto* deferred = dynamic_cast<DeferredBlock*>(function.body.get())) return deferred->block();
+    return static_cast<BlockStatement&>(*function.body);
 }
 
 StatementPtr Parser::parseModifiedStatement() {
     std::vector<std::string> modifiers;
     
     while (check(TokenType::AtModifier)) {
-        modifiers.push_back(advance().value);
+        modifiers.emplace_back(advance().value);
     }
     
     
@@ -432,53 +599,53 @@ StatementPtr Parser::parseModifiedStatement() {
 }
 
 StatementPtr Parser::parseStatement() {
-    if (matchKeyword("import")) {
+    if (checkKeyword(Keyword::Import)) {
         return parseImport();
     }
     
-    if (matchKeyword("export")) {
+    if (checkKeyword(Keyword::Export)) {
         return parseExport();
     }
     
-    if (matchKeyword("if")) {
+    if (matchKeyword(Keyword::If)) {
         return parseIfStatement();
     }
     
-    if (matchKeyword("while")) {
+    if (matchKeyword(Keyword::While)) {
         return parseWhileStatement();
     }
     
-    if (matchKeyword("for")) {
+    if (matchKeyword(Keyword::For)) {
         return parseForStatement();
     }
     
-    if (matchKeyword("return")) {
+    if (matchKeyword(Keyword::Return)) {
         return parseReturnStatement();
     }
     
-    if (matchKeyword("break")) {
+    if (checkKeyword(Keyword::Break)) {
         advance();
-        return std::make_unique<BreakStatement>(peek().line, peek().column);
+        return std::make_unique<BreakStatement>(peek().offset);
     }
     
-    if (matchKeyword("continue")) {
+    if (checkKeyword(Keyword::Continue)) {
         advance();
-        return std::make_unique<ContinueStatement>(peek().line, peek().column);
+        return std::make_unique<ContinueStatement>(peek().offset);
     }
     
-    if (matchKeyword("try")) {
+    if (matchKeyword(Keyword::Try)) {
         return parseTryStatement();
     }
     
-    if (matchKeyword("throw")) {
+    if (matchKeyword(Keyword::Throw)) {
         return parseThrowStatement();
     }
     
-    if (matchKeyword("let") || matchKeyword("const") || matchKeyword("var")) {
+    if (matchKeyword(Keyword::Let) || matchKeyword(Keyword::Const) || matchKeyword(Keyword::Var)) {
         return parseVariableDeclaration();
     }
     
-    if (match({TokenType::BraceOpen})) {
+    if (matchOpenBrace()) {
         return parseBlockStatement();
     }
     
@@ -489,24 +656,24 @@ StatementPtr Parser::parseStatement() {
     
     
     auto expr = parseExpression();
-    return std::make_unique<ExpressionStatement>(std::move(expr), peek().line, peek().column);
+    return std::make_unique<ExpressionStatement>(std::move(expr), peek().offset);
 }
 
-StatementPtr Parser::parseBlockStatement() {
-    Token braceToken = tokens[current - 1]; 
+StatementPtr Parser::parseBlockStatement(const std::string& closeMessage) {
+    Token braceToken = previous(); 
     std::vector<StatementPtr> statements;
     
-    while (!check(TokenType::BraceClose) && !isAtEnd()) {
+    while (!checkCloseBrace() && !isAtEnd()) {
         statements.push_back(parseStatement());
     }
     
-    consume(TokenType::BraceClose, "Expected '}' after block");
+    consumeCloseBrace(closeMessage);
     
-    return std::make_unique<BlockStatement>(std::move(statements), braceToken.line, braceToken.column);
+    return std::make_unique<BlockStatement>(std::move(statements), braceToken.offset);
 }
 
 StatementPtr Parser::parseIfStatement() {
-    Token ifToken = tokens[current - 1]; 
+    Token ifToken = previous(); 
     
     consume(TokenType::ParenOpen, "Expected '(' after 'if'");
     auto condition = parseExpression();
@@ -515,16 +682,16 @@ StatementPtr Parser::parseIfStatement() {
     auto thenBranch = parseStatement();
     StatementPtr elseBranch = nullptr;
     
-    if (matchKeyword("else")) {
+    if (matchKeyword(Keyword::Else)) {
         elseBranch = parseStatement();
     }
     
     return std::make_unique<IfStatement>(std::move(condition), std::move(thenBranch), 
-                                        std::move(elseBranch), ifToken.line, ifToken.column);
+                                        std::move(elseBranch), ifToken.offset);
 }
 
 StatementPtr Parser::parseWhileStatement() {
-    Token whileToken = tokens[current - 1]; 
+    Token whileToken = previous(); 
     
     consume(TokenType::ParenOpen, "Expected '(' after 'while'");
     auto condition = parseExpression();
@@ -533,21 +700,15 @@ StatementPtr Parser::parseWhileStatement() {
     auto body = parseStatement();
     
     return std::make_unique<WhileStatement>(std::move(condition), std::move(body), 
-                                          whileToken.line, whileToken.column);
+                                          whileToken.offset);
 }
 
 StatementPtr Parser::parseForStatement() {
-    Token forToken = tokens[current - 1]; 
+    Token forToken = previous(); 
     
     
-    if (check(TokenType::Identifier)) {
-        size_t saved = current;
-        advance(); 
-        if (matchKeyword("in")) {
-            current = saved; 
-            return parseForInStatement();
-        }
-        current = saved; 
+    if (check(TokenType::Identifier) && checkNext(TokenType::Identifier) && tokens.peek(1).symbol == inSymbol) {
+        return parseForInStatement();
     }
     
     consume(TokenType::ParenOpen, "Expected '(' after 'for'");
@@ -555,7 +716,7 @@ StatementPtr Parser::parseForStatement() {
     
     StatementPtr init = nullptr;
     if (!check(TokenType::SemiColon)) {
-        if (matchKeyword("let") || matchKeyword("const") || matchKeyword("var")) {
+        if (matchKeyword(Keyword::Let) || matchKeyword(Keyword::Const) || matchKeyword(Keyword::Var)) {
             init = parseVariableDeclaration();
         } else {
             auto expr = parseExpression();
@@ -582,50 +743,53 @@ StatementPtr Parser::parseForStatement() {
     
     return std::make_unique<ForStatement>(std::move(init), std::move(condition), 
                                          std::move(update), std::move(body), 
-                                         forToken.line, forToken.column);
+                                         forToken.offset);
 }
 
 StatementPtr Parser::parseForInStatement() {
-    Token forToken = tokens[current - 1]; 
+    Token forToken = previous(); 
     
     Token varToken = consume(TokenType::Identifier, "Expected variable name in for-in loop");
-    consumeKeyword("in", "Expected 'in' in for-in loop");
+    if (!(check(TokenType::Identifier) && peek().symbol == inSymbol)) {
+        error("Expected 'in' in for-in loop", peek().offset);
+    }
+    advance();
     auto iterable = parseExpression();
     
     auto body = parseStatement();
     
-    return std::make_unique<ForInStatement>(varToken.value, std::move(iterable), 
-                                          std::move(body), forToken.line, forToken.column);
+    return std::make_unique<ForInStatement>(varToken.symbol, std::move(iterable), 
+                                          std::move(body), forToken.offset);
 }
 
 StatementPtr Parser::parseReturnStatement() {
-    Token returnToken = tokens[current - 1]; 
+    Token returnToken = previous(); 
     
     ExpressionPtr value = nullptr;
-    if (!check(TokenType::SemiColon) && !check(TokenType::BraceClose) && !isAtEnd()) {
+    if (!check(TokenType::SemiColon) && !checkCloseBrace() && !isAtEnd()) {
         value = parseExpression();
     }
     
-    return std::make_unique<ReturnStatement>(std::move(value), returnToken.line, returnToken.column);
+    return std::make_unique<ReturnStatement>(std::move(value), returnToken.offset);
 }
 
 StatementPtr Parser::parseTryStatement() {
-    Token tryToken = tokens[current - 1]; 
+    Token tryToken = previous(); 
     
     auto block = parseBlockStatement();
     
-    auto tryStmt = std::make_unique<TryStatement>(std::move(block), tryToken.line, tryToken.column);
+    auto tryStmt = std::make_unique<TryStatement>(std::move(block), tryToken.offset);
     
-    if (matchKeyword("catch")) {
+    if (matchKeyword(Keyword::Catch)) {
         consume(TokenType::ParenOpen, "Expected '(' after 'catch'");
         Token varToken = consume(TokenType::Identifier, "Expected catch variable");
         consume(TokenType::ParenClose, "Expected ')' after catch variable");
         
-        tryStmt->catchVariable = varToken.value;
+        tryStmt->catchVariable = varToken.symbol;
         tryStmt->catchBlock = parseBlockStatement();
     }
     
-    if (matchKeyword("finally")) {
+    if (matchKeyword(Keyword::Finally)) {
         tryStmt->finallyBlock = parseBlockStatement();
     }
     
@@ -633,15 +797,15 @@ StatementPtr Parser::parseTryStatement() {
 }
 
 StatementPtr Parser::parseThrowStatement() {
-    Token throwToken = tokens[current - 1]; 
+    Token throwToken = previous(); 
     
     auto expr = parseExpression();
     
-    return std::make_unique<ThrowStatement>(std::move(expr), throwToken.line, throwToken.column);
+    return std::make_unique<ThrowStatement>(std::move(expr), throwToken.offset);
 }
 
 StatementPtr Parser::parseVariableDeclaration() {
-    Token kindToken = tokens[current - 1]; 
+    Token kindToken = previous(); 
     
     Token nameToken = consume(TokenType::Identifier, "Expected variable name");
     
@@ -650,114 +814,72 @@ StatementPtr Parser::parseVariableDeclaration() {
         initializer = parseExpression();
     }
     
-    return std::make_unique<VariableDeclaration>(nameToken.value, std::move(initializer), 
-                                               kindToken.value, nameToken.line, nameToken.column);
+    return std::make_unique<VariableDeclaration>(nameToken.symbol, std::move(initializer), 
+                                               kindToken.keyword, nameToken.offset);
 }
 
 StatementPtr Parser::parseAssignment() {
     Token identifier = consume(TokenType::Identifier, "Expected identifier");
     
-    std::string operator_ = "=";
-    if (check(TokenType::Operator) && 
-        (peek().value == "+=" || peek().value == "-=" || peek().value == "*=" || peek().value == "/=")) {
-        operator_ = advance().value;
+    TokenType operator_ = TokenType::Equals;
+    if (check(TokenType::PlusAssign) || check(TokenType::MinusAssign) ||
+        check(TokenType::MultiplyAssign) || check(TokenType::DivideAssign) ||
+        check(TokenType::ModuloAssign)) {
+        operator_ = advance().type;
     } else {
         consume(TokenType::Equals, "Expected '=' in assignment");
     }
     
     ExpressionPtr value = parseExpression();
     
-    return std::make_unique<Assignment>(identifier.value, std::move(value), operator_, 
-                                       identifier.line, identifier.column);
-}
-
-
-ExpressionPtr Parser::parseExpression() {
-    return parseLogicalOr();
-}
-
-ExpressionPtr Parser::parseLogicalOr() {
-    auto expr = parseLogicalAnd();
-    
-    while (check(TokenType::Operator) && peek().value == "||") {
-        std::string operator_ = advance().value;
-        auto right = parseLogicalAnd();
-        expr = std::make_unique<BinaryExpression>(std::move(expr), operator_, std::move(right));
-    }
-    
-    return expr;
+    return std::make_unique<Assignment>(identifier.symbol, std::move(value), operator_, 
+                                       identifier.offset);
 }
 
-ExpressionPtr Parser::parseLogicalAnd() {
-    auto expr = parseEquality();
-    
-    while (check(TokenType::Operator) && peek().value == "&&") {
-        std::string operator_ = advance().value;
-        auto right = parseEquality();
-        expr = std::make_unique<BinaryExpression>(std::move(expr), operator_, std::move(right));
-    }
-    
-    return expr;
-}
 
-ExpressionPtr Parser::parseEquality() {
-    auto expr = parseComparison();
-    
-    while (check(TokenType::Operator) && 
-           (peek().value == "==" || peek().value == "!=")) {
-        std::string operator_ = advance().value;
-        auto right = parseComparison();
-        expr = std::make_unique<BinaryExpression>(std::move(expr), operator_, std::move(right));
+bool Parser::enterExpression() {
+    if (expressionDepth < nestingLimit) {
+        ++expressionDepth;
+        return true;
     }
-    
-    return expr;
-}
-
-ExpressionPtr Parser::parseComparison() {
-    auto expr = parseTerm();
-    
-    while (check(TokenType::Operator) && 
-           (peek().value == ">" || peek().value == ">=" || 
-            peek().value == "<" || peek().value == "<=")) {
-        std::string operator_ = advance().value;
-        auto right = parseTerm();
-        expr = std::make_unique<BinaryExpression>(std::move(expr), operator_, std::move(right));
-    }
-    
-    return expr;
+    const Token& at = peek();
+    if (!panicking) error("Expression nested more than " + std::to_string(nestingLimit) + " levels deep", at.offset);
+    return false;
 }
 
-ExpressionPtr Parser::parseTerm() {
-    auto expr = parseFactor();
-    
-    while (check(TokenType::Operator) && 
-           (peek().value == "+" || peek().value == "-")) {
-        std::string operator_ = advance().value;
-        auto right = parseFactor();
-        expr = std::make_unique<BinaryExpression>(std::move(expr), operator_, std::move(right));
-    }
-    
-    return expr;
+ExpressionPtr Parser::parseExpression() {
+    return parseBinary(1);
 }
 
-ExpressionPtr Parser::parseFactor() {
+// Precedence climbing over operator_table: parses a unary operand, then
+// folds in every binary operator that binds at least as tightly as
+// minPrecedence. Left-associative operators parse their right operand one
+// level tighter so that equal-precedence chains group to the left.
+ExpressionPtr Parser::parseBinary(int minPrecedence) {
+    // Brackets and right-hand operands nest through here.
+    if (!enterExpression()) return std::make_unique<ErrorExpression>(peek().offset);
     auto expr = parseUnary();
     
-    while (check(TokenType::Operator) && 
-           (peek().value == "*" || peek().value == "/" || peek().value == "%")) {
-        std::string operator_ = advance().value;
-        auto right = parseUnary();
+    while (true) {
+        BinaryOperator info = binaryOperator(peek().type);
+        if (info.precedence == 0 || info.precedence < minPrecedence) break;
+        
+        TokenType operator_ = advance().type;
+        int nextPrecedence = info.associativity == Associativity::Left ? info.precedence + 1 : info.precedence;
+        auto right = parseBinary(nextPrecedence);
         expr = std::make_unique<BinaryExpression>(std::move(expr), operator_, std::move(right));
     }
     
+    leaveExpression();
     return expr;
 }
 
 ExpressionPtr Parser::parseUnary() {
-    if (check(TokenType::Operator) && 
-        (peek().value == "!" || peek().value == "-" || peek().value == "+")) {
-        std::string operator_ = advance().value;
+    if (check(TokenType::LogicalNot) || check(TokenType::Minus) || check(TokenType::Plus)) {
+        if (!enterExpression()) return std::make_unique<ErrorExpression>(peek().offset);
+        TokenType operator_ = advance().type;
         auto right = parseUnary();
+        leaveExpression();
         return std::make_unique<UnaryExpression>(operator_, std::move(right));
     }
     
@@ -781,11 +903,11 @@ ExpressionPtr Parser::parseCall() {
             expr = std::make_unique<CallExpression>(std::move(expr), std::move(arguments));
         } else if (match({TokenType::Dot})) {
             Token name = consume(TokenType::Identifier, "Expected property name after '.'");
-            auto property = std::make_unique<Identifier>(name.value);
+            auto property = std::make_unique<Identifier>(name.symbol);
             expr = std::make_unique<MemberExpression>(std::move(expr), std::move(property), false);
-        } else if (match({TokenType::BracketOpen})) {
+        } else if (match({TokenType::SquareBracketOpen})) {
             auto index = parseExpression();
-            consume(TokenType::BracketClose, "Expected ']' after array index");
+            consume(TokenType::SquareBracketClose, "Expected ']' after array index");
             expr = std::make_unique<MemberExpression>(std::move(expr), std::move(index), true);
         } else {
             break;
@@ -797,37 +919,35 @@ ExpressionPtr Parser::parseCall() {
 
 ExpressionPtr Parser::parsePrimary() {
     if (match({TokenType::String})) {
-        return std::make_unique<StringLiteral>(tokens[current - 1].value);
+        return std::make_unique<StringLiteral>(std::string(previous().value));
     }
     
     if (match({TokenType::Number})) {
-        std::string numberStr = tokens[current - 1].value;
-        bool isFloat = numberStr.find('.') != std::string::npos || 
-                      numberStr.find('e') != std::string::npos || 
-                      numberStr.find('E') != std::string::npos;
-        return std::make_unique<NumberLiteral>(numberStr, isFloat);
+        std::string_view numberStr = previous().value;
+        bool isFloat = numberStr.find('.') != std::string_view::npos || 
+                      numberStr.find('e') != std::string_view::npos || 
+                      numberStr.find('E') != std::string_view::npos;
+        return std::make_unique<NumberLiteral>(std::string(numberStr), isFloat);
     }
     
-    if (matchKeyword("true")) {
+    if (matchKeyword(Keyword::True)) {
         return std::make_unique<BooleanLiteral>(true);
     }
     
-    if (matchKeyword("false")) {
+    if (matchKeyword(Keyword::False)) {
         return std::make_unique<BooleanLiteral>(false);
     }
     
-    if (matchKeyword("null") || matchKeyword("none")) {
+    if (matchKeyword(Keyword::Null) || matchKeyword(Keyword::None)) {
         return std::make_unique<NullLiteral>();
     }
     
     if (match({TokenType::ValueBinding})) {
-        std::string binding = tokens[current - 1].value;
-        std::string bindingName = binding.substr(1); 
-        return std::make_unique<ValueBinding>(bindingName);
+        return std::make_unique<ValueBinding>(previous().symbol);
     }
     
     if (match({TokenType::Identifier})) {
-        return std::make_unique<Identifier>(tokens[current - 1].value);
+        return std::make_unique<Identifier>(previous().symbol);
     }
     
     if (match({TokenType::ParenOpen})) {
@@ -836,28 +956,27 @@ ExpressionPtr Parser::parsePrimary() {
         return expr;
     }
     
-    if (match({TokenType::BracketOpen})) {
+    if (match({TokenType::SquareBracketOpen})) {
         return parseArrayExpression();
     }
     
-    if (match({TokenType::BraceOpen})) {
+    if (matchOpenBrace()) {
         return parseObjectExpression();
     }
     
-    throw ParseError("Unexpected token in expression: '" + peek().value + "'", 
-                     peek().line, peek().column);
+    return errorExpression();
 }
 
 ExpressionPtr Parser::parseArrayExpression() {
     std::vector<ExpressionPtr> elements;
     
-    if (!check(TokenType::BracketClose)) {
+    if (!check(TokenType::SquareBracketClose)) {
         do {
             elements.push_back(parseExpression());
         } while (match({TokenType::Comma}));
     }
     
-    consume(TokenType::BracketClose, "Expected ']' after array elements");
+    consume(TokenType::SquareBracketClose, "Expected ']' after array elements");
     
     return std::make_unique<ArrayExpression>(std::move(elements));
 }
@@ -865,19 +984,20 @@ ExpressionPtr Parser::parseArrayExpression() {
 ExpressionPtr Parser::parseObjectExpression() {
     std::vector<std::unique_ptr<ObjectProperty>> properties;
     
-    if (!check(TokenType::BraceClose)) {
+    if (!checkCloseBrace()) {
         do {
             ExpressionPtr key;
             
             if (check(TokenType::Identifier)) {
-                key = std::make_unique<StringLiteral>(advance().value);
+                key = std::make_unique<StringLiteral>(std::string(advance().value));
             } else if (check(TokenType::String)) {
-                key = std::make_unique<StringLiteral>(advance().value);
-            } else if (match({TokenType::BracketOpen})) {
+                key = std::make_unique<StringLiteral>(std::string(advance().value));
+            } else if (match({TokenType::SquareBracketOpen})) {
                 key = parseExpression();
-                consume(TokenType::BracketClose, "Expected ']' after computed property");
+                consume(TokenType::SquareBracketClose, "Expected ']' after computed property");
             } else {
-                throw ParseError("Expected property name", peek().line, peek().column);
+                error("Expected property name", peek().offset);
+                key = std::make_unique<ErrorExpression>(peek().offset);
             }
             
             consume(TokenType::Colon, "Expected ':' after property name");
@@ -887,12 +1007,12 @@ ExpressionPtr Parser::parseObjectExpression() {
         } while (match({TokenType::Comma}));
     }
     
-    consume(TokenType::BraceClose, "Expected '}' after object properties");
+    consumeCloseBrace("Expected '}' after object properties");
     
     return std::make_unique<ObjectExpression>(std::move(properties));
 }
 
 bool Parser::checkNext(TokenType type) {
-    if (current + 1 >= tokens.size()) return false;
-    return tokens[current + 1].type == type;
+    if (isAtEnd()) return false;
+    return tokens.peekType(1) == type;
 }
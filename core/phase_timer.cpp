@@ -0,0 +1,244 @@
+#include "phase_timer.h"
+#include "json_writer.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <utility>
+
+std::atomic<PhaseTrace*> PhaseTrace::current{nullptr};
+
+namespace {
+
+// Events are batched per thread and handed to the trace when the thread's
+// outermost scope closes (or the batch fills up), so the many short scopes
+// inside a file (parseTag, parseBody) never touch the trace's lock.
+constexpr size_t BatchSize = 4096;
+
+std::atomic<uint32_t> nextThread{0};
+
+struct ThreadState {
+    uint32_t id = nextThread.fetch_add(1, std::memory_order_relaxed);
+    uint32_t file = PhaseTrace::NoFile;
+    std::vector<const char*> open;
+    std::vector<PhaseTrace::Event> batch;
+};
+
+ThreadState& threadState() {
+    thread_local ThreadState state;
+    return state;
+}
+
+double milliseconds(int64_t ns) {
+    return ns / 1e6;
+}
+
+}
+
+PhaseTrace::PhaseTrace() : origin(std::chrono::steady_clock::now()) {}
+
+PhaseTrace::~PhaseTrace() {
+    PhaseTrace* self = this;
+    current.compare_exchange_strong(self, nullptr);
+}
+
+void PhaseTrace::install(PhaseTrace* trace) {
+    current.store(trace, std::memory_order_relaxed);
+}
+
+int64_t PhaseTrace::now() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+uint32_t PhaseTrace::addFile(std::string_view path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    paths.emplace_back(path);
+    return static_cast<uint32_t>(paths.size() - 1);
+}
+
+void PhaseTrace::append(std::vector<Event>& batch) {
+    std::lock_guard<std::mutex> lock(mutex);
+    recorded.insert(recorded.end(), std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+    batch.clear();
+}
+
+std::vector<PhaseTrace::Event> PhaseTrace::events() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return recorded;
+}
+
+std::vector<std::string> PhaseTrace::files() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return paths;
+}
+
+void PhaseTimer::begin(PhaseTrace* active, const char* eventName) {
+    ThreadState& state = threadState();
+    for (const char* open : state.open) {
+        if (std::strcmp(open, eventName) == 0) {
+            nested = true;
+            break;
+        }
+    }
+    state.open.push_back(eventName);
+    trace = active;
+    name = eventName;
+    start = trace->now();
+}
+
+void PhaseTimer::end() {
+    int64_t duration = trace->now() - start;
+    ThreadState& state = threadState();
+    state.open.pop_back();
+    state.batch.push_back({name, std::move(detail), state.file, state.id, start, duration, nested});
+    if (state.open.empty() || state.batch.size() >= BatchSize) trace->append(state.batch);
+}
+
+FileTimer::FileTimer(std::string_view path) : timer("file") {
+    if (timer.trace == nullptr) return;
+    ThreadState& state = threadState();
+    outerFile = state.file;
+    state.file = timer.trace->addFile(path);
+}
+
+FileTimer::~FileTimer() {
+    if (timer.trace == nullptr) return;
+    // End the event here, while it is still attributed to this file.
+    timer.end();
+    timer.trace = nullptr;
+    threadState().file = outerFile;
+}
+
+void PhaseTrace::writeChromeTrace(JsonWriter& json) const {
+    std::vector<Event> events = this->events();
+    std::vector<std::string> files = this->files();
+    std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b) { return a.start < b.start; });
+
+    std::vector<uint32_t> threads;
+    for (const Event& event : events) threads.push_back(event.thread);
+    std::sort(threads.begin(), threads.end());
+    threads.erase(std::unique(threads.begin(), threads.end()), threads.end());
+
+    json.beginObject().field("displayTimeUnit", "ms").key("traceEvents").beginArray();
+    for (uint32_t thread : threads) {
+        json.beginObject()
+            .field("name", "thread_name")
+            .field("ph", "M")
+            .field("pid", 1)
+            .field("tid", thread)
+            .key("args")
+            .beginObject()
+            .field("name", "worker " + std::to_string(thread))
+            .endObject()
+            .endObject();
+    }
+    for (const Event& event : events) {
+        // Trace-event times are in microseconds.
+        json.beginObject()
+            .field("name", event.name)
+            .field("cat", "frontend")
+            .field("ph", "X")
+            .field("pid", 1)
+            .field("tid", event.thread)
+            .field("ts", event.start / 1e3)
+            .field("dur", event.duration / 1e3);
+        if (event.file != NoFile || !event.detail.empty()) {
+            json.key("args").beginObject();
+            if (event.file != NoFile) json.field("file", files[event.file]);
+            if (!event.detail.empty()) json.field("detail", event.detail);
+            json.endObject();
+        }
+        json.endObject();
+    }
+    json.endArray().endObject();
+}
+
+void PhaseTrace::printSummary(std::ostream& out, size_t top) const {
+    std::vector<Event> events = this->events();
+    std::vector<std::string> files = this->files();
+
+    struct Phase {
+        std::string name;
+        size_t count = 0;
+        int64_t total = 0;   // outermost scopes only
+    };
+    std::vector<Phase> phases;
+    struct File {
+        int64_t total = 0, lex = 0, parse = 0, serialize = 0;
+    };
+    std::vector<File> perFile(files.size());
+    std::map<std::pair<uint32_t, std::string>, std::pair<size_t, int64_t>> components;
+
+    for (const Event& event : events) {
+        auto phase = std::find_if(phases.begin(), phases.end(), [&](const Phase& p) { return p.name == event.name; });
+        if (phase == phases.end()) {
+            phases.push_back({event.name});
+            phase = phases.end() - 1;
+        }
+        ++phase->count;
+        if (event.nested) continue;
+        phase->total += event.duration;
+
+        if (event.file != NoFile) {
+            File& file = perFile[event.file];
+            if (std::strcmp(event.name, "file") == 0) file.total += event.duration;
+            else if (std::strcmp(event.name, "lex") == 0) file.lex += event.duration;
+            else if (std::strcmp(event.name, "parse") == 0) file.parse += event.duration;
+            else if (std::strcmp(event.name, "serialize") == 0) file.serialize += event.duration;
+        }
+        if (std::strcmp(event.name, "parseComponent") == 0) {
+            auto& entry = components[{event.file, event.detail}];
+            ++entry.first;
+            entry.second += event.duration;
+        }
+    }
+
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+
+    std::stable_sort(phases.begin(), phases.end(), [](const Phase& a, const Phase& b) { return a.total > b.total; });
+    out << std::left << std::setw(20) << "phase" << std::right << std::setw(12) << "count" << std::setw(14) << "total ms"
+        << "\n";
+    for (const Phase& phase : phases) {
+        out << std::left << std::setw(20) << phase.name << std::right << std::setw(12) << phase.count << std::setw(14)
+            << milliseconds(phase.total) << "\n";
+    }
+
+    std::vector<size_t> fileOrder;
+    for (size_t i = 0; i < perFile.size(); ++i) fileOrder.push_back(i);
+    std::stable_sort(fileOrder.begin(), fileOrder.end(),
+                     [&](size_t a, size_t b) { return perFile[a].total > perFile[b].total; });
+    if (fileOrder.size() > top) fileOrder.resize(top);
+    if (!fileOrder.empty()) {
+        out << "\n" << std::left << std::setw(40) << "slowest files" << std::right << std::setw(12) << "total ms"
+            << std::setw(12) << "lex" << std::setw(12) << "parse" << std::setw(12) << "serialize" << "\n";
+        for (size_t index : fileOrder) {
+            const File& file = perFile[index];
+            out << std::left << std::setw(40) << files[index] << std::right << std::setw(12)
+                << milliseconds(file.total) << std::setw(12) << milliseconds(file.lex) << std::setw(12)
+                << milliseconds(file.parse) << std::setw(12) << milliseconds(file.serialize) << "\n";
+        }
+    }
+
+    using Component = std::pair<std::pair<uint32_t, std::string>, std::pair<size_t, int64_t>>;
+    std::vector<Component> slowest(components.begin(), components.end());
+    std::stable_sort(slowest.begin(), slowest.end(),
+                     [](const Component& a, const Component& b) { return a.second.second > b.second.second; });
+    if (slowest.size() > top) slowest.resize(top);
+    if (!slowest.empty()) {
+        out << "\n" << std::left << std::setw(52) << "slowest components" << std::right << std::setw(12) << "total ms"
+            << "\n";
+        for (const Component& component : slowest) {
+            std::string where = component.first.first == NoFile ? component.first.second
+                                                                : files[component.first.first] + ": " +
+                                                                      component.first.second;
+            if (component.second.first > 1) where += " (x" + std::to_string(component.second.first) + ")";
+            out << std::left << std::setw(52) << where << std::right << std::setw(12)
+                << milliseconds(component.second.second) << "\n";
+        }
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,119 @@
+#include "work_stealing_pool.h"
+
+namespace {
+
+// Which pool and deque the current thread works for, so that tasks submitted
+// from inside a task land on the submitting worker's own deque.
+thread_local const WorkStealingPool* currentPool = nullptr;
+thread_local unsigned currentIndex = 0;
+
+}
+
+WorkStealingPool::WorkStealingPool(unsigned threadCount) {
+    if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+    if (threadCount == 0) threadCount = 1;
+
+    workers.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    threads.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        threads.emplace_back([this, i] { run(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto& thread : threads) thread.join();
+}
+
+void WorkStealingPool::submit(Task task) {
+    unsigned index = currentPool == this
+        ? currentIndex
+        : nextWorker.fetch_add(1, std::memory_order_relaxed) % size();
+
+    // Count first so a worker that pops the task can never see the counters
+    // lag behind the deques.
+    unfinished.fetch_add(1);
+    queued.fetch_add(1);
+    {
+        Worker& worker = *workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+    // A worker counts itself in `sleeping` before it checks `queued`, and
+    // we bumped `queued` before reading `sleeping`, so one of us sees the
+    // other. Taking the lock waits out a worker between its check and its
+    // wait, so the notify cannot be lost.
+    if (sleeping.load() != 0) {
+        { std::lock_guard<std::mutex> lock(stateMutex); }
+        workAvailable.notify_one();
+    }
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    allDone.wait(lock, [this] { return unfinished.load() == 0; });
+    if (firstError) {
+        std::exception_ptr error = firstError;
+        firstError = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void WorkStealingPool::run(unsigned index) {
+    currentPool = this;
+    currentIndex = index;
+
+    while (true) {
+        Task task;
+        if (popLocal(index, task) || steal(index, task)) {
+            queued.fetch_sub(1);
+            try {
+                task();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                if (!firstError) firstError = std::current_exception();
+            }
+            if (unfinished.fetch_sub(1) == 1) {
+                // wait() checks the count under the lock; see submit().
+                { std::lock_guard<std::mutex> lock(stateMutex); }
+                allDone.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(stateMutex);
+        sleeping.fetch_add(1);
+        workAvailable.wait(lock, [this] { return stopping || queued.load() > 0; });
+        sleeping.fetch_sub(1);
+        if (stopping && queued.load() == 0) return;
+    }
+}
+
+bool WorkStealingPool::popLocal(unsigned index, Task& task) {
+    Worker& worker = *workers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) return false;
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(unsigned thief, Task& task) {
+    unsigned count = size();
+    for (unsigned offset = 1; offset < count; ++offset) {
+        Worker& victim = *workers[(thief + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) continue;
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
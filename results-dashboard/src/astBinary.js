@@ -0,0 +1,58 @@
+// Reader for the binary AST written by writeASTBinary (core/include/ast_binary.h).
+// Produces the same shape as ast-results.json so the views need not care
+// which file was loaded.
+
+const MAGIC = "ALTA";
+const VERSION = 1;
+
+export function decodeASTBinary(buffer) {
+  const view = new DataView(buffer);
+  if (buffer.byteLength < 32 || String.fromCharCode(...new Uint8Array(buffer, 0, 4)) !== MAGIC) {
+    throw new Error("not an Alterion binary AST");
+  }
+  if (view.getUint16(4, true) !== VERSION) {
+    throw new Error(`unsupported binary AST version ${view.getUint16(4, true)}`);
+  }
+  const headerSize = view.getUint16(6, true);
+  const count = view.getUint32(8, true);
+  const recordSize = view.getUint32(12, true);
+  const stringCount = view.getUint32(16, true);
+  const root = view.getUint32(24, true);
+  const stringsAt = headerSize + count * recordSize;
+  const dataAt = stringsAt + stringCount * 8;
+  if (dataAt > buffer.byteLength || root >= count) {
+    throw new Error("truncated binary AST");
+  }
+
+  const decoder = new TextDecoder();
+  const strings = new Array(stringCount);
+  const string = (index) => {
+    if (strings[index] === undefined) {
+      const entry = stringsAt + index * 8;
+      const start = dataAt + view.getUint32(entry, true);
+      strings[index] = decoder.decode(new Uint8Array(buffer, start, view.getUint32(entry + 4, true)));
+    }
+    return strings[index];
+  };
+
+  // Records are breadth-first, so building them back to front means every
+  // child object already exists when its parent is built.
+  const nodes = new Array(count);
+  for (let i = count - 1; i >= 0; i--) {
+    const at = headerSize + i * recordSize;
+    const flags = view.getUint8(at + 1);
+    const first = view.getUint32(at + 24, true);
+    const childCount = view.getUint32(at + 28, true);
+    const node = {
+      type: String(view.getUint8(at)),
+      name: string(view.getUint32(at + 12, true)),
+      line: view.getUint32(at + 4, true),
+      column: view.getUint32(at + 8, true),
+      children: nodes.slice(first, first + childCount),
+    };
+    if (flags & 1) node.value = string(view.getUint32(at + 16, true));
+    if (flags & 2) node.error = string(view.getUint32(at + 20, true));
+    nodes[i] = node;
+  }
+  return nodes[root];
+}
@@ -1,4 +1,5 @@
 import React, { useEffect, useState } from "react";
+import { decodeASTBinary } from "../astBinary";
 
 const POLL_INTERVAL = 3000;
 const JSON_PATH = "/results/lexer-results.json";
@@ -33,11 +34,18 @@ export default function ResultsDashboard() {
 
   useEffect(() => {
     if (activeTab === 'ast') {
-      fetch('/results/ast-results.json')
+      // The binary form is smaller and quicker to read; older result
+      // directories only have the JSON one.
+      fetch('/results/ast-results.bin')
         .then(res => {
           if (!res.ok) throw new Error(`HTTP ${res.status}: ${res.statusText}`);
-          return res.json();
+          return res.arrayBuffer();
         })
+        .then(decodeASTBinary)
+        .catch(() => fetch('/results/ast-results.json').then(res => {
+          if (!res.ok) throw new Error(`HTTP ${res.status}: ${res.statusText}`);
+          return res.json();
+        }))
         .then(data => {
           setAst(data);
           setAstError(null);
@@ -1,5 +1,5 @@
 #!/bin/sh/
 cd "$(dirname "$0")/.."
-g++ -std=c++17 -Icore/include tests/unit/lexertest.cpp core/lexer/lexer.cpp -o lexertest
+g++ -std=c++17 -Icore/include tests/unit/lexertest.cpp core/lexer/lexer.cpp core/lexer/byte_scan.cpp core/lexer/symbol_table.cpp core/lexer/source_buffer.cpp -o lexertest
 ./lexertest
 cat lexer_test_output.csv
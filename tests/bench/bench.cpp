@@ -0,0 +1,288 @@
+#include "../../core/include/alloc_stats.h"
+#include "../../core/include/byte_scan.h"
+#include "../../core/include/json_writer.h"
+#include "../../core/include/lexer.h"
+#include "../../core/include/parser.h"
+#include "../../core/include/source_buffer.h"
+#include "corpus.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#ifndef ALTERION_VERSION
+#define ALTERION_VERSION "unknown"
+#endif
+
+// Front-end throughput benchmark over generated corpora and real files.
+// For each input it reports Lexer::tokenize and Parser::parse separately:
+// MB/s, tokens/s, heap allocations per token, peak live heap and peak RSS,
+// as a table and, with --json, as a machine-readable report for tracking
+// regressions.
+//
+//   bench [--mb N] [--runs N] [--seed N] [--shape NAME]... [--json PATH|-]
+//         [--emit DIR] [file.alt ...]
+//
+// Shapes are altx, expressions, comments, utf8, mixed and broken (all by
+// default; --shape picks some, --mb 0 skips them). Each is generated at
+// --mb MB.
+// --emit DIR writes the generated corpora as .alt files and exits.
+//
+// Times are the best of --runs; allocation counts are per run. Peak RSS is
+// the high-water mark during the phase where the OS can reset it (Linux),
+// otherwise the process-wide peak so far.
+
+namespace {
+
+struct PhaseResult {
+    std::string input;
+    const char* phase;
+    size_t bytes = 0;
+    size_t tokens = 0;
+    size_t errors = 0;
+    double seconds = 1e30;
+    size_t allocations = 0;
+    size_t allocated = 0;
+    size_t peakLive = 0;
+    uint64_t peakRss = 0;
+    bool rssIsPhasePeak = false;
+};
+
+// Returns true if the high-water mark now starts again from the current RSS.
+bool resetPeakRss() {
+#ifdef __linux__
+    std::ofstream clear("/proc/self/clear_refs");
+    clear << "5";
+    clear.close();
+    return !clear.fail();
+#else
+    return false;
+#endif
+}
+
+uint64_t peakRss() {
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) return std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+    }
+#endif
+#ifndef _WIN32
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void measure(const std::string& input, const std::shared_ptr<const SourceBuffer>& source, int runs,
+             std::vector<PhaseResult>& results) {
+    PhaseResult lex{input, "lex"};
+    PhaseResult parse{input, "parse"};
+    lex.bytes = parse.bytes = source->size();
+
+    std::vector<Token> tokens;
+    for (int run = 0; run < runs; ++run) {
+        tokens = std::vector<Token>();
+        bool phasePeak = resetPeakRss();
+        AllocationScope allocations;
+        auto start = std::chrono::steady_clock::now();
+        Lexer lexer(source);
+        tokens = lexer.tokenize();
+        double seconds = secondsSince(start);
+        AllocationCounts counts = allocations.counts();
+        lex.allocations = counts.allocations;
+        lex.allocated = counts.bytes;
+        lex.peakLive = counts.peakLiveBytes;
+        lex.seconds = std::min(lex.seconds, seconds);
+        lex.peakRss = std::max(lex.peakRss, peakRss());
+        lex.rssIsPhasePeak = phasePeak;
+        lex.errors = lexer.errors().size();
+    }
+    lex.tokens = parse.tokens = tokens.size();
+
+    for (int run = 0; run < runs; ++run) {
+        std::vector<Token> copy = tokens;
+        bool phasePeak = resetPeakRss();
+        AllocationScope allocations;
+        auto start = std::chrono::steady_clock::now();
+        Parser parser(std::move(copy));
+        std::unique_ptr<Program> program = parser.parse();
+        double seconds = secondsSince(start);
+        AllocationCounts counts = allocations.counts();
+        parse.allocations = counts.allocations;
+        parse.allocated = counts.bytes;
+        parse.peakLive = counts.peakLiveBytes;
+        parse.seconds = std::min(parse.seconds, seconds);
+        parse.peakRss = std::max(parse.peakRss, peakRss());
+        parse.rssIsPhasePeak = phasePeak;
+        parse.errors = parser.errors().size();
+    }
+    results.push_back(lex);
+    results.push_back(parse);
+}
+
+double mbPerSecond(const PhaseResult& r) {
+    return r.seconds > 0 ? (r.bytes / (1024.0 * 1024.0)) / r.seconds : 0.0;
+}
+
+double tokensPerSecond(const PhaseResult& r) {
+    return r.seconds > 0 ? r.tokens / r.seconds : 0.0;
+}
+
+double allocationsPerToken(const PhaseResult& r) {
+    return r.tokens > 0 ? static_cast<double>(r.allocations) / r.tokens : 0.0;
+}
+
+void printTable(const std::vector<PhaseResult>& results, std::ostream& out) {
+    out << std::left << std::setw(28) << "input" << std::setw(7) << "phase" << std::right << std::setw(12) << "bytes"
+        << std::setw(10) << "tokens" << std::setw(10) << "MB/s" << std::setw(10) << "Mtok/s" << std::setw(10)
+        << "alloc/tok" << std::setw(11) << "peak heap" << std::setw(11) << "peak RSS" << std::setw(8) << "errors" << "\n";
+    for (const PhaseResult& r : results) {
+        out << std::left << std::setw(28) << r.input << std::setw(7) << r.phase << std::right << std::setw(12)
+            << r.bytes << std::setw(10) << r.tokens << std::fixed << std::setprecision(1) << std::setw(10)
+            << mbPerSecond(r) << std::setprecision(2) << std::setw(10) << tokensPerSecond(r) / 1e6
+            << std::setprecision(3) << std::setw(10) << allocationsPerToken(r) << std::setprecision(1)
+            << std::setw(8) << r.peakLive / (1024.0 * 1024.0) << " MB" << std::setw(8)
+            << r.peakRss / (1024.0 * 1024.0) << " MB" << std::setw(8) << r.errors << "\n";
+    }
+}
+
+bool writeReport(const std::string& path, const std::vector<PhaseResult>& results, int runs, uint32_t seed) {
+    std::FILE* file = path == "-" ? stdout : std::fopen(path.c_str(), "wb");
+    if (file == nullptr) return false;
+    bool ok;
+    {
+        JsonWriter json(fileno(file));
+        json.beginObject()
+            .field("benchmark", "alterion-frontend")
+            .field("version", ALTERION_VERSION)
+            .field("scanner", bytescan::name(bytescan::active()))
+            .field("runs", runs)
+            .field("seed", seed)
+            .key("results")
+            .beginArray();
+        for (const PhaseResult& r : results) {
+            json.beginObject()
+                .field("input", r.input)
+                .field("phase", r.phase)
+                .field("bytes", r.bytes)
+                .field("tokens", r.tokens)
+                .field("errors", r.errors)
+                .field("seconds", r.seconds)
+                .field("mbPerSecond", mbPerSecond(r))
+                .field("tokensPerSecond", tokensPerSecond(r))
+                .field("allocations", r.allocations)
+                .field("allocatedBytes", r.allocated)
+                .field("allocationsPerToken", allocationsPerToken(r))
+                .field("peakLiveHeapBytes", r.peakLive)
+                .field("peakRssBytes", r.peakRss)
+                .field("peakRssIsPhasePeak", r.rssIsPhasePeak)
+                .endObject();
+        }
+        json.endArray().endObject();
+        ok = json.flush();
+    }
+    if (file != stdout) ok = std::fclose(file) == 0 && ok;
+    return ok;
+}
+
+int usage() {
+    std::cerr << "usage: bench [--mb N] [--runs N] [--seed N] [--shape NAME]... [--json PATH|-] [--emit DIR] "
+                 "[file.alt ...]\n";
+    return 2;
+}
+
+}
+
+int main(int argc, char** argv) {
+    size_t megabytes = 8;
+    int runs = 5;
+    uint32_t seed = 1;
+    std::vector<corpus::Shape> shapes;
+    std::string jsonPath;
+    std::string emitDirectory;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--mb" && i + 1 < argc) {
+            megabytes = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--runs" && i + 1 < argc) {
+            runs = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--shape" && i + 1 < argc) {
+            corpus::Shape shape;
+            if (!corpus::parse(argv[++i], shape)) return usage();
+            shapes.push_back(shape);
+        } else if (arg == "--json" && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (arg == "--emit" && i + 1 < argc) {
+            emitDirectory = argv[++i];
+        } else if (arg == "-h" || arg == "--help" || arg.rfind("--", 0) == 0) {
+            return usage();
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (shapes.empty()) shapes = corpus::allShapes();
+
+    if (!emitDirectory.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(emitDirectory, ec);
+        for (corpus::Shape shape : shapes) {
+            std::filesystem::path path = std::filesystem::path(emitDirectory) / (std::string(corpus::name(shape)) + ".alt");
+            std::ofstream(path, std::ios::binary) << corpus::generate(shape, megabytes << 20, seed);
+            std::cout << "wrote " << path.string() << "\n";
+        }
+        return 0;
+    }
+
+    // With the report on stdout, keep stdout pure JSON.
+    std::ostream& log = jsonPath == "-" ? std::cerr : std::cout;
+    log << "byte scanner: " << bytescan::name(bytescan::active()) << ", best of " << runs << " runs\n";
+
+    std::vector<PhaseResult> results;
+    if (megabytes > 0) {
+        for (corpus::Shape shape : shapes) {
+            auto source = SourceBuffer::fromString(corpus::generate(shape, megabytes << 20, seed));
+            measure(corpus::name(shape), source, runs, results);
+        }
+    }
+    for (const std::string& path : files) {
+        auto source = SourceBuffer::fromFile(path);
+        if (!source) {
+            std::cerr << "[ERROR] Failed to open " << path << "\n";
+            return 1;
+        }
+        measure(path, source, runs, results);
+    }
+
+    printTable(results, log);
+    if (!jsonPath.empty() && !writeReport(jsonPath, results, runs, seed)) {
+        std::cerr << "[ERROR] Could not write " << jsonPath << "\n";
+        return 1;
+    }
+    return 0;
+}
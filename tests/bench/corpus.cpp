@@ -0,0 +1,293 @@
+#include "corpus.h"
+#include <random>
+
+namespace corpus {
+namespace {
+
+// mt19937's output sequence is fixed by the standard (the distributions are
+// not), so picks are taken modulo directly to keep corpora identical across
+// standard libraries.
+class Generator {
+public:
+    Generator(uint32_t seed, size_t targetBytes) : rng(seed) { out.reserve(targetBytes + 64 * 1024); }
+
+    std::string out;
+
+    uint32_t pick(uint32_t n) { return static_cast<uint32_t>(rng() % n); }
+    template <size_t N>
+    const char* pick(const char* const (&choices)[N]) { return choices[pick(N)]; }
+
+    void indent(int depth) { out.append(static_cast<size_t>(depth) * 4, ' '); }
+    void number() { out += std::to_string(pick(1000)); }
+
+    void operand() {
+        static const char* const names[] = {"count", "limit", "total", "items.size", "step", "offset", "a", "b"};
+        switch (pick(6)) {
+            case 0: number(); break;
+            case 1: out += "f("; out += pick(names); out += ", "; number(); out += ")"; break;
+            case 2: out += pick(names); out += "["; number(); out += "]"; break;
+            default: out += pick(names); break;
+        }
+    }
+
+    void expression(int depth) {
+        static const char* const operators[] = {" + ", " - ", " * ", " / ", " % ", " < ", " >= ",
+                                                " == ", " != ", " && ", " || ", " ** "};
+        if (depth > 0 && pick(3) == 0) {
+            out += "(";
+            expression(depth - 1);
+            out += ")";
+        } else {
+            switch (pick(8)) {
+                case 0: out += "-"; operand(); break;
+                case 1: out += "!done"; break;
+                default: operand(); break;
+            }
+        }
+        for (uint32_t terms = pick(4); terms > 0; --terms) {
+            out += pick(operators);
+            if (depth > 0 && pick(4) == 0) {
+                out += "(";
+                expression(depth - 1);
+                out += ")";
+            } else {
+                operand();
+            }
+        }
+    }
+
+    void tag(int depth, int level, bool utf8) {
+        static const char* const names[] = {"div", "span", "section", "ul", "li", "p", "button", "header"};
+        static const char* const words[] = {"Count", "Total", "items", "of", "the", "and", "Widget", "Summary"};
+        static const char* const utf8Words[] = {"Übersicht", "café", "naïve", "数据", "日本語", "Größe", "✓", "🎉"};
+        const char* tagName = pick(names);
+        indent(level);
+        out += '<';
+        out += tagName;
+        if (pick(2)) { out += " class=\""; out += tagName; out += "-"; number(); out += '"'; }
+        if (pick(3) == 0) out += " data-id={count}";
+        if (pick(4) == 0) out += " onClick={increment}";
+        if (pick(5) == 0) out += " disabled";
+        if (pick(6) == 0) out += " style=\"color:red;margin:0 4px\"";
+        if (depth == 0 && pick(5) == 0) {
+            out += " />\n";
+            return;
+        }
+        out += ">\n";
+        if (depth > 0) {
+            for (uint32_t children = 1 + pick(3); children > 0; --children) tag(depth - 1, level + 1, utf8);
+        }
+        indent(level + 1);
+        for (uint32_t n = 1 + pick(5); n > 0; --n) {
+            out += utf8 && pick(2) ? pick(utf8Words) : pick(words);
+            out += ' ';
+        }
+        if (pick(2)) out += "{count + 1}";
+        out += '\n';
+        indent(level);
+        out += "</";
+        out += tagName;
+        out += ">\n";
+    }
+
+    void altxComponent(uint32_t id, bool utf8) {
+        out += "component Panel";
+        out += std::to_string(id);
+        out += " {\n    count = 0\n    title = \"Panel ";
+        out += std::to_string(id);
+        out += "\"\n    increment {\n        count = count + 1\n    }\n    render:\n";
+        tag(3 + static_cast<int>(pick(3)), 2, utf8);
+        out += "}\n\n";
+    }
+
+    void expressionFunction(uint32_t id) {
+        out += "function compute";
+        out += std::to_string(id);
+        out += "(a, b, items) {\n";
+        for (uint32_t statements = 3 + pick(6); statements > 0; --statements) {
+            switch (pick(5)) {
+                case 0:
+                    out += "    if (";
+                    expression(2);
+                    out += ") {\n        return ";
+                    expression(2);
+                    out += "\n    }\n";
+                    break;
+                case 1:
+                    out += "    let values = [";
+                    expression(1);
+                    out += ", ";
+                    expression(1);
+                    out += ", \"x\", null, true]\n";
+                    break;
+                case 2:
+                    out += "    const record = { total: ";
+                    expression(1);
+                    out += ", name: \"r";
+                    number();
+                    out += "\" }\n";
+                    break;
+                default:
+                    out += "    let v";
+                    number();
+                    out += " = ";
+                    expression(3);
+                    out += "\n";
+                    break;
+            }
+        }
+        out += "    return ";
+        expression(2);
+        out += "\n}\n\n";
+    }
+
+    // expressionFunction with about one statement in three broken the way
+    // half-typed code is: missing names, parentheses and operands, stray
+    // closers. Each break is confined to its statement.
+    void brokenFunction(uint32_t id) {
+        out += "function broken";
+        out += std::to_string(id);
+        out += "(a, b) {\n";
+        for (uint32_t statements = 3 + pick(6); statements > 0; --statements) {
+            switch (pick(3) == 0 ? pick(4) : 4) {
+                case 0:
+                    out += "    let = ";
+                    expression(2);
+                    out += "\n";
+                    break;
+                case 1:
+                    out += "    if (";
+                    expression(2);
+                    out += " {\n        return a\n    }\n";
+                    break;
+                case 2:
+                    out += "    ) ";
+                    expression(1);
+                    out += "\n";
+                    break;
+                case 3:
+                    out += "    let v = ";
+                    expression(1);
+                    out += " *\n";
+                    break;
+                default:
+                    out += "    let v";
+                    number();
+                    out += " = ";
+                    expression(3);
+                    out += "\n";
+                    break;
+            }
+        }
+        out += "    return ";
+        expression(2);
+        out += "\n}\n\n";
+    }
+
+    void commentBlock(uint32_t id, bool utf8) {
+        static const char* const sentences[] = {
+            "Keeps the running total in sync with the list below.",
+            "TODO: move this into the store once the API settles.",
+            "The order matters here: limit must be read before step.",
+            "See the design notes for why this is not a getter.",
+        };
+        static const char* const utf8Sentences[] = {
+            "Größenänderung wird später berechnet — nicht hier.",
+            "Комментарий: значение пересчитывается при каждом шаге.",
+            "注意：この値は毎回再計算されます。",
+            "Résumé du café: naïve but correct ✓",
+        };
+        for (uint32_t lines = 2 + pick(4); lines > 0; --lines) {
+            out += "// ";
+            out += utf8 && pick(2) ? pick(utf8Sentences) : pick(sentences);
+            out += '\n';
+        }
+        out += "/*\n";
+        for (uint32_t lines = 2 + pick(6); lines > 0; --lines) {
+            out += " * ";
+            out += utf8 && pick(2) ? pick(utf8Sentences) : pick(sentences);
+            out += '\n';
+        }
+        out += " */\nlet setting";
+        out += std::to_string(id);
+        out += " = ";
+        number();
+        out += " // ";
+        out += pick(sentences);
+        out += "\n\n";
+    }
+
+    void utf8Component(uint32_t id) {
+        static const char* const identifiers[] = {"größe", "café", "naïve", "名前", "значение", "données"};
+        static const char* const strings[] = {"日本語のテキスト 🎉", "Übersicht — Größe", "Ελληνικά κείμενα",
+                                              "emoji 🚀✨🔥 mixed", "données naïves"};
+        out += "component Ansicht";
+        out += std::to_string(id);
+        out += " {\n";
+        for (uint32_t fields = 2 + pick(4); fields > 0; --fields) {
+            out += "    ";
+            out += pick(identifiers);
+            number();
+            out += " = \"";
+            out += pick(strings);
+            out += "\"\n";
+        }
+        out += "    // ";
+        out += pick(strings);
+        out += "\n    render:\n";
+        tag(2, 2, true);
+        out += "}\n\n";
+    }
+
+private:
+    std::mt19937 rng;
+};
+
+}
+
+const std::vector<Shape>& allShapes() {
+    static const std::vector<Shape> shapes{Shape::ALTX, Shape::Expressions, Shape::Comments,
+                                           Shape::UTF8, Shape::Mixed, Shape::Broken};
+    return shapes;
+}
+
+const char* name(Shape shape) {
+    switch (shape) {
+        case Shape::ALTX: return "altx";
+        case Shape::Expressions: return "expressions";
+        case Shape::Comments: return "comments";
+        case Shape::UTF8: return "utf8";
+        case Shape::Broken: return "broken";
+        default: return "mixed";
+    }
+}
+
+bool parse(const std::string& text, Shape& shape) {
+    for (Shape candidate : allShapes()) {
+        if (text == name(candidate)) {
+            shape = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string generate(Shape shape, size_t targetBytes, uint32_t seed) {
+    Generator g(seed, targetBytes);
+    for (uint32_t id = 0; g.out.size() < targetBytes; ++id) {
+        Shape next = shape == Shape::Mixed ? allShapes()[id % 4] : shape;
+        switch (next) {
+            case Shape::ALTX: g.altxComponent(id, false); break;
+            case Shape::Expressions: g.expressionFunction(id); break;
+            case Shape::Comments: g.commentBlock(id, false); break;
+            case Shape::Broken: g.brokenFunction(id); break;
+            default:
+                if (id % 3 == 2) g.commentBlock(id, true);
+                else g.utf8Component(id);
+                break;
+        }
+    }
+    return std::move(g.out);
+}
+
+} // namespace corpus
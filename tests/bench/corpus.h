@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Synthetic .alt sources for the benchmarks. Each shape stresses one part of
+// the front end; the output depends only on the shape, the size and the
+// seed, so runs on different machines and days lex the same bytes.
+namespace corpus {
+
+enum class Shape {
+    ALTX,          // components whose render blocks are deep tag trees
+    Expressions,   // functions of long operator chains, calls and literals
+    Comments,      // short statements buried in line and block comments
+    UTF8,          // non-ASCII identifiers, strings, comments and text
+    Mixed,         // the first four, interleaved per component
+    Broken         // expression functions with frequent syntax errors
+};
+
+const std::vector<Shape>& allShapes();
+const char* name(Shape shape);
+// Accepts the names returned by name(); returns false for anything else.
+bool parse(const std::string& text, Shape& shape);
+
+// At least `targetBytes` of source, cut at a top-level declaration.
+std::string generate(Shape shape, size_t targetBytes, uint32_t seed = 1);
+
+} // namespace corpus
@@ -0,0 +1,140 @@
+#include "../../core/include/byte_scan.h"
+#include "../../core/include/lexer.h"
+#include "../../core/include/source_buffer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Lexer throughput micro-benchmark. Lexes every examples/*.alt file (or the
+// files given on the command line) plus a synthetic corpus and reports the
+// best bytes/sec over several runs.
+//
+//   lexbench [--synthetic-mb N] [--runs N] [file.alt ...]
+//
+// Set ALTERION_SCAN=scalar|sse2|avx2 to compare byte scanner implementations.
+
+namespace {
+
+struct Result {
+    size_t tokens = 0;
+    double seconds = 0.0;
+};
+
+Result lexOnce(const std::shared_ptr<const SourceBuffer>& source) {
+    auto start = std::chrono::steady_clock::now();
+    Lexer lexer(source);
+    std::vector<Token> tokens = lexer.tokenize();
+    auto end = std::chrono::steady_clock::now();
+    return {tokens.size(), std::chrono::duration<double>(end - start).count()};
+}
+
+// Best of `runs`; small inputs are lexed repeatedly until each run covers
+// at least a few milliseconds so the clock resolution does not dominate.
+Result measure(const std::shared_ptr<const SourceBuffer>& source, int runs) {
+    size_t repeat = 1;
+    if (source->size() > 0) {
+        repeat = std::max<size_t>(1, (4 * 1024 * 1024) / source->size());
+    }
+    Result best;
+    best.seconds = 1e30;
+    for (int run = 0; run < runs; ++run) {
+        Result total;
+        for (size_t i = 0; i < repeat; ++i) {
+            Result once = lexOnce(source);
+            total.tokens = once.tokens;
+            total.seconds += once.seconds;
+        }
+        total.seconds /= static_cast<double>(repeat);
+        if (total.seconds < best.seconds) best = total;
+    }
+    return best;
+}
+
+// Mixed component source: state, methods, comments, ALTX with attributes
+// and text, plus a share of non-ASCII identifiers, strings and text.
+std::string syntheticSource(size_t targetBytes) {
+    static const char* block =
+        "// Generated component\n"
+        "component Widget {\n"
+        "    count: number = 0\n"
+        "    label = \"Total: \\\"items\\\"\\n\"\n"
+        "    /* multi-line\n"
+        "       comment block */\n"
+        "    increment {\n"
+        "        count = count + 1 * (step - 2) / 4\n"
+        "        if (count >= limit && !paused || force) { reset() }\n"
+        "    }\n"
+        "    café = \"naïve résumé — 日本語\"\n"
+        "    render:\n"
+        "        <div class=\"widget\" data-id={count} center>\n"
+        "            <h2>Widget Übersicht</h2>\n"
+        "            <span style=\"color:red;margin:0\">Count: {count}</span>\n"
+        "            <button onClick={increment}>+</button>\n"
+        "        </div>\n"
+        "}\n\n";
+    std::string source;
+    source.reserve(targetBytes + 1024);
+    while (source.size() < targetBytes) {
+        source += block;
+    }
+    return source;
+}
+
+void report(const std::string& name, size_t bytes, const Result& result) {
+    double mbPerSec = result.seconds > 0 ? (bytes / (1024.0 * 1024.0)) / result.seconds : 0.0;
+    double tokensPerSec = result.seconds > 0 ? result.tokens / result.seconds : 0.0;
+    std::cout << std::left << std::setw(36) << name << std::right
+              << std::setw(12) << bytes << " B"
+              << std::setw(10) << result.tokens << " tok"
+              << std::setw(10) << std::fixed << std::setprecision(1) << mbPerSec << " MB/s"
+              << std::setw(8) << std::setprecision(2) << tokensPerSec / 1e6 << " Mtok/s\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    size_t syntheticMb = 100;
+    int runs = 5;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--synthetic-mb" && i + 1 < argc) {
+            syntheticMb = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--runs" && i + 1 < argc) {
+            runs = std::max(1, std::atoi(argv[++i]));
+        } else {
+            files.push_back(arg);
+        }
+    }
+
+    if (files.empty()) {
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator("examples", ec)) {
+            if (entry.path().extension() == ".alt") files.push_back(entry.path().string());
+        }
+        std::sort(files.begin(), files.end());
+    }
+
+    std::cout << "byte scanner: " << bytescan::name(bytescan::active()) << "\n";
+    for (const auto& path : files) {
+        auto source = SourceBuffer::fromFile(path);
+        if (!source) {
+            std::cerr << "[ERROR] Failed to open " << path << "\n";
+            return 1;
+        }
+        report(path, source->size(), measure(source, runs));
+    }
+
+    if (syntheticMb > 0) {
+        auto source = SourceBuffer::fromString(syntheticSource(syntheticMb * 1024 * 1024));
+        report("synthetic (" + std::to_string(syntheticMb) + " MB)", source->size(),
+               measure(source, std::min(runs, 3)));
+    }
+    return 0;
+}
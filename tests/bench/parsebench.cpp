@@ -0,0 +1,241 @@
+#include "../../core/include/lexer.h"
+#include "../../core/include/parser.h"
+#include "../../core/include/source_buffer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Expression parser throughput benchmark. Lexes each input once, then parses
+// the tokens several times and reports the best parse-only tokens/sec, so
+// lexer speed does not mask changes in the parser. Tokens are parsed both
+// from a std::vector<Token> and from a TokenBuffer (type column only for
+// lookahead); on Linux each line also gives the parse's cache misses and L1
+// data-cache read misses per token, or n/a where the kernel exposes no
+// hardware counters (most VMs and containers).
+//
+//   parsebench [--synthetic-mb N] [--depth N] [--runs N] [file.alt ...]
+//
+// Each synthetic MB is about 425k tokens.
+//
+// The synthetic input is one assignment per line whose right-hand side nests
+// --depth parenthesised levels, each mixing every binary precedence level
+// plus unary operators, calls and member access.
+
+namespace {
+
+// A hardware event counted for this thread between start() and stop();
+// stop() returns -1 when the event cannot be opened.
+class HardwareCounter {
+public:
+    enum class Event { CacheMisses, L1DataReadMisses };
+
+    explicit HardwareCounter(Event event) {
+#ifdef __linux__
+        perf_event_attr attributes;
+        std::memset(&attributes, 0, sizeof(attributes));
+        attributes.size = sizeof(attributes);
+        if (event == Event::CacheMisses) {
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+        } else {
+            attributes.type = PERF_TYPE_HW_CACHE;
+            attributes.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        }
+        attributes.disabled = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        fd = static_cast<int>(syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0));
+#else
+        (void)event;
+#endif
+    }
+    ~HardwareCounter() {
+#ifdef __linux__
+        if (fd >= 0) close(fd);
+#endif
+    }
+    HardwareCounter(const HardwareCounter&) = delete;
+    HardwareCounter& operator=(const HardwareCounter&) = delete;
+
+    void start() {
+#ifdef __linux__
+        if (fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+    int64_t stop() {
+#ifdef __linux__
+        if (fd < 0) return -1;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t value = 0;
+        if (read(fd, &value, sizeof(value)) != sizeof(value)) return -1;
+        return static_cast<int64_t>(value);
+#else
+        return -1;
+#endif
+    }
+
+private:
+    int fd = -1;
+};
+
+struct Layout {
+    double seconds = 1e30;
+    int64_t cacheMisses = -1;   // of the fastest run; -1 when not counted
+    int64_t l1Misses = -1;
+};
+
+struct Result {
+    size_t tokens = 0;
+    double lexSeconds = 0.0;
+    Layout vector;
+    Layout columns;
+};
+
+// Best of `runs` parses of a fresh copy of `tokens` (copied outside the
+// timed region).
+template <typename Tokens>
+Layout parseRuns(const Tokens& tokens, int runs) {
+    Layout layout;
+    HardwareCounter misses(HardwareCounter::Event::CacheMisses);
+    HardwareCounter l1(HardwareCounter::Event::L1DataReadMisses);
+    for (int run = 0; run < runs; ++run) {
+        Tokens copy = tokens;
+        misses.start();
+        l1.start();
+        auto start = std::chrono::steady_clock::now();
+        Parser parser(std::move(copy));
+        auto program = parser.parse();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        int64_t cacheMisses = misses.stop();
+        int64_t l1Misses = l1.stop();
+        if (seconds < layout.seconds) {
+            layout.seconds = seconds;
+            layout.cacheMisses = cacheMisses;
+            layout.l1Misses = l1Misses;
+        }
+    }
+    return layout;
+}
+
+Result measure(const std::shared_ptr<const SourceBuffer>& source, int runs) {
+    Result result;
+    Lexer lexer(source);
+    auto lexStart = std::chrono::steady_clock::now();
+    std::vector<Token> tokens = lexer.tokenize();
+    result.lexSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - lexStart).count();
+    result.tokens = tokens.size();
+    result.vector = parseRuns(tokens, runs);
+
+    Lexer columnLexer(source);
+    TokenBuffer buffer = columnLexer.tokenizeBuffer();
+    result.columns = parseRuns(buffer, runs);
+    return result;
+}
+
+std::string nestedExpression(int depth) {
+    static const char* operands[] = {"a", "count", "b.size", "limit", "x1", "total"};
+    if (depth == 0) return "value";
+    const char* a = operands[depth % 6];
+    const char* b = operands[(depth + 2) % 6];
+    const char* c = operands[(depth + 4) % 6];
+    std::string inner = nestedExpression(depth - 1);
+    switch (depth % 4) {
+        case 0: return "(" + std::string(a) + " + " + inner + " * " + b + " - " + c + " / 2)";
+        case 1: return "(" + std::string(a) + " >= " + inner + " && " + b + " != " + c + " || -" + a + " < 3)";
+        case 2: return "(f(" + std::string(a) + ", " + inner + ") % " + b + " == " + c + "[1] ** 2)";
+        default: return "(" + std::string(a) + " <= " + b + " || " + inner + " > " + c + " + 1)";
+    }
+}
+
+std::string syntheticSource(size_t targetBytes, int depth) {
+    std::string line = nestedExpression(depth);
+    std::string source;
+    source.reserve(targetBytes + line.size() + 32);
+    for (size_t i = 0; source.size() < targetBytes; ++i) {
+        source += "v";
+        source += std::to_string(i % 1000);
+        source += " = ";
+        source += line;
+        source += "\n";
+    }
+    return source;
+}
+
+std::string perToken(int64_t count, size_t tokens) {
+    if (count < 0 || tokens == 0) return "n/a";
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(3) << static_cast<double>(count) / tokens;
+    return text.str();
+}
+
+void report(const std::string& name, size_t bytes, const Result& result) {
+    double lexTokPerSec = result.lexSeconds > 0 ? result.tokens / result.lexSeconds : 0.0;
+    std::cout << std::left << std::setw(36) << name << std::right
+              << std::setw(12) << bytes << " B"
+              << std::setw(10) << result.tokens << " tok"
+              << std::setw(8) << std::fixed << std::setprecision(2) << lexTokPerSec / 1e6 << " Mtok/s lex\n";
+    auto line = [&](const char* layout, const Layout& parse) {
+        double parseTokPerSec = parse.seconds > 0 ? result.tokens / parse.seconds : 0.0;
+        std::cout << "    parse from " << std::left << std::setw(8) << layout << std::right << std::fixed
+                  << std::setprecision(2) << std::setw(8) << parseTokPerSec / 1e6 << " Mtok/s" << std::setw(10)
+                  << perToken(parse.cacheMisses, result.tokens) << " misses/tok" << std::setw(10)
+                  << perToken(parse.l1Misses, result.tokens) << " L1d misses/tok\n";
+    };
+    line("vector", result.vector);
+    line("columns", result.columns);
+}
+
+}
+
+int main(int argc, char** argv) {
+    size_t syntheticMb = 16;
+    int depth = 24;
+    int runs = 5;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--synthetic-mb" && i + 1 < argc) {
+            syntheticMb = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--depth" && i + 1 < argc) {
+            depth = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--runs" && i + 1 < argc) {
+            runs = std::max(1, std::atoi(argv[++i]));
+        } else {
+            files.push_back(arg);
+        }
+    }
+
+    for (const auto& path : files) {
+        auto source = SourceBuffer::fromFile(path);
+        if (!source) {
+            std::cerr << "[ERROR] Failed to open " << path << "\n";
+            return 1;
+        }
+        report(path, source->size(), measure(source, runs));
+    }
+
+    if (syntheticMb > 0) {
+        auto source = SourceBuffer::fromString(syntheticSource(syntheticMb * 1024 * 1024, depth));
+        report("nested expressions (" + std::to_string(syntheticMb) + " MB, depth " + std::to_string(depth) + ")",
+               source->size(), measure(source, runs));
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include "../../core/include/incremental_lexer.h"
+#include "../../core/include/lexer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Editor latency benchmark. For documents of growing length, types a short
+// statement one character at a time into the middle of the file and reports
+// the mean time per keystroke (edit plus reading the diagnostics) next to
+// the time a full re-lex takes.
+//
+//   relexbench [--lines N ...] [--keystrokes N]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::string document(size_t lines) {
+    static const char* block =
+        "component Widget {\n"
+        "    count: number = 0\n"
+        "    label = \"Total: \\\"items\\\"\\n\"\n"
+        "    /* multi-line\n"
+        "       comment block */\n"
+        "    increment {\n"
+        "        count = count + 1 * (step - 2) / 4\n"
+        "    }\n"
+        "    render:\n"
+        "        <div class=\"widget\" data-id={count}>\n"
+        "            <span>Count: {count}</span>\n"
+        "        </div>\n"
+        "}\n";
+    std::string text;
+    while (static_cast<size_t>(std::count(text.begin(), text.end(), '\n')) < lines) text += block;
+    return text;
+}
+
+double seconds(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::vector<size_t> sizes;
+    size_t keystrokes = 2000;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--lines" && i + 1 < argc) {
+            sizes.push_back(static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10)));
+        } else if (arg == "--keystrokes" && i + 1 < argc) {
+            keystrokes = std::max<size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+        }
+    }
+    if (sizes.empty()) sizes = {2000, 20000, 200000};
+
+    std::cout << std::setw(10) << "lines" << std::setw(12) << "bytes" << std::setw(16) << "full lex (us)"
+              << std::setw(18) << "keystroke (us)" << std::setw(16) << "tokens/edit\n";
+    for (size_t lines : sizes) {
+        std::string text = document(lines);
+
+        auto start = Clock::now();
+        Lexer full(text);
+        size_t tokenCount = full.tokenize().size();
+        double fullLex = seconds(start);
+
+        IncrementalLexer lexer(text);
+        static const std::string typed = "    total = count * 2\n";
+        size_t line = lines / 2;
+        size_t relexed = 0;
+        size_t diagnostics = 0;
+        start = Clock::now();
+        for (size_t i = 0; i < keystrokes; ++i) {
+            size_t offset = lexer.lineOffset(line) + (i % typed.size());
+            IncrementalLexer::EditStats stats = lexer.edit(offset, 0, typed.substr(i % typed.size(), 1));
+            relexed += stats.relexed;
+            diagnostics += lexer.errors().size();
+            if (i % typed.size() == typed.size() - 1) ++line;
+        }
+        double perKeystroke = seconds(start) / static_cast<double>(keystrokes);
+
+        std::cout << std::setw(10) << lines << std::setw(12) << text.size() << std::setw(16) << std::fixed
+                  << std::setprecision(0) << fullLex * 1e6 << std::setw(18) << std::setprecision(2)
+                  << perKeystroke * 1e6 << std::setw(15) << std::setprecision(1)
+                  << static_cast<double>(relexed) / static_cast<double>(keystrokes) << "\n";
+        if (tokenCount == 0 || diagnostics == SIZE_MAX) return 1;
+    }
+    return 0;
+}
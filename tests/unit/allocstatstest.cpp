@@ -0,0 +1,186 @@
+#include "../../core/include/alloc_stats.h"
+#include "../../core/include/ast.h"
+#include "../../core/include/lexer.h"
+#include "../../core/include/parser.h"
+#include "../../core/include/source_buffer.h"
+#include "../bench/corpus.h"
+#include "check.h"
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The counters themselves (nesting, per-thread isolation, merging), then a
+// heap budget for each front-end phase on every generated corpus shape.
+// The budgets hold today's numbers with headroom; a change that allocates
+// per token where it did not before fails here instead of going unnoticed
+// until someone runs the benchmark.
+
+namespace {
+
+void testCounters() {
+    check(allocstats::available(), "allocation hook is installed");
+
+    AllocationScope outer;
+    auto* big = new std::vector<char>(1 << 20);
+    AllocationCounts afterBig = outer.counts();
+    delete big;
+    AllocationCounts innerCounts;
+    {
+        AllocationScope inner;
+        std::vector<char> small(1000);
+        innerCounts = inner.counts();
+    }
+    // Read before check(), whose message string allocates too.
+    AllocationCounts total = outer.counts();
+    check(innerCounts.allocations == 1 && innerCounts.bytes == 1000 && innerCounts.peakLiveBytes == 1000,
+          "inner scope counts only its own allocation");
+    check(afterBig.allocations == 2 && total.allocations == 3, "outer scope includes the inner one");
+    check(total.peakLiveBytes >= (1u << 20), "inner scope does not hide the outer peak");
+
+    // Another thread's allocations do not show up here.
+    AllocationScope local;
+    AllocationCounts remote;
+    std::thread worker([&remote] {
+        AllocationScope scope;
+        std::vector<int> v(4096);
+        remote = scope.counts();
+    });
+    worker.join();
+    // std::thread allocates its own small state on this thread.
+    AllocationCounts here = local.counts();
+    check(remote.bytes == 4096 * sizeof(int), "worker thread counts its own allocations");
+    check(here.bytes < 4096, "worker's allocations stay out of this thread's scope");
+
+    AllocationStats stats;
+    stats.add("lex", {3, 300, 100});
+    stats.add("parse", {5, 500, 400});
+    stats.add("lex", {1, 10, 200});
+    stats.addInputBytes(1024);
+    std::vector<AllocationStats::Phase> phases = stats.phases();
+    check(phases.size() == 2 && phases[0].name == "lex" && phases[1].name == "parse",
+          "phases are kept in first-seen order");
+    check(phases[0].counts.allocations == 4 && phases[0].counts.bytes == 310 && phases[0].counts.peakLiveBytes == 200 &&
+              phases[0].samples == 2,
+          "repeated phases sum counts and keep the larger peak");
+    std::ostringstream table;
+    stats.print(table);
+    check(table.str().find("lex") != std::string::npos && table.str().find("4.00") != std::string::npos,
+          "table reports allocations per KB of input");
+}
+
+// One node per token; braces, parentheses and tags open and close levels,
+// which is enough shape for the serializer's budget.
+ASTNode* tokenTree(ASTArena& arena, const std::vector<Token>& tokens, const LineTable& lines) {
+    ASTNode* root = arena.create(ASTNodeType::Program, "Program", 0, 0);
+    std::vector<ASTNode*> open{root};
+    for (const Token& token : tokens) {
+        std::string text(token.value);
+        if ((text == "}" || text == ")") && open.size() > 1) {
+            open.pop_back();
+            continue;
+        }
+        SourceLocation at = lines.locate(token.offset);
+        ASTNode* node = arena.create(ASTNodeType::Expression, Token::tokenTypeToString(token.type), at.line, at.column);
+        arena.setValue(node, token.value);
+        ASTArena::addChild(open.back(), node);
+        if (text == "{" || text == "(") open.push_back(node);
+    }
+    return root;
+}
+
+struct Budget {
+    double lexAllocationsPerToken;
+    double parseAllocationsPerToken;
+    double lexPeakPerToken;     // bytes of live heap
+    double parsePeakPerToken;
+};
+
+double logBytes(size_t bytes) {
+    return std::log2(static_cast<double>(bytes) + 2);
+}
+
+void checkShape(corpus::Shape shape, const Budget& budget) {
+    std::string name = corpus::name(shape);
+    auto source = SourceBuffer::fromString(corpus::generate(shape, 2 << 20));
+    size_t bytes = source->size();
+
+    std::vector<Token> tokens;
+    AllocationCounts lex;
+    {
+        AllocationScope scope;
+        Lexer lexer(source);
+        tokens = lexer.tokenize();
+        lex = scope.counts();
+    }
+
+    AllocationCounts parse;
+    size_t parseErrors;
+    {
+        std::vector<Token> copy = tokens;
+        AllocationScope scope;
+        Parser parser(std::move(copy));
+        std::unique_ptr<Program> program = parser.parse();
+        parseErrors = parser.errors().size();
+        parse = scope.counts();
+    }
+
+    ASTArena arena;
+    ASTNode* tree = tokenTree(arena, tokens, source->lines());
+    AllocationCounts serialize;
+    size_t jsonBytes;
+    {
+        AllocationScope scope;
+        std::string json = astToJson(tree, JsonWriter::Style::Compact);
+        jsonBytes = json.size();
+        serialize = scope.counts();
+    }
+
+    double perToken = 1.0 / std::max<size_t>(tokens.size(), 1);
+    std::cout << "[STATS] " << name << ": " << bytes << " bytes, " << tokens.size() << " tokens, " << parseErrors
+              << " parse errors\n"
+              << std::fixed << std::setprecision(3)
+              << "[STATS]   lex " << lex.allocations << " allocations (" << lex.allocations * perToken
+              << "/token), peak " << lex.peakLiveBytes << " bytes\n"
+              << "[STATS]   parse " << parse.allocations << " allocations (" << parse.allocations * perToken
+              << "/token), peak " << parse.peakLiveBytes << " bytes\n"
+              << "[STATS]   serialize " << serialize.allocations << " allocations, peak " << serialize.peakLiveBytes
+              << " bytes for " << jsonBytes << " bytes of JSON\n";
+
+    check(lex.allocations * perToken <= budget.lexAllocationsPerToken, name + ": lex allocations per token in budget");
+    check(parse.allocations * perToken <= budget.parseAllocationsPerToken,
+          name + ": parse allocations per token in budget");
+    check(lex.peakLiveBytes <= budget.lexPeakPerToken * tokens.size() + 65536, name + ": lex peak heap in budget");
+    check(parse.peakLiveBytes <= budget.parsePeakPerToken * tokens.size() + 65536,
+          name + ": parse peak heap in budget");
+    // The output string doubles as it grows and the writer's stack is tiny,
+    // so serializing allocates O(log n) times and at most ~3x its output.
+    check(serialize.allocations <= 4 * logBytes(jsonBytes) + 16, name + ": serialize allocations are O(log n)");
+    check(serialize.peakLiveBytes <= 3 * jsonBytes + 4096, name + ": serialize peak heap in budget");
+}
+
+}
+
+int main() {
+    testCounters();
+
+    // The token vector grows by doubling, so lexing peaks at up to three
+    // Tokens' worth per token while the old buffer is copied out, plus a
+    // little for errors and lexer state.
+    const double tokenVector = 3.5 * sizeof(Token);
+    // Tag trees are a node (and a children vector) per tag and text run, so
+    // the ALTX shapes allocate about one block per token. Items with errors
+    // are kept (up to the error) in the program, so the comment shape, whose
+    // comments reach the parser as tokens, holds more.
+    checkShape(corpus::Shape::ALTX, {0.01, 1.2, tokenVector, 32});
+    checkShape(corpus::Shape::Expressions, {0.01, 1.5, tokenVector, 64});
+    checkShape(corpus::Shape::Comments, {0.01, 1.0, tokenVector, 64});
+    checkShape(corpus::Shape::UTF8, {0.01, 0.6, tokenVector, 32});
+    checkShape(corpus::Shape::Mixed, {0.01, 1.2, tokenVector, 48});
+    checkShape(corpus::Shape::Broken, {0.01, 1.5, tokenVector, 64});
+
+    return checkSummary("allocation");
+}
@@ -0,0 +1,136 @@
+#include "../../core/include/ast.h"
+#include "../../core/include/ast_binary.h"
+#include "check.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+
+// The binary view must show exactly the tree that was written (types,
+// positions, names, set/unset values and errors, child order), at any depth,
+// and reject damaged input instead of reading out of bounds.
+
+namespace {
+
+bool same(const ASTNode& node, ASTBinaryView::Node view) {
+    // Walk both trees with an explicit stack; the deep test would overflow
+    // a recursive comparison.
+    std::vector<std::pair<const ASTNode*, ASTBinaryView::Node>> pending{{&node, view}};
+    while (!pending.empty()) {
+        auto [a, b] = pending.back();
+        pending.pop_back();
+        if (a->type != b.type() || a->line != b.line() || a->column != b.column() || a->name != b.name() ||
+            a->hasValue() != b.hasValue() || a->value != b.value() || a->hasError() != b.hasError() ||
+            a->error != b.error() || a->childCount != b.childCount()) {
+            return false;
+        }
+        uint32_t i = 0;
+        for (const ASTNode& child : a->children()) pending.push_back({&child, b.child(i++)});
+    }
+    return true;
+}
+
+ASTNode* randomTree(ASTArena& arena, std::mt19937& random, size_t nodes) {
+    static const char* names[] = {"", "div", "span", "count", "Program", "x\n\"quoted\"\\", "\xC3\xA9t\xC3\xA9"};
+    std::vector<ASTNode*> all{arena.create(ASTNodeType::Program, "Program", 1, 1)};
+    // Set but empty must stay distinct from unset.
+    ASTNode* empty = arena.create(ASTNodeType::Literal, "", 1, 1);
+    arena.setValue(empty, "");
+    ASTArena::addChild(all.front(), empty);
+    all.push_back(empty);
+    while (all.size() < nodes) {
+        ASTNode* parent = all[random() % all.size()];
+        auto type = static_cast<ASTNodeType>(random() % (static_cast<int>(ASTNodeType::Error) + 1));
+        ASTNode* node = arena.create(type, names[random() % 7], random() % 5000, random() % 120);
+        if (random() % 3 == 0) arena.setValue(node, names[random() % 7]);
+        if (random() % 11 == 0) arena.setError(node, "unexpected token");
+        ASTArena::addChild(parent, node);
+        all.push_back(node);
+    }
+    return all.front();
+}
+
+}
+
+int main() {
+    {
+        ASTArena arena;
+        ASTNode* root = arena.create(ASTNodeType::Program, "Program");
+        std::string bytes;
+        writeASTBinary(*root, bytes);
+        auto view = ASTBinaryView::open(bytes);
+        check(view && view->nodeCount() == 1 && view->version() == ASTBinaryVersion && same(*root, view->root()),
+              "single node round trip");
+    }
+    {
+        ASTArena arena;
+        std::mt19937 random(42);
+        ASTNode* root = randomTree(arena, random, 20000);
+        std::string bytes;
+        writeASTBinary(*root, bytes);
+        auto view = ASTBinaryView::open(bytes);
+        check(view && view->nodeCount() == 20000 && same(*root, view->root()), "random tree round trip");
+
+        bool rejected = true;
+        for (size_t size = 0; size < 4096 && size < bytes.size(); ++size) {
+            rejected &= !ASTBinaryView::open(std::string_view(bytes).substr(0, size));
+        }
+        rejected &= !ASTBinaryView::open(std::string_view(bytes).substr(0, bytes.size() - 1));
+        check(rejected, "truncated input is rejected");
+
+        // Random byte damage: whatever open() accepts must be safe to walk
+        // (run under ASan to make this meaningful).
+        size_t accepted = 0;
+        for (int round = 0; round < 300; ++round) {
+            std::string damaged = bytes;
+            for (int i = 0; i < 4; ++i) damaged[random() % damaged.size()] = static_cast<char>(random());
+            std::string error;
+            auto damagedView = ASTBinaryView::open(damaged, &error);
+            if (!damagedView) continue;
+            ++accepted;
+            size_t visited = 0;
+            std::vector<ASTBinaryView::Node> pending{damagedView->root()};
+            while (!pending.empty() && visited < 100000) {
+                ASTBinaryView::Node node = pending.back();
+                pending.pop_back();
+                visited += node.name().size() + node.value().size() + node.error().size() + 1;
+                for (ASTBinaryView::Node child : node.children()) pending.push_back(child);
+            }
+        }
+        check(accepted < 300, "damaged headers and references are rejected (" + std::to_string(300 - accepted) +
+                                  " of 300)");
+
+        std::string wrongVersion = bytes;
+        wrongVersion[4] = static_cast<char>(ASTBinaryVersion + 1);
+        std::string error;
+        check(!ASTBinaryView::open(wrongVersion, &error) && error.find("version") != std::string::npos,
+              "newer versions are refused with a message");
+
+        auto start = std::chrono::steady_clock::now();
+        std::string json = astToJson(root);
+        double jsonMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        start = std::chrono::steady_clock::now();
+        std::string binary;
+        writeASTBinary(*root, binary);
+        double binaryMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "  20000 nodes: JSON " << json.size() << " bytes in " << jsonMs << " ms, binary "
+                  << binary.size() << " bytes in " << binaryMs << " ms\n";
+    }
+    {
+        // A chain far deeper than any recursive writer or reader survives.
+        ASTArena arena;
+        ASTNode* root = arena.create(ASTNodeType::Program, "Program");
+        ASTNode* parent = root;
+        for (int i = 0; i < 200000; ++i) {
+            ASTNode* node = arena.create(ASTNodeType::Tag, "div", i, 1);
+            ASTArena::addChild(parent, node);
+            parent = node;
+        }
+        std::string bytes;
+        writeASTBinary(*root, bytes);
+        auto view = ASTBinaryView::open(bytes);
+        check(view && same(*root, view->root()), "200000-deep chain round trip");
+    }
+
+    return checkSummary("binary AST");
+}
@@ -1,5 +1,8 @@
+#include "../../core/include/alloc_stats.h"
 #include "../../core/include/ast.h"
+#include "../../core/include/ast_binary.h"
 #include "../../core/include/lexer.h"
+#include "../../core/include/source_buffer.h"
 #include <fstream>
 #include <iostream>
 #include <memory>
@@ -8,16 +11,17 @@
 #include <filesystem>
 
 // Dummy parser for demonstration (replace with real parser)
-std::shared_ptr<ASTNode> parseTokens(const std::vector<Token>& tokens) {
+ASTNode* parseTokens(ASTArena& arena, const std::vector<Token>& tokens, const LineTable& lines) {
     std::cerr << "[DEBUG] parseTokens called with " << tokens.size() << " tokens\n";
-    auto root = std::make_shared<ASTNode>(ASTNodeType::Program, "Program");
+    ASTNode* root = arena.create(ASTNodeType::Program, "Program");
     std::cerr << "[DEBUG] Created root AST node\n";
     
     for (const auto& token : tokens) {
-        auto node = std::make_shared<ASTNode>(ASTNodeType::Literal, token.value, token.line, token.column);
-        root->children.push_back(node);
+        SourceLocation at = lines.locate(token.offset);
+        ASTNode* node = arena.create(ASTNodeType::Literal, token.value, at.line, at.column);
+        ASTArena::addChild(root, node);
     }
-    std::cerr << "[DEBUG] Added " << root->children.size() << " children to root\n";
+    std::cerr << "[DEBUG] Added " << root->childCount << " children to root\n";
     return root;
 }
 
@@ -28,8 +32,8 @@ int main(int argc, char** argv) {
     std::string inputFile = argc > 1 ? argv[1] : "examples/lexer-app-test.alt";
     std::cerr << "[DEBUG] Input file: " << inputFile << std::endl;
     
-    std::ifstream file(inputFile);
-    if (!file) {
+    auto buffer = SourceBuffer::fromFile(inputFile);
+    if (!buffer) {
         std::cerr << "[ERROR] Failed to open " << inputFile << std::endl;
         std::cerr << "[DEBUG] Current working directory check..." << std::endl;
         try {
@@ -39,10 +43,9 @@ int main(int argc, char** argv) {
         }
         return 1;
     }
-    std::cerr << "[DEBUG] File opened successfully\n";
+    std::cerr << "[DEBUG] File opened successfully" << (buffer->isMapped() ? " (mapped)" : "") << "\n";
     
-    std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-    file.close();
+    std::string_view source = buffer->text();
     std::cerr << "[DEBUG] Input size: " << source.size() << " bytes\n";
 
     if (source.empty()) {
@@ -51,11 +54,20 @@ int main(int argc, char** argv) {
         std::cerr << "[DEBUG] First 50 chars: " << source.substr(0, 50) << "...\n";
     }
 
+    // Heap use per phase, printed at the end.
+    AllocationStats allocations;
+    allocations.addInputBytes(source.size());
+
     std::cerr << "[DEBUG] Creating lexer...\n";
     try {
-        Lexer lexer(source);
-        std::cerr << "[DEBUG] Lexer created, tokenizing...\n";
-        std::vector<Token> tokens = lexer.tokenize();
+        std::vector<Token> tokens;
+        {
+            AllocationScope scope;
+            Lexer lexer(buffer);
+            std::cerr << "[DEBUG] Lexer created, tokenizing...\n";
+            tokens = lexer.tokenize();
+            allocations.add("lex", scope.counts());
+        }
         std::cerr << "[DEBUG] Token count: " << tokens.size() << "\n";
 
         if (tokens.empty()) {
@@ -66,24 +78,29 @@ int main(int argc, char** argv) {
 
         // Parse tokens into AST
         std::cerr << "[DEBUG] Parsing tokens to AST...\n";
-        auto ast = parseTokens(tokens);
+        ASTArena arena;
+        AllocationScope parseScope;
+        ASTNode* ast = parseTokens(arena, tokens, buffer->lines());
+        allocations.add("parse", parseScope.counts());
         
         if (!ast) {
             std::cerr << "[ERROR] AST parsing returned null!\n";
             return 3;
         }
         
-    std::cerr << "[DEBUG] AST root type: " << (int)ast->type << " (" << ast->value.value_or("") << ")\n";
-        std::cerr << "[DEBUG] AST children count: " << ast->children.size() << "\n";
+    std::cerr << "[DEBUG] AST root type: " << (int)ast->type << " (" << ast->value << ")\n";
+        std::cerr << "[DEBUG] AST children count: " << ast->childCount
+                  << " (" << arena.bytesUsed() << " arena bytes)\n";
         
         // Show first few AST nodes for verification
         std::cerr << "[DEBUG] First 3 AST nodes:\n";
-        for (size_t i = 0; i < std::min((size_t)3, ast->children.size()); i++) {
-            auto& child = ast->children[i];
-            std::cerr << "  [" << i << "] Type: " << (int)child->type 
-                      << ", Value: \"" << child->value.value_or("") 
-                      << "\", Line: " << child->line 
-                      << ", Column: " << child->column << "\n";
+        size_t i = 0;
+        for (const ASTNode& child : ast->children()) {
+            if (i == 3) break;
+            std::cerr << "  [" << i++ << "] Type: " << (int)child.type 
+                      << ", Value: \"" << child.value 
+                      << "\", Line: " << child.line 
+                      << ", Column: " << child.column << "\n";
         }
 
         // Ensure output directory exists
@@ -108,7 +125,9 @@ int main(int argc, char** argv) {
         
         std::cerr << "[DEBUG] Calling astToJson...\n";
         try {
+            AllocationScope serializeScope;
             std::string jsonOutput = astToJson(ast);
+            allocations.add("serialize", serializeScope.counts());
             std::cerr << "[DEBUG] Generated JSON length: " << jsonOutput.length() << " characters\n";
             
             if (jsonOutput.empty()) {
@@ -132,6 +151,20 @@ int main(int argc, char** argv) {
             return 6;
         }
         
+        // Same tree in the binary form, for readers that would rather not
+        // parse JSON; it must read back as the tree that was written.
+        const char* binaryPath = "results-dashboard/public/results/ast-results.bin";
+        std::string binaryOutput;
+        writeASTBinary(*ast, binaryOutput);
+        std::string binaryError;
+        auto view = ASTBinaryView::open(binaryOutput, &binaryError);
+        if (!view || view->nodeCount() != ast->childCount + 1 || view->root().childCount() != ast->childCount) {
+            std::cerr << "[ERROR] Binary AST did not read back: " << binaryError << "\n";
+            return 9;
+        }
+        std::ofstream(binaryPath, std::ios::binary) << binaryOutput;
+        std::cerr << "[DEBUG] Binary AST written to " << binaryPath << " (" << binaryOutput.size() << " bytes)\n";
+
         std::cerr << "[SUCCESS] AST test complete. Output written to " << outPath << "\n";
         
         // Verify file was written correctly
@@ -153,6 +186,7 @@ int main(int argc, char** argv) {
         return 8;
     }
     
+    allocations.print(std::cerr);
     std::cerr << "[DEBUG] Program completed successfully\n";
     return 0;
 }
\ No newline at end of file
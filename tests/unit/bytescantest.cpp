@@ -0,0 +1,78 @@
+#include "../../core/include/byte_scan.h"
+#include "check.h"
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Checks every vector implementation the CPU supports against the scalar
+// one, over random inputs at every alignment and length up to a few strides.
+
+namespace {
+
+std::vector<size_t> run(const std::string& data) {
+    std::vector<size_t> r;
+    std::vector<uint32_t> lineStarts;
+    for (size_t offset = 0; offset < 64 && offset <= data.size(); ++offset) {
+        for (size_t length = 0; offset + length <= data.size() && length < 160; ++length) {
+            const char* p = data.data() + offset;
+            r.push_back(bytescan::skipBlanks(p, length));
+            r.push_back(bytescan::findAny(p, length, '"', '\\', '\r', '\r'));
+            r.push_back(bytescan::findAny(p, length, '*', '*', '*', '*'));
+            r.push_back(bytescan::skipText(p, length));
+            r.push_back(bytescan::findJsonEscape(p, length));
+            // Appends to what is there, counting from `base`.
+            lineStarts.assign(1, 7);
+            bytescan::appendLineStarts(p, length, static_cast<uint32_t>(offset * 1000), lineStarts);
+            r.insert(r.end(), lineStarts.begin(), lineStarts.end());
+        }
+    }
+    return r;
+}
+
+// Inputs drawn mostly from the bytes the scanners care about so that stops
+// land at every position within a stride.
+std::string randomInput(std::mt19937& rng, size_t size) {
+    static const char alphabet[] = " \t\r\n\v\f\"\\*`/<{a0\x7f\x01\xc3\xa9";
+    std::uniform_int_distribution<int> pick(0, sizeof(alphabet) - 2);
+    std::uniform_int_distribution<int> blankRun(0, 3);
+    std::string s;
+    while (s.size() < size) {
+        // Long runs of a single harmless byte exercise the vector loop itself.
+        if (blankRun(rng) == 0) s.append(40, ' ');
+        s += alphabet[pick(rng)];
+    }
+    s.resize(size);
+    return s;
+}
+
+}
+
+int main() {
+    std::mt19937 rng(12345);
+    std::vector<std::string> inputs;
+    for (int i = 0; i < 8; ++i) inputs.push_back(randomInput(rng, 256));
+    std::string allBytes;
+    for (int b = 0; b < 256; ++b) allBytes += static_cast<char>(b);
+    inputs.push_back(allBytes);
+
+    bytescan::select(bytescan::Implementation::Scalar);
+    std::vector<std::vector<size_t>> expected;
+    for (const auto& input : inputs) expected.push_back(run(input));
+
+    for (auto impl : {bytescan::Implementation::SSE2, bytescan::Implementation::AVX2}) {
+        if (!bytescan::select(impl)) {
+            std::cout << "[SKIP] " << bytescan::name(impl) << " not supported\n";
+            continue;
+        }
+        bool ok = true;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            if (run(inputs[i]) != expected[i]) {
+                std::cout << "[FAIL] " << bytescan::name(impl) << " differs from scalar on input " << i << "\n";
+                ok = false;
+            }
+        }
+        check(ok, bytescan::name(impl));
+    }
+    return checkSummary("byte scan");
+}
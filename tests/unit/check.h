@@ -0,0 +1,23 @@
+#pragma once
+#include <iostream>
+#include <string>
+
+// The [PASS]/[FAIL] reporting shared by the unit tests. Every test is its
+// own executable, so each keeps its own failure count.
+
+inline int failures = 0;
+
+inline void check(bool ok, const std::string& what) {
+    std::cout << (ok ? "[PASS] " : "[FAIL] ") << what << "\n";
+    if (!ok) ++failures;
+}
+
+// Prints the summary line and returns main()'s exit status.
+inline int checkSummary(const std::string& suite) {
+    if (failures > 0) {
+        std::cout << failures << " check(s) failed\n";
+        return 1;
+    }
+    std::cout << "All " << suite << " checks passed\n";
+    return 0;
+}
@@ -0,0 +1,271 @@
+#include "../../core/include/alterion_compiler.h"
+#include "../../core/include/ast_serialization.h"
+#include "../../core/include/compile_cache.h"
+#include "../../core/include/content_hash.h"
+#include "../../core/include/lexer.h"
+#include "../../core/include/parser.h"
+#include "check.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Checks the hash against the reference XXH64 values, that every AST node
+// kind survives writeProgram/readProgram, and that the driver returns the
+// same results from the cache as from lexing and parsing: counters, size
+// limit and damaged entries included.
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char* sample =
+    "import { Button, Card } from \"ui\"\n"
+    "component Counter {\n"
+    "    count = 0\n"
+    "    label = \"Total\"\n"
+    "    increment {\n"
+    "        count = count + 1\n"
+    "    }\n"
+    "}\n"
+    "export function total(items, factor) {\n"
+    "    let sum = 0\n"
+    "    const limit = -factor * 2.5\n"
+    "    for (let i = 0; i < 10; i + 1) {\n"
+    "        if (!items[i].done && i != 3) {\n"
+    "            sum = sum + items[i].value\n"
+    "        } else {\n"
+    "            continue\n"
+    "        }\n"
+    "    }\n"
+    "    for item in items {\n"
+    "        sum = sum + item\n"
+    "    }\n"
+    "    while (sum > limit) {\n"
+    "        sum = sum - 1\n"
+    "        break\n"
+    "    }\n"
+    "    log({ name: \"x\", values: [1, 2, null, true] })\n"
+    "    return sum\n"
+    "}\n";
+
+// The parser does not reach every node kind yet (try/catch, tags), so the
+// round trip also runs over a tree built by hand. Offsets are arbitrary; the
+// return statement has none.
+std::unique_ptr<Program> everyKind() {
+    auto program = std::make_unique<Program>();
+    auto tag = std::make_unique<Tag>(intern("div"), 703);
+    tag->isSelfClosing = false;
+    tag->styles.emplace_back("color", "red");
+    tag->attributes.push_back(std::make_unique<Attribute>(intern("value"),
+                                                          std::make_unique<ValueBinding>(intern("name"), 714), 708));
+    tag->children.push_back(std::make_unique<TextContent>("hello \xC3\xA9", 805));
+    tag->children.push_back(nullptr);
+    auto component = std::make_unique<Component>(intern("View"), ComponentType::MIXED, 101);
+    component->body.push_back(std::move(tag));
+
+    auto tryStatement = std::make_unique<TryStatement>(
+        std::make_unique<BlockStatement>(std::vector<StatementPtr>(), 309), 305);
+    tryStatement->catchVariable = intern("error");
+    tryStatement->catchBlock = std::make_unique<ThrowStatement>(std::make_unique<Identifier>(intern("error"), 411), 405);
+    tryStatement->finallyBlock = std::make_unique<BreakStatement>(505);
+    component->statements.push_back(std::move(tryStatement));
+    component->statements.push_back(std::make_unique<Assignment>(
+        intern("count"), std::make_unique<NumberLiteral>("1e3", true, 614), TokenType::PlusAssign, 605));
+    program->components.push_back(std::move(component));
+
+    std::vector<StatementPtr> body;
+    body.push_back(std::make_unique<ExpressionStatement>(
+        std::make_unique<UnaryExpression>(TokenType::LogicalNot, std::make_unique<BooleanLiteral>(false, 1006), 1005),
+        1005));
+    body.push_back(std::make_unique<ContinueStatement>(1105));
+    body.push_back(std::make_unique<ReturnStatement>(nullptr));
+    program->functions.push_back(std::make_unique<Function>(intern("run"), std::vector<Symbol>{intern("a"), intern("b")},
+                                                            std::make_unique<BlockStatement>(std::move(body), 920),
+                                                            FunctionType::ASYNC, 901));
+
+    program->globalStatements.push_back(
+        std::make_unique<Import>(std::vector<Symbol>{intern("View")}, "./view", true, 2001));
+    program->globalStatements.push_back(std::make_unique<VariableDeclaration>(
+        intern("empty"), std::make_unique<StringLiteral>("", 2113), Keyword::Const, 2101));
+    program->globalStatements.push_back(std::make_unique<VariableDeclaration>(intern("nothing"), nullptr, Keyword::Let, 2201));
+    return program;
+}
+
+std::string encode(const Program& program) {
+    std::string bytes;
+    writeProgram(program, bytes);
+    return bytes;
+}
+
+// Node kinds, positions and names in tree order.
+void dump(const Node& node, std::string& out) {
+    out += std::to_string(static_cast<int>(node.nodeType)) + "@" + std::to_string(node.offset);
+    if (auto* n = dynamic_cast<const Identifier*>(&node)) out += " " + std::string(symbolText(n->name));
+    if (auto* n = dynamic_cast<const StringLiteral*>(&node)) out += " \"" + n->value + "\"";
+    if (auto* n = dynamic_cast<const Tag*>(&node)) out += " <" + std::string(symbolText(n->tagName)) + ">";
+    out += "(";
+    forEachChild(node, [&out](const Node& child) { dump(child, out); });
+    out += ")";
+}
+
+std::string dump(const Program& program) {
+    std::string out;
+    dump(program, out);
+    return out;
+}
+
+std::string render(const std::vector<FileResult>& results) {
+    std::ostringstream out;
+    printDiagnostics(results, out);
+    for (const auto& result : results) {
+        out << result.path << " " << result.bytes << " " << (result.program ? dump(*result.program) : "-") << "\n";
+    }
+    return out.str();
+}
+
+size_t countEntries(const fs::path& directory) {
+    size_t count = 0;
+    for (const auto& entry : fs::directory_iterator(directory)) count += entry.path().extension() == ".altc";
+    return count;
+}
+
+}
+
+int main() {
+    check(xxhash64("", 0) == 0xEF46DB3751D8E999ULL && xxhash64("a") == 0xD24EC4F1A98C6E5BULL &&
+              xxhash64("abc") == 0x44BC2CF5AD770999ULL &&
+              xxhash64("Nobody inspects the spammish repetition") == 0xFBCEA83C8A378BF1ULL,
+          "xxhash64 matches the reference values");
+    check(contentHash("abc", "v1") != contentHash("abc", "v2") && contentHash("abc", "v1") == contentHash("abc", "v1"),
+          "content hash depends on the salt");
+
+    {
+        Lexer lexer(sample);
+        Parser parser(lexer);
+        std::unique_ptr<Program> parsed = parser.parse();
+        std::string bytes = encode(*parsed);
+        std::unique_ptr<Program> copy = readProgram(bytes);
+        check(parser.errors().empty() && copy != nullptr && dump(*copy) == dump(*parsed) && encode(*copy) == bytes,
+              "parsed program survives a round trip");
+
+        std::unique_ptr<Program> built = everyKind();
+        bytes = encode(*built);
+        copy = readProgram(bytes);
+        check(copy != nullptr && dump(*copy) == dump(*built) && encode(*copy) == bytes,
+              "every node kind survives a round trip");
+
+        bool rejected = true;
+        for (size_t size = 0; size < bytes.size(); ++size) rejected &= readProgram(bytes.substr(0, size)) == nullptr;
+        check(rejected, "truncated encodings are rejected");
+    }
+
+    fs::path root = fs::temp_directory_path() / "alterion-compilecachetest";
+    fs::remove_all(root);
+    fs::create_directories(root / "src");
+    std::vector<std::string> files;
+    for (int i = 0; i < 12; ++i) {
+        std::string path = (root / "src" / ("file" + std::to_string(i) + ".alt")).string();
+        std::ofstream(path) << sample << "function extra" << i << "(a) {\n    return a + " << i << "\n}\n"
+                            << (i % 3 == 0 ? "let broken = )\n" : "");
+        files.push_back(path);
+    }
+    files.push_back((root / "src" / "missing.alt").string());
+    std::vector<std::string> examples = collectSourceFiles({"examples"});
+    files.insert(files.end(), examples.begin(), examples.end());
+
+    std::string uncached = render(compileFiles(files, CompileOptions{4}));
+    {
+        CompileCache cache((root / "cache").string());
+        std::string cold = render(compileFiles(files, CompileOptions{4, &cache}));
+        CacheCounters counters = cache.counters();
+        check(cold == uncached, "cold cache run matches an uncached run");
+        check(counters.hits == 0 && counters.misses == files.size() - 1 && counters.stores == files.size() - 1,
+              "cold run misses and stores every readable file");
+
+        std::vector<FileResult> warmResults = compileFiles(files, CompileOptions{4, &cache});
+        bool allCached = true;
+        for (const FileResult& result : warmResults) allCached &= result.cached || result.program == nullptr;
+        counters = cache.counters();
+        check(render(warmResults) == uncached, "warm cache run matches an uncached run");
+        check(allCached && counters.hits == files.size() - 1, "warm run is served from the cache");
+
+        ContentHash key = CompileCache::keyFor(sample);
+        cache.store(key, nullptr, {});
+        std::unique_ptr<CacheEntry> entry = cache.find(key);
+        check(entry && entry->program() == nullptr, "entry without a program");
+    }
+    {
+        // Damage every entry: each must be detected, dropped and rebuilt.
+        for (const auto& entry : fs::directory_iterator(root / "cache")) {
+            std::fstream file(entry.path(), std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(static_cast<std::streamoff>(fs::file_size(entry.path()) / 2));
+            file.put('\x7F');
+        }
+        CompileCache cache((root / "cache").string());
+        std::string repaired = render(compileFiles(files, CompileOptions{4, &cache}));
+        CacheCounters counters = cache.counters();
+        check(repaired == uncached && counters.hits == 0 && counters.stores == files.size() - 1,
+              "damaged entries are treated as misses and rewritten");
+    }
+    {
+        uint64_t total = 0;
+        for (const auto& entry : fs::directory_iterator(root / "cache")) total += entry.file_size();
+        CompileCache cache((root / "cache").string(), total / 2);
+        size_t before = countEntries(root / "cache");
+        size_t removed = cache.trim();
+        uint64_t after = 0;
+        for (const auto& entry : fs::directory_iterator(root / "cache")) after += entry.file_size();
+        check(removed > 0 && countEntries(root / "cache") == before - removed && after <= total / 2 &&
+                  cache.counters().evictions == removed,
+              "trim() evicts down to the size limit");
+    }
+    {
+        // A result cut short by --max-errors must not be served to a run
+        // without the limit, nor the other way round.
+        std::vector<std::string> broken{(root / "src" / "broken.alt").string()};
+        std::ofstream(broken[0]) << "let a = )\nlet b = )\nlet c = )\n";
+        CompileOptions limited{1};
+        limited.errorLimit = 1;
+        CompileOptions unlimited{1};
+        std::string expectLimited = render(compileFiles(broken, limited));
+        std::string expectFull = render(compileFiles(broken, unlimited));
+
+        CompileCache cache((root / "limits").string());
+        limited.cache = unlimited.cache = &cache;
+        std::string first = render(compileFiles(broken, limited));
+        std::string second = render(compileFiles(broken, unlimited));
+        std::string third = render(compileFiles(broken, limited));
+        check(expectLimited != expectFull && first == expectLimited && second == expectFull && third == expectLimited &&
+                  cache.counters().hits == 1,
+              "the error limit is part of the cache key");
+    }
+    {
+        std::vector<std::string> deep{(root / "src" / "deep.alt").string()};
+        std::ofstream(deep[0]) << "x = " << std::string(20, '(') << "1" << std::string(20, ')') << "\n";
+        CompileOptions shallow{1};
+        shallow.nestingLimit = 10;
+        CompileOptions standard{1};
+        std::string expectShallow = render(compileFiles(deep, shallow));
+        std::string expectStandard = render(compileFiles(deep, standard));
+
+        CompileCache cache((root / "nesting").string());
+        shallow.cache = standard.cache = &cache;
+        std::string first = render(compileFiles(deep, shallow));
+        std::string second = render(compileFiles(deep, standard));
+        check(expectShallow != expectStandard && first == expectShallow && second == expectStandard &&
+                  cache.counters().hits == 0,
+              "the nesting limit is part of the cache key");
+    }
+    {
+        CompileCache cache((root / "src" / "file0.alt" / "cache").string());
+        std::string disabled = render(compileFiles(files, CompileOptions{4, &cache}));
+        check(!cache.enabled() && disabled == uncached && cache.counters().stores == 0,
+              "unusable cache directory is ignored");
+    }
+    fs::remove_all(root);
+
+    return checkSummary("compile cache");
+}
@@ -0,0 +1,76 @@
+#include "../../core/include/alterion_compiler.h"
+#include "../../core/include/work_stealing_pool.h"
+#include "check.h"
+#include <atomic>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Checks the work-stealing pool (nested submissions, every task runs once,
+// exceptions reach wait()) and that the driver's output over examples/ is
+// the same whatever the thread count.
+
+namespace {
+
+// Each task splits itself in two until the leaves, like a recursive front end
+// spawning per-component work.
+void spawn(WorkStealingPool& pool, std::atomic<int>& leaves, int depth) {
+    if (depth == 0) {
+        leaves.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    pool.submit([&pool, &leaves, depth] { spawn(pool, leaves, depth - 1); });
+    pool.submit([&pool, &leaves, depth] { spawn(pool, leaves, depth - 1); });
+}
+
+std::string render(const std::vector<FileResult>& results) {
+    std::ostringstream out;
+    printDiagnostics(results, out);
+    for (const auto& result : results) {
+        out << result.path << " " << result.bytes << " " << (result.program != nullptr);
+        if (result.program) {
+            out << " " << result.program->components.size() << " " << result.program->functions.size()
+                << " " << result.program->globalStatements.size();
+        }
+        out << "\n";
+    }
+    return out.str();
+}
+
+}
+
+int main() {
+    {
+        WorkStealingPool pool(4);
+        std::atomic<int> leaves{0};
+        pool.submit([&] { spawn(pool, leaves, 12); });
+        pool.wait();
+        check(leaves.load() == 4096, "nested tasks all run exactly once");
+
+        pool.submit([] { throw std::runtime_error("boom"); });
+        bool rethrown = false;
+        try {
+            pool.wait();
+        } catch (const std::runtime_error&) {
+            rethrown = true;
+        }
+        check(rethrown, "task exception is rethrown by wait()");
+    }
+
+    std::vector<std::string> files = collectSourceFiles({"examples", "examples/missing.alt"});
+    check(files.size() > 1, "examples/ contains source files");
+
+    std::string sequential = render(compileFiles(files, CompileOptions{1}));
+    bool same = true;
+    for (unsigned jobs : {2u, 4u, 8u}) {
+        for (int run = 0; run < 3; ++run) {
+            same &= render(compileFiles(files, CompileOptions{jobs})) == sequential;
+        }
+    }
+    check(same, "diagnostics and results identical for 1, 2, 4 and 8 threads");
+    check(sequential.find("examples/missing.alt: error: cannot read file") != std::string::npos,
+          "unreadable input is reported");
+
+    return checkSummary("driver");
+}
@@ -0,0 +1,124 @@
+#include "../../core/include/incremental_lexer.h"
+#include "../../core/include/lexer.h"
+#include "../../tools/lsp/lsp_server.h"
+#include "check.h"
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// After every edit IncrementalLexer must hold exactly what a fresh Lexer
+// produces for the new text. The random edits insert and delete the
+// characters that switch lexer modes (quotes, comment markers, braces, tag
+// brackets) so that damage regularly spreads past the edited line.
+
+namespace {
+
+bool matchesFreshLex(const IncrementalLexer& document) {
+    Lexer lexer(std::string(document.text()));
+    std::vector<Token> expected = lexer.tokenize();
+    const std::vector<Token>& actual = document.tokens();
+    if (expected.size() != actual.size()) return false;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        const Token& x = expected[i];
+        const Token& y = actual[i];
+        if (x.type != y.type || x.keyword != y.keyword || x.value != y.value || x.offset != y.offset ||
+            x.symbol != y.symbol || x.errorIndex != y.errorIndex) {
+            return false;
+        }
+        // The document resolves positions from its boundaries; a sample
+        // is enough to catch a line count that drifted.
+        if (i % 17 == 0 || i + 1 == expected.size()) {
+            SourceLocation a = lexer.lines().locate(x.offset);
+            SourceLocation b = document.locate(y.offset);
+            if (a.line != b.line || a.column != b.column) return false;
+        }
+    }
+    if (lexer.errors().size() != document.errors().size()) return false;
+    for (size_t i = 0; i < lexer.errors().size(); ++i) {
+        const LexError& e = lexer.errors()[i];
+        const LexError& f = document.errors()[i];
+        if (e.offset != f.offset || e.message != f.message) return false;
+    }
+    return true;
+}
+
+std::string component(int i) {
+    std::string n = std::to_string(i);
+    return "component Card" + n + " {\n"
+           "    count = " + n + " * 2 + 1\n"
+           "    label = \"card \\\"" + n + "\\\"\"\n"
+           "    render:\n"
+           "        <div class=\"card\" data-id={count}>\n"
+           "            <h2>{label}</h2> // not a comment\n"
+           "        </div>\n"
+           "}\n"
+           "/* block\n   comment */\n";
+}
+
+void randomEdits(const std::string& name, std::string text, unsigned seed, int edits) {
+    static const char* pieces[] = {"\"", "'", "/*", "*/", "//", "{", "}", "<", ">", "</", "<div>", "\n",
+                                   "x", " ", "!", "@", "=", "\\", "é", "component X {\n"};
+    std::mt19937 random(seed);
+    IncrementalLexer document(text);
+    bool ok = matchesFreshLex(document);
+    for (int i = 0; i < edits && ok; ++i) {
+        size_t offset = random() % (document.text().size() + 1);
+        size_t removed = random() % 4 == 0 ? random() % 12 : 0;
+        std::string inserted = random() % 5 == 0 ? "" : pieces[random() % (sizeof(pieces) / sizeof(*pieces))];
+        document.edit(offset, removed, inserted);
+        ok = matchesFreshLex(document);
+        if (!ok) std::cout << "  diverged after edit " << i << " at offset " << offset << "\n";
+    }
+    check(ok, name + ": " + std::to_string(edits) + " random edits match a fresh lex");
+}
+
+}
+
+int main() {
+    std::string catalog;
+    for (int i = 0; i < 40; ++i) catalog += component(i);
+
+    randomEdits("catalog", catalog, 1, 400);
+    randomEdits("catalog, second seed", catalog, 7, 400);
+    randomEdits("empty start", "", 3, 200);
+
+    // Typing inside one component of a large file re-lexes a handful of
+    // tokens, not the file.
+    std::string large;
+    for (int i = 0; i < 2000; ++i) large += component(i);
+    IncrementalLexer document(large);
+    size_t at = document.lineOffset(10001) + 4;
+    size_t worst = 0;
+    for (char c : std::string("value = 42")) {
+        IncrementalLexer::EditStats stats = document.edit(at++, 0, std::string(1, c));
+        worst = std::max(worst, stats.relexed);
+    }
+    check(worst < 16 && matchesFreshLex(document), "keystrokes in a large file re-lex only nearby tokens");
+
+    // An opened comment swallows tokens up to the next "*/" and the damage
+    // spreads exactly that far.
+    IncrementalLexer::EditStats opened = document.edit(document.lineOffset(101), 0, "/*");
+    check(opened.replaced > opened.relexed && opened.replaced < 100 && matchesFreshLex(document),
+          "opening a block comment re-lexes to its end");
+    document.edit(document.lineOffset(101), 2, "");
+    check(matchesFreshLex(document), "closing it again restores the stream");
+
+    // The LSP document store applies ranged edits in UTF-16 positions.
+    LSPServer server;
+    server.didOpen("file:///a.alt", "component A {\n    name = \"h\xC3\xA9llo\"\n}\n", 1);
+    server.didChange("file:///a.alt", 2, {{LSPRange{{1, 14}, {1, 15}}, "E"}});
+    const LSPDocument* lspDocument = server.document("file:///a.alt");
+    check(lspDocument != nullptr && lspDocument->lexer.text() == "component A {\n    name = \"h\xC3\xA9" "Elo\"\n}\n" &&
+              lspDocument->version == 2,
+          "LSP ranged change lands on the right UTF-16 column");
+    server.didChange("file:///a.alt", 3, {{LSPRange{{1, 11}, {1, 11}}, "\""}});
+    check(!server.diagnostics("file:///a.alt").empty(), "LSP reports a lexer diagnostic after an edit");
+    server.didChange("file:///a.alt", 4, {{std::nullopt, "x = 1\n"}});
+    check(server.diagnostics("file:///a.alt").empty() && server.document("file:///a.alt")->lexer.text() == "x = 1\n",
+          "LSP full-text change replaces the document");
+    server.didClose("file:///a.alt");
+    check(server.document("file:///a.alt") == nullptr, "LSP close drops the document");
+
+    return checkSummary("incremental lexer");
+}
@@ -0,0 +1,134 @@
+#include "../../core/include/incremental_lexer.h"
+#include "../../core/include/incremental_parser.h"
+#include "../../core/include/lexer.h"
+#include "../../core/include/parser.h"
+#include "check.h"
+#include <iostream>
+#include <random>
+#include <string>
+
+// After every edit IncrementalParser must produce the same tree and errors as
+// a fresh parse of the new text, while reusing the components and functions
+// the edit did not reach.
+
+namespace {
+
+// Node kinds, positions and names in tree order.
+void dump(const Node& node, std::string& out) {
+    out += std::to_string(static_cast<int>(node.nodeType)) + "@" + std::to_string(node.offset);
+    if (auto* n = dynamic_cast<const Component*>(&node)) out += " " + std::string(symbolText(n->name));
+    if (auto* n = dynamic_cast<const Function*>(&node)) out += " " + std::string(symbolText(n->name));
+    if (auto* n = dynamic_cast<const Identifier*>(&node)) out += " " + std::string(symbolText(n->name));
+    out += "(";
+    forEachChild(node, [&out](const Node& child) { dump(child, out); });
+    out += ")";
+}
+
+std::string dump(const Program& program, const std::vector<ParseError>& errors) {
+    std::string out;
+    dump(program, out);
+    for (const ParseError& error : errors) {
+        out += "\n" + std::to_string(error.offset) + " " + error.message;
+    }
+    return out;
+}
+
+bool matchesFreshParse(IncrementalParser& parser, const IncrementalLexer& document) {
+    Lexer lexer(std::string(document.text()));
+    Parser fresh(lexer);
+    std::unique_ptr<Program> expected = fresh.parse();
+    const Program& actual = parser.parse(document);
+    return dump(*expected, fresh.errors()) == dump(actual, parser.errors());
+}
+
+std::string unit(int i) {
+    std::string n = std::to_string(i);
+    return "component Card" + n + " {\n"
+           "    count = " + n + "\n"
+           "    increment {\n"
+           "        count = count + 1\n"
+           "    }\n"
+           "}\n"
+           "function scale" + n + "(value) {\n"
+           "    return value * " + n + "\n"
+           "}\n";
+}
+
+std::string document(int units) {
+    std::string text = "import { Button } from \"ui\"\n";
+    for (int i = 0; i < units; ++i) text += unit(i);
+    return text;
+}
+
+void randomEdits(unsigned seed, int edits) {
+    static const char* pieces[] = {"{", "}", "(", ")", "\n", "x", " ", "=", "+", "component X {\n",
+                                   "function f() {\n", "return 1\n", "//", "\""};
+    IncrementalLexer document(::document(20));
+    IncrementalParser parser;
+    parser.parse(document);
+    std::mt19937 random(seed);
+    for (int i = 0; i < edits; ++i) {
+        size_t size = document.text().size();
+        size_t offset = size == 0 ? 0 : random() % (size + 1);
+        size_t removed = random() % 3 == 0 ? random() % 8 : 0;
+        std::string inserted = random() % 4 == 0 ? "" : pieces[random() % (sizeof(pieces) / sizeof(*pieces))];
+        parser.noteEdit(document.edit(offset, removed, inserted));
+        if (!matchesFreshParse(parser, document)) {
+            check(false, "seed " + std::to_string(seed) + ": edit " + std::to_string(i) + " matches a fresh parse");
+            return;
+        }
+    }
+    check(true, "seed " + std::to_string(seed) + ": " + std::to_string(edits) + " random edits match a fresh parse");
+}
+
+}
+
+int main() {
+    {
+        IncrementalLexer document(::document(200));
+        IncrementalParser parser;
+        check(matchesFreshParse(parser, document), "initial parse matches a fresh parse");
+        check(parser.errors().empty() && parser.program()->components.size() == 200 &&
+                  parser.program()->functions.size() == 200,
+              "test document parses into 200 components and 200 functions");
+
+        // A keystroke inside one method body re-parses only that component.
+        size_t at = document.lineOffset(2 + 9 * 100 + 3) + 16;
+        parser.noteEdit(document.edit(at, 0, "step + "));
+        check(matchesFreshParse(parser, document), "edit inside a method matches a fresh parse");
+        IncrementalParser::Stats stats = parser.lastStats();
+        check(stats.reused >= 398 && stats.parsed <= 3,
+              "local edit reuses the other subtrees (" + std::to_string(stats.reused) + " reused, " +
+                  std::to_string(stats.parsed) + " parsed)");
+
+        // New lines shift every later subtree; reused nodes must follow.
+        parser.noteEdit(document.edit(document.lineOffset(50), 0, "\n\n\n"));
+        check(matchesFreshParse(parser, document), "inserted lines shift reused subtrees");
+        check(parser.lastStats().reused >= 398, "line shift does not force a re-parse");
+
+        // Breaking a component produces the same errors as a full parse, and
+        // repairing it brings back a clean tree.
+        size_t brace = document.lineOffset(2 + 9 * 10 + 3 + 2);
+        parser.noteEdit(document.edit(brace, 0, "(("));
+        check(matchesFreshParse(parser, document), "broken component matches a fresh parse");
+        check(!parser.errors().empty(), "broken component reports errors");
+        parser.noteEdit(document.edit(brace, 2, ""));
+        check(matchesFreshParse(parser, document) && parser.errors().empty(), "repaired component parses cleanly");
+
+        // A reloaded file only re-parses what differs.
+        std::string reloaded(document.text());
+        reloaded.replace(reloaded.find("scale150"), 8, "resize150");
+        parser.noteEdit(document.assign(reloaded));
+        check(matchesFreshParse(parser, document), "assign() matches a fresh parse");
+        check(parser.lastStats().parsed <= 3, "assign() re-parses only the changed function");
+
+        parser.invalidate();
+        check(matchesFreshParse(parser, document) && parser.lastStats().reused == 0,
+              "invalidate() forces a full parse");
+    }
+
+    randomEdits(1, 300);
+    randomEdits(7, 300);
+
+    return checkSummary("incremental parser");
+}
@@ -0,0 +1,186 @@
+#include "../../core/include/ast.h"
+#include "../../core/include/byte_scan.h"
+#include "../../core/include/json_writer.h"
+#include "check.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+// Escaping must agree with a byte-at-a-time reference under every scanner
+// implementation, both styles must produce the exact expected text, and
+// output flushed to a file descriptor must equal output built in a string.
+
+namespace {
+
+std::string referenceEscape(std::string_view s) {
+    std::string result;
+    for (unsigned char c : s) {
+        switch (c) {
+            case '"': result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\b': result += "\\b"; break;
+            case '\f': result += "\\f"; break;
+            case '\n': result += "\\n"; break;
+            case '\r': result += "\\r"; break;
+            case '\t': result += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    result += buf;
+                } else {
+                    result += static_cast<char>(c);
+                }
+                break;
+        }
+    }
+    return result;
+}
+
+void writeSample(JsonWriter& json) {
+    json.beginObject()
+        .field("name", "a \"b\"\n")
+        .field("count", 3)
+        .field("big", uint64_t(18446744073709551615ull))
+        .field("negative", -42)
+        .field("ratio", 0.5)
+        .field("ok", true)
+        .key("none").null()
+        .key("empty").beginArray().endArray()
+        .key("items").beginArray().value(1).beginObject().endObject().value("x").endArray()
+        .endObject();
+}
+
+}
+
+int main() {
+    std::mt19937 rng(7);
+    std::vector<std::string> inputs;
+    std::string allBytes;
+    for (int b = 0; b < 256; ++b) allBytes += static_cast<char>(b);
+    inputs.push_back(allBytes);
+    static const char alphabet[] = "ab \"\\\n\t\x01\x1f\x7f\xc3\xa9/";
+    for (int i = 0; i < 50; ++i) {
+        std::string s;
+        size_t length = rng() % 200;
+        while (s.size() < length) {
+            if (rng() % 4 == 0) s.append(rng() % 70, 'x');
+            s += alphabet[rng() % (sizeof alphabet - 1)];
+        }
+        inputs.push_back(s);
+    }
+    for (auto impl : {bytescan::Implementation::Scalar, bytescan::Implementation::SSE2, bytescan::Implementation::AVX2}) {
+        if (!bytescan::select(impl)) continue;
+        bool same = true;
+        for (const std::string& input : inputs) {
+            for (size_t offset = 0; offset < 40 && offset <= input.size(); ++offset) {
+                std::string escaped;
+                appendJsonEscaped(escaped, std::string_view(input).substr(offset));
+                same &= escaped == referenceEscape(std::string_view(input).substr(offset));
+            }
+        }
+        check(same, std::string("escaping matches the reference (") + bytescan::name(impl) + ")");
+    }
+
+    {
+        std::string pretty;
+        {
+            JsonWriter json(pretty);
+            writeSample(json);
+        }
+        check(pretty ==
+                  "{\n"
+                  "  \"name\": \"a \\\"b\\\"\\n\",\n"
+                  "  \"count\": 3,\n"
+                  "  \"big\": 18446744073709551615,\n"
+                  "  \"negative\": -42,\n"
+                  "  \"ratio\": 0.5,\n"
+                  "  \"ok\": true,\n"
+                  "  \"none\": null,\n"
+                  "  \"empty\": [],\n"
+                  "  \"items\": [\n"
+                  "    1,\n"
+                  "    {},\n"
+                  "    \"x\"\n"
+                  "  ]\n"
+                  "}\n",
+              "pretty output");
+        std::string compact;
+        {
+            JsonWriter json(compact, JsonWriter::Style::Compact);
+            writeSample(json);
+        }
+        check(compact == "{\"name\":\"a \\\"b\\\"\\n\",\"count\":3,\"big\":18446744073709551615,\"negative\":-42,"
+                         "\"ratio\":0.5,\"ok\":true,\"none\":null,\"empty\":[],\"items\":[1,{},\"x\"]}",
+              "compact output");
+    }
+
+    {
+        // Several flushes' worth, through a real descriptor.
+        auto write = [](JsonWriter& json) {
+            json.beginArray();
+            for (int i = 0; i < 60000; ++i) {
+                json.beginObject().field("index", i).field("text", "line \"" + std::to_string(i) + "\"\n").endObject();
+            }
+            json.endArray();
+        };
+        std::string expected;
+        {
+            JsonWriter json(expected);
+            write(json);
+        }
+        std::string path = (std::filesystem::temp_directory_path() / "alterion-jsonwritertest.json").string();
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        uint64_t written = 0;
+        bool flushed = false;
+        {
+            JsonWriter json(fileno(file));
+            write(json);
+            flushed = json.flush();
+            written = json.bytesWritten();
+        }
+        std::fclose(file);
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream contents;
+        contents << in.rdbuf();
+        std::filesystem::remove(path);
+        check(expected.size() > 2 * JsonWriter::FlushThreshold && flushed && written == expected.size() &&
+                  contents.str() == expected,
+              "descriptor output equals string output");
+    }
+
+    {
+        ASTArena arena;
+        ASTNode* root = arena.create(ASTNodeType::Program, "Program");
+        ASTNode* tag = arena.create(ASTNodeType::Tag, "div", 2, 5);
+        arena.setValue(tag, "say \"hi\"\\");
+        ASTArena::addChild(root, tag);
+        ASTNode* empty = arena.create(ASTNodeType::Literal, "", 3, 1);
+        arena.setValue(empty, "");
+        arena.setError(empty, "bad\tthing");
+        ASTArena::addChild(tag, empty);
+        ASTArena::addChild(root, arena.create(ASTNodeType::Identifier, "x", 4, 1));
+        check(astToJson(root, JsonWriter::Style::Compact) ==
+                  "{\"type\":\"0\",\"name\":\"Program\",\"line\":0,\"column\":0,\"children\":["
+                  "{\"type\":\"15\",\"name\":\"div\",\"value\":\"say \\\"hi\\\"\\\\\",\"line\":2,\"column\":5,"
+                  "\"children\":[{\"type\":\"13\",\"name\":\"\",\"value\":\"\",\"line\":3,\"column\":1,"
+                  "\"error\":\"bad\\tthing\",\"children\":[]}]},"
+                  "{\"type\":\"14\",\"name\":\"x\",\"line\":4,\"column\":1,\"children\":[]}]}",
+              "astToJson escapes and nests");
+
+        ASTNode* parent = root;
+        for (int i = 0; i < 200000; ++i) {
+            ASTNode* node = arena.create(ASTNodeType::Block, "", i, 1);
+            ASTArena::addChild(parent, node);
+            parent = node;
+        }
+        std::string deep = astToJson(root, JsonWriter::Style::Compact);
+        check(deep.size() > 200000 * 50 && deep.back() == '}', "astToJson handles a 200000-deep tree");
+    }
+
+    return checkSummary("JSON writer");
+}
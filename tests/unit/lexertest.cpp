@@ -1,14 +1,20 @@
+#include "../../core/include/alloc_stats.h"
+#include "../../core/include/json_writer.h"
 #include "../../core/include/lexer.h"
+#include "../../core/include/source_buffer.h"
 #include <fstream>
 #include <iostream>
 #include <vector>
 #include <string>
 #include <iomanip>
 #include <unordered_set>
+#include <unordered_map>
 #include <chrono>
 #include <ctime>
 #include <filesystem>
 #include <sstream>
+#include <cstdio>
+#include <cstdlib>
 
 // Structure to hold expected token info
 struct ExpectedToken {
@@ -27,6 +33,28 @@ std::string tokenTypeToString(TokenType type) {
         case TokenType::String: return "String";
         case TokenType::Operator: return "Operator";
         case TokenType::Arrow: return "Arrow";
+        case TokenType::Plus: return "Plus";
+        case TokenType::Minus: return "Minus";
+        case TokenType::Multiply: return "Multiply";
+        case TokenType::Divide: return "Divide";
+        case TokenType::Modulo: return "Modulo";
+        case TokenType::Power: return "Power";
+        case TokenType::PlusAssign: return "PlusAssign";
+        case TokenType::MinusAssign: return "MinusAssign";
+        case TokenType::MultiplyAssign: return "MultiplyAssign";
+        case TokenType::DivideAssign: return "DivideAssign";
+        case TokenType::ModuloAssign: return "ModuloAssign";
+        case TokenType::Equal: return "Equal";
+        case TokenType::NotEqual: return "NotEqual";
+        case TokenType::Less: return "Less";
+        case TokenType::LessEqual: return "LessEqual";
+        case TokenType::Greater: return "Greater";
+        case TokenType::GreaterEqual: return "GreaterEqual";
+        case TokenType::LogicalAnd: return "LogicalAnd";
+        case TokenType::LogicalOr: return "LogicalOr";
+        case TokenType::LogicalNot: return "LogicalNot";
+        case TokenType::Increment: return "Increment";
+        case TokenType::Decrement: return "Decrement";
         case TokenType::TagOpen: return "TagOpen";
         case TokenType::TagClose: return "TagClose";
         case TokenType::TagSelfClose: return "TagSelfClose";
@@ -60,8 +88,8 @@ std::string tokenTypeToString(TokenType type) {
 }
 
 // Compute expected type/value logically for each token
-void computeExpected(const Token& token, std::string& expectedType, std::string& expectedValue) {
-    static const std::unordered_set<std::string> keywords = {
+void computeExpected(const Token& token, std::string& expectedType, std::string_view& expectedValue) {
+    static const std::unordered_set<std::string_view> keywords = {
         "async", "component", "import", "extern", "for", "if", "else", "while", "return", "break", "continue", "yield", "await", "throw", "try", "catch", "finally",
         "render", "script", "function", "fn", "method", "type", "interface", "struct", "enum", "union", "from", "export", "use", "pub", "mod", "namespace",
         "move", "copy", "ref", "deref", "owned", "borrowed", "shared", "weak", "true", "false", "null", "none", "undefined", "this", "super", "self", "Self", "match", "case", "default",
@@ -103,10 +131,25 @@ void computeExpected(const Token& token, std::string& expectedType, std::string&
         return;
     }
 
-    // Predict expected type for operators and arrows
-    if (token.type == TokenType::Operator || token.type == TokenType::Arrow) {
-        expectedType = tokenTypeToString(token.type);
+    // Predict expected type for operators and arrows from their spelling
+    static const std::unordered_map<std::string_view, std::string> operatorTypes = {
+        {"=>", "Arrow"}, {"->", "Arrow"},
+        {"+", "Plus"}, {"-", "Minus"}, {"*", "Multiply"}, {"/", "Divide"}, {"%", "Modulo"}, {"**", "Power"},
+        {"+=", "PlusAssign"}, {"-=", "MinusAssign"}, {"*=", "MultiplyAssign"}, {"/=", "DivideAssign"}, {"%=", "ModuloAssign"},
+        {"==", "Equal"}, {"!=", "NotEqual"}, {"<", "Less"}, {"<=", "LessEqual"}, {">", "Greater"}, {">=", "GreaterEqual"},
+        {"&&", "LogicalAnd"}, {"||", "LogicalOr"}, {"!", "LogicalNot"}, {"++", "Increment"}, {"--", "Decrement"},
+        {"&", "Operator"}, {"|", "Operator"}, {"^", "Operator"}, {"~", "Operator"},
+        {"#", "Operator"}, {"$", "Operator"}, {"?", "Operator"}, {"@", "Operator"}
+    };
+    bool isOperator = token.type == TokenType::Operator || token.type == TokenType::Arrow ||
+                      (token.type >= TokenType::Plus && token.type <= TokenType::Decrement);
+    if (isOperator) {
+        expectedType = "Operator";
         expectedValue = token.value;
+        auto op = operatorTypes.find(token.value);
+        if (op != operatorTypes.end()) {
+            expectedType = op->second;
+        }
         return;
     }
 
@@ -185,46 +228,26 @@ void computeExpected(const Token& token, std::string& expectedType, std::string&
     expectedValue = token.value;
 }
 
-// Helper to escape JSON string values
-std::string jsonEscape(const std::string& s) {
-    std::string result;
-    for (unsigned char c : s) {
-        switch (c) {
-            case '"': result += "\\\""; break;
-            case '\\': result += "\\\\"; break;
-            case '\b': result += "\\b"; break;
-            case '\f': result += "\\f"; break;
-            case '\n': result += "\\n"; break;
-            case '\r': result += "\\r"; break;
-            case '\t': result += "\\t"; break;
-            default:
-                if (c < 0x20) {
-                    char buf[8];
-                    snprintf(buf, sizeof(buf), "\\u%04x", c);
-                    result += buf;
-                } else {
-                    result += c;
-                }
-                break;
-        }
-    }
-    return result;
-}
-
 int main() {
     
-    std::ifstream file("examples/lexer-app-test.alt");
-    if (!file) {
+    auto input = SourceBuffer::fromFile("examples/lexer-app-test.alt");
+    if (!input) {
         std::cerr << "Failed to open examples/lexer-app-test.alt" << std::endl;
         return 1;
     }
-    std::string input((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-    file.close();
-    std::cout << "[DEBUG] Input size: " << input.size() << " bytes\n";
+    std::cout << "[DEBUG] Input size: " << input->size() << " bytes"
+              << (input->isMapped() ? " (mapped)" : "") << "\n";
 
+    // Heap footprint of the token stream, comparable across lexer changes.
+    AllocationScope lexAllocations;
     Lexer lexer(input);
     std::vector<Token> actualTokens = lexer.tokenize();
+    AllocationCounts lexCounts = lexAllocations.counts();
     std::cout << "[DEBUG] Token count: " << actualTokens.size() << "\n";
+    std::cout << "[STATS] tokenize: " << lexCounts.allocations << " allocations, "
+              << lexCounts.bytes << " bytes allocated, "
+              << lexCounts.peakLiveBytes << " peak live bytes, "
+              << sizeof(Token) << " bytes per token\n";
 
 
     std::filesystem::create_directories("results");
@@ -234,39 +257,47 @@ int main() {
     char filename[128];
     std::strftime(filename, sizeof(filename), "results-dashboard/public/results/lexer-results.json", std::localtime(&now_time));
 
-    // Output HTML
-    std::ofstream json(filename);
-    if (!json) {
+    std::FILE* file = std::fopen(filename, "wb");
+    if (!file) {
         std::cerr << "[ERROR] Could not open " << filename << " for writing!\n";
         return 2;
     }
     std::cout << "[DEBUG] Writing JSON to " << filename << "...\n";
-    json << "[\n"; 
-    for (size_t i = 0; i < actualTokens.size(); ++i) {
-        const Token& token = actualTokens[i];
-        std::string expectedType, expectedValue;
-        computeExpected(token, expectedType, expectedValue);
-        std::string returnedType;
-        if (token.type == TokenType::Text) {
-            returnedType = "Text";
-        } else {
-            returnedType = tokenTypeToString(token.type);
+    auto writeStart = std::chrono::steady_clock::now();
+    uint64_t jsonBytes = 0;
+    {
+        JsonWriter json(fileno(file));
+        json.beginArray();
+        for (size_t i = 0; i < actualTokens.size(); ++i) {
+            const Token& token = actualTokens[i];
+            std::string expectedType;
+            std::string_view expectedValue;
+            computeExpected(token, expectedType, expectedValue);
+            std::string returnedType = token.type == TokenType::Text ? "Text" : tokenTypeToString(token.type);
+            bool ok = expectedType == returnedType && expectedValue == token.value;
+            SourceLocation at = lexer.lines().locate(token.offset);
+            json.beginObject()
+                .field("index", i)
+                .field("expectedType", expectedType)
+                .field("expectedValue", expectedValue)
+                .field("returnedType", returnedType)
+                .field("returnedValue", token.value)
+                .field("line", at.line)
+                .field("column", at.column)
+                .field("status", ok ? "OK" : "DIFF")
+                .endObject();
+        }
+        json.endArray();
+        if (!json.flush()) {
+            std::cerr << "[ERROR] Writing " << filename << " failed\n";
+            return 2;
         }
-        std::string returnedValue = token.value;
-        std::string status = (expectedType == returnedType && expectedValue == returnedValue) ? "OK" : "DIFF";
-        json << "  {\n"
-             << "    \"index\": " << i << ",\n"
-             << "    \"expectedType\": \"" << jsonEscape(expectedType) << "\",\n"
-             << "    \"expectedValue\": \"" << jsonEscape(expectedValue) << "\",\n"
-             << "    \"returnedType\": \"" << jsonEscape(returnedType) << "\",\n"
-             << "    \"returnedValue\": \"" << jsonEscape(returnedValue) << "\",\n"
-             << "    \"line\": " << token.line << ",\n"
-             << "    \"column\": " << token.column << ",\n"
-             << "    \"status\": \"" << jsonEscape(status) << "\"\n"
-             << "  }" << (i < actualTokens.size() - 1 ? "," : "") << "\n"; 
+        jsonBytes = json.bytesWritten();
     }
-    json << "]\n";
-    json.close();
+    std::fclose(file);
+    std::cout << "[STATS] JSON: " << jsonBytes << " bytes in "
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - writeStart).count()
+              << " ms\n";
     std::cout << "Lexer test complete. Output written to " << filename << "\n";
     return 0;
 }
\ No newline at end of file
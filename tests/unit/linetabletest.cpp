@@ -0,0 +1,179 @@
+#include "../../core/include/byte_scan.h"
+#include "../../core/include/lexer.h"
+#include "../../core/include/line_table.h"
+#include "../../core/include/source_buffer.h"
+#include "../bench/corpus.h"
+#include "check.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// LineTable::locate() against a byte-by-byte walk that counts lines at '\n'
+// and columns in codepoints, the way the lexer used to while lexing: at
+// every codepoint boundary of hand-written edge cases and of each corpus
+// shape, with every bytescan implementation building the table.
+
+namespace {
+
+struct Expected {
+    uint32_t offset;
+    SourceLocation at;
+};
+
+// Bytes in a codepoint starting at text[i]; anything malformed is one byte.
+size_t codepointBytes(const std::string& text, size_t i) {
+    auto byte = [&](size_t k) { return static_cast<unsigned char>(text[k]); };
+    auto follows = [&](size_t n) {
+        for (size_t k = 1; k <= n; ++k) {
+            if (i + k >= text.size() || (byte(i + k) & 0xC0) != 0x80) return false;
+        }
+        return true;
+    };
+    unsigned char c = byte(i);
+    uint32_t cp;
+    if ((c & 0xE0) == 0xC0 && follows(1)) {
+        cp = (c & 0x1Fu) << 6 | (byte(i + 1) & 0x3Fu);
+        return cp >= 0x80 ? 2 : 1;
+    }
+    if ((c & 0xF0) == 0xE0 && follows(2)) {
+        cp = (c & 0x0Fu) << 12 | (byte(i + 1) & 0x3Fu) << 6 | (byte(i + 2) & 0x3Fu);
+        return cp >= 0x800 ? 3 : 1;
+    }
+    if ((c & 0xF8) == 0xF0 && follows(3)) {
+        cp = (c & 0x07u) << 18 | (byte(i + 1) & 0x3Fu) << 12 | (byte(i + 2) & 0x3Fu) << 6 | (byte(i + 3) & 0x3Fu);
+        return cp >= 0x10000 && cp <= 0x10FFFF ? 4 : 1;
+    }
+    return 1;
+}
+
+std::vector<Expected> walk(const std::string& text) {
+    std::vector<Expected> result;
+    uint32_t line = 1, column = 1;
+    size_t i = 0;
+    while (i < text.size()) {
+        result.push_back({static_cast<uint32_t>(i), {line, column}});
+        if (text[i] == '\n') {
+            ++line;
+            column = 1;
+            ++i;
+        } else {
+            ++column;
+            i += codepointBytes(text, i);
+        }
+    }
+    result.push_back({static_cast<uint32_t>(text.size()), {line, column}});
+    return result;
+}
+
+bool matches(const std::string& text) {
+    LineTable lines(text);
+    size_t newlines = 0;
+    for (char c : text) newlines += c == '\n';
+    if (lines.lineCount() != newlines + 1 || lines.lineStart(1) != 0) return false;
+    for (const Expected& e : walk(text)) {
+        SourceLocation at = lines.locate(e.offset);
+        if (at.line != e.at.line || at.column != e.at.column) {
+            std::cout << "  offset " << e.offset << ": got " << at.line << ':' << at.column << ", expected "
+                      << e.at.line << ':' << e.at.column << "\n";
+            return false;
+        }
+        if (lines.lineStart(at.line) > e.offset) return false;
+    }
+    return true;
+}
+
+}
+
+int main() {
+    const std::vector<std::pair<std::string, std::string>> cases = {
+        {"empty input", ""},
+        {"one line without a newline", "let x = 1"},
+        {"only newlines", "\n\n\n"},
+        {"CRLF counts '\\r' as a column", "a\r\nb\r\n"},
+        {"two-byte codepoints", "caf\xC3\xA9 = 1\n\xC3\xA9t\xC3\xA9\n"},
+        {"three- and four-byte codepoints", "\xE2\x82\xAC\xF0\x9F\x98\x80x\n"},
+        {"malformed bytes count one each", "\xC3(\n\xE2\x82\n\x80\x80 \xF8\xC0\xAF\n\xE2\x82"},
+        {"surrogate and out-of-range sequences", "\xED\xA0\x80 \xF4\x90\x80\x80\n"},
+    };
+
+    std::vector<bytescan::Implementation> implementations{bytescan::Implementation::Scalar};
+    for (auto impl : {bytescan::Implementation::SSE2, bytescan::Implementation::AVX2}) {
+        if (bytescan::select(impl)) implementations.push_back(impl);
+    }
+
+    for (bytescan::Implementation impl : implementations) {
+        bytescan::select(impl);
+        std::string suffix = std::string(" (") + bytescan::name(impl) + ")";
+        for (const auto& [name, text] : cases) check(matches(text), name + suffix);
+        for (corpus::Shape shape : corpus::allShapes()) {
+            check(matches(corpus::generate(shape, 64 * 1024, 7)), std::string(corpus::name(shape)) + suffix);
+        }
+    }
+
+    LineTable table("a\nb");
+    SourceLocation none = table.locate(LineTable::NoOffset);
+    check(none.line == 0 && none.column == 0, "NoOffset locates to 0:0");
+    SourceLocation past = table.locate(100);
+    check(past.line == 2 && past.column == 2, "offsets past the end clamp to EOF");
+
+    // One table per buffer, however many threads ask for it first.
+    auto buffer = SourceBuffer::fromString(corpus::generate(corpus::Shape::Mixed, 1 << 20));
+    std::vector<const LineTable*> seen(4);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < seen.size(); ++t) {
+        threads.emplace_back([&buffer, &seen, t] { seen[t] = &buffer->lines(); });
+    }
+    for (std::thread& thread : threads) thread.join();
+    bool shared = true;
+    for (const LineTable* lines : seen) shared &= lines == seen[0];
+    Lexer lexer(buffer);
+    check(shared && &lexer.lines() == seen[0], "the buffer builds its table once");
+
+#ifndef _WIN32
+    {
+        // Sparse, so the file takes no disk space and the mapping no memory.
+        std::string path = (std::filesystem::temp_directory_path() / "alterion-linetabletest-huge.alt").string();
+        std::ofstream{path};
+        size_t size = SourceBuffer::MaxSize + 1;
+        std::filesystem::resize_file(path, size);
+        check(SourceBuffer::fromFile(path) == nullptr, "files with offsets past 32 bits are rejected");
+
+        int fd = open(path.c_str(), O_RDONLY);
+        void* base = fd < 0 ? MAP_FAILED : mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (base != MAP_FAILED) {
+            Lexer lexer(SourceBuffer::borrow(std::string_view(static_cast<const char*>(base), size)));
+            std::vector<Token> tokens = lexer.tokenize();
+            check(tokens.size() == 1 && tokens[0].type == TokenType::EOFToken && tokens[0].offset == 0 &&
+                      lexer.errors().size() == 1 && lexer.errors()[0].offset == 0,
+                  "a borrowed buffer that large is reported and lexed as empty");
+            munmap(base, size);
+        } else {
+            check(false, "map the sparse file");
+        }
+        if (fd >= 0) close(fd);
+        std::filesystem::remove(path);
+    }
+#endif
+
+    std::string big = corpus::generate(corpus::Shape::Mixed, 16 << 20);
+    double best = 1e30;
+    for (int run = 0; run < 3; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        LineTable lines(big);
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::cout << "[STATS] line table: " << big.size() / best / 1e9 << " GB/s with " << bytescan::name(bytescan::active())
+              << "\n";
+
+    return checkSummary("line table");
+}
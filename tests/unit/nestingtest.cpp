@@ -0,0 +1,166 @@
+#include "../../core/include/lexer.h"
+#include "../../core/include/parser.h"
+#include "check.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Tag trees are parsed with an explicit stack, so depth costs no call
+// stack; past the nesting limit tags and expressions are reported as errors
+// instead of overflowing the stack.
+
+namespace {
+
+// The corpus components have a method before `render:` too; without one
+// the lexer is still in expression mode when the tags start.
+const std::string componentStart = "    increment {\n        count = count + 1\n    }\n    render:\n";
+
+std::string nestedTags(size_t depth) {
+    std::string source = "component Deep {\n" + componentStart;
+    for (size_t i = 0; i < depth; ++i) source += "<div class=\"d\">";
+    source += "leaf";
+    for (size_t i = 0; i < depth; ++i) source += "</div>";
+    source += "\n<span></span>\n}\ncomponent After {\n    count = 0\n}\n";
+    return source;
+}
+
+struct Parsed {
+    std::unique_ptr<Program> program;
+    std::vector<ParseError> errors;
+};
+
+Parsed parse(const std::string& source, size_t nestingLimit = Parser::DefaultNestingLimit) {
+    Lexer lexer(source);
+    Parser parser(lexer.tokenizeBuffer());
+    parser.setNestingLimit(nestingLimit);
+    Parsed result;
+    result.program = parser.parse();
+    result.errors = parser.errors();
+    return result;
+}
+
+// Depth of the first tag of the first component, walked without recursion.
+size_t tagDepth(const Program& program) {
+    if (program.components.empty() || program.components[0]->body.empty()) return 0;
+    size_t depth = 0;
+    const Node* node = program.components[0]->body[0].get();
+    while (auto* tag = dynamic_cast<const Tag*>(node)) {
+        ++depth;
+        node = nullptr;
+        for (const ASTNodePtr& child : tag->children) {
+            if (dynamic_cast<const Tag*>(child.get()) != nullptr) node = child.get();
+        }
+    }
+    return depth;
+}
+
+// Tears the tree down one level at a time; destroying a very deep tree in
+// one go would recurse once per level.
+void release(Program& program) {
+    for (ComponentPtr& component : program.components) {
+        std::vector<ASTNodePtr> pending = std::move(component->body);
+        while (!pending.empty()) {
+            ASTNodePtr node = std::move(pending.back());
+            pending.pop_back();
+            if (auto* tag = dynamic_cast<Tag*>(node.get())) {
+                for (ASTNodePtr& child : tag->children) pending.push_back(std::move(child));
+            }
+        }
+    }
+}
+
+}
+
+int main() {
+    {
+        Parsed file = parse("component A {\n" + componentStart +
+                            "        <div class=\"a\"><br /><p>{count}</p><i></i></div>\n"
+                            "        <span></span>\n}\n");
+        const auto& body = file.program->components[0]->body;
+        auto* div = body.empty() ? nullptr : dynamic_cast<const Tag*>(body[0].get());
+        auto childTag = [div](size_t i) {
+            return div != nullptr && i < div->children.size() ? dynamic_cast<const Tag*>(div->children[i].get())
+                                                               : nullptr;
+        };
+        bool shape = file.errors.empty() && body.size() == 2 && div != nullptr && div->attributes.size() == 1 &&
+                     div->children.size() == 3 && childTag(0) && childTag(0)->tagName == intern("br") &&
+                     childTag(0)->isSelfClosing && childTag(1) && childTag(1)->tagName == intern("p") &&
+                     childTag(1)->children.size() == 1 && childTag(2) && childTag(2)->tagName == intern("i");
+        check(shape, "children, attributes and self-closing tags keep their order");
+    }
+
+    {
+        Parsed file = parse("component A {\n" + componentStart + "        <div><p>x</span></div>\n}\n");
+        check(file.errors.size() == 1 && file.errors[0].message.find("Mismatched closing tag") != std::string::npos,
+              "a mismatched closing tag is still reported");
+    }
+
+    {
+        Parsed file = parse(nestedTags(10000), 10000);
+        bool ok = file.errors.empty() && tagDepth(*file.program) == 10000 && file.program->components.size() == 2 &&
+                  file.program->components[0]->body.size() == 2;
+        release(*file.program);
+        check(ok, "a tree 10000 tags deep parses within a limit of 10000");
+    }
+
+    {
+        std::string source = nestedTags(10000);
+        Parsed file = parse(source);
+        size_t tooDeep = 0;
+        for (size_t i = 0; i <= Parser::DefaultNestingLimit; ++i) tooDeep = source.find("<div", tooDeep + 1);
+        bool reported = file.errors.size() == 1 && file.errors[0].offset == tooDeep &&
+                        file.errors[0].message.find("nested more than 1000") != std::string::npos;
+        check(reported, "the tag past the default limit is reported");
+        check(tagDepth(*file.program) == Parser::DefaultNestingLimit, "the tree keeps the tags within the limit");
+        // The error ends the component: the <span> after the tree is skipped
+        // and parsing resumes at the next component.
+        const auto& components = file.program->components;
+        check(components.size() == 2 && components[0]->body.size() == 1 && symbolText(components[1]->name) == "After",
+              "the rest of the component is skipped and parsing resumes at the next one");
+        release(*file.program);
+    }
+
+    // Each of these would overflow the stack without a limit.
+    const size_t deep = 100000;
+    std::vector<std::pair<std::string, std::string>> expressions = {
+        {"brackets", "x = " + std::string(deep, '(') + "1" + std::string(deep, ')') + "\n"},
+        {"unary operators", [&] {
+             std::string text = "x = ";
+             for (size_t i = 0; i < deep; ++i) text += "- ";
+             return text + "y\n";
+         }()},
+        {"right-associative operators", [&] {
+             std::string text = "x = 2";
+             for (size_t i = 0; i < deep; ++i) text += " ** 2";
+             return text + "\n";
+         }()},
+        {"arrays", "x = " + std::string(deep, '[') + std::string(deep, ']') + "\n"},
+    };
+    for (const auto& [name, source] : expressions) {
+        Parsed file = parse(source);
+        // The closers left over are reported as stray items after it.
+        check(!file.errors.empty() && file.errors[0].message.find("Expression nested more than 1000") == 0,
+              "deeply nested " + name + " are reported");
+    }
+    check(parse("x = " + std::string(500, '(') + "1" + std::string(500, ')') + "\n").errors.empty(),
+          "nesting within the limit parses");
+
+    {
+        std::string source = nestedTags(10000);
+        double best = 1e30;
+        for (int run = 0; run < 5; ++run) {
+            Lexer lexer(source);
+            TokenBuffer tokens = lexer.tokenizeBuffer();
+            auto start = std::chrono::steady_clock::now();
+            Parser parser(std::move(tokens));
+            parser.setNestingLimit(10000);
+            auto program = parser.parse();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            release(*program);
+        }
+        std::cout << "[STATS] 10000 nested tags parsed in " << best * 1e3 << " ms\n";
+    }
+
+    return checkSummary("nesting");
+}
@@ -0,0 +1,101 @@
+#include "../../core/include/lexer.h"
+#include "../../core/include/source_buffer.h"
+#include "../../core/include/work_stealing_pool.h"
+#include "check.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// tokenizeParallel() must return exactly what tokenize() returns, errors
+// included, whatever the chunk size and thread count. The inputs include
+// split-point look-alikes inside comments and strings and components that
+// leave the lexer inside ALTX, which force the fallback path.
+
+namespace {
+
+bool sameTokens(const Lexer& a, const std::vector<Token>& x, const Lexer& b, const std::vector<Token>& y) {
+    if (x.size() != y.size()) return false;
+    for (size_t i = 0; i < x.size(); ++i) {
+        if (x[i].type != y[i].type || x[i].keyword != y[i].keyword || x[i].value != y[i].value ||
+            x[i].offset != y[i].offset || x[i].symbol != y[i].symbol ||
+            x[i].errorIndex != y[i].errorIndex) {
+            return false;
+        }
+    }
+    if (a.errors().size() != b.errors().size()) return false;
+    for (size_t i = 0; i < a.errors().size(); ++i) {
+        const LexError& e = a.errors()[i];
+        const LexError& f = b.errors()[i];
+        if (e.offset != f.offset || e.message != f.message) return false;
+    }
+    return true;
+}
+
+void compare(const std::string& name, const std::string& text) {
+    auto source = SourceBuffer::fromString(text);
+    Lexer sequential(source);
+    std::vector<Token> expected = sequential.tokenize();
+
+    bool ok = true;
+    for (unsigned threads : {1u, 2u, 4u}) {
+        WorkStealingPool pool(threads);
+        for (size_t chunk : {size_t(64), size_t(500), size_t(4096)}) {
+            Lexer parallel(source);
+            std::vector<Token> actual = parallel.tokenizeParallel(pool, chunk);
+            if (!sameTokens(sequential, expected, parallel, actual)) {
+                std::cout << "[FAIL] " << name << ": " << threads << " threads, " << chunk << "-byte chunks\n";
+                ok = false;
+            }
+        }
+    }
+    check(ok, name + " (" + std::to_string(expected.size()) + " tokens)");
+}
+
+std::string catalog(int components) {
+    std::string s = "import { Button } from \"ui\"\n\n";
+    for (int i = 0; i < components; ++i) {
+        std::string n = std::to_string(i);
+        s += "component Card" + n + " {\n";
+        s += "    count = " + n + " + 1\n";
+        s += "    label = \"it's card " + n + "\"\n";
+        s += "    render:\n";
+        s += "        <div class=\"card\" data-id={count}>\n";
+        s += "            <h2>Don't {label}</h2>\n";
+        s += "        </div>\n";
+        s += "}\n";
+        if (i % 7 == 3) {
+            s += "/* a commented-out block\ncomponent Old" + n + " {\n}\n*/\n";
+        }
+        if (i % 11 == 5) {
+            // Leaves the lexer in ALTX mode across the next component line.
+            s += "component Broken" + n + " {\n    render:\n        <p>unterminated\n";
+        }
+        if (i % 13 == 8) {
+            s += "msg = \"unterminated string\ncomponent Fake" + n + " {}\n";
+        }
+        s += "\n";
+    }
+    return s;
+}
+
+}
+
+int main() {
+    compare("catalog", catalog(200));
+    compare("catalog with CRLF", [] {
+        std::string s = catalog(60), out;
+        for (char c : s) {
+            if (c == '\n') out += '\r';
+            out += c;
+        }
+        return out;
+    }());
+    compare("no split points", std::string(20000, 'x') + "\n");
+    compare("empty", "");
+
+    for (const char* path : {"examples/lexer-app-test.alt"}) {
+        auto buffer = SourceBuffer::fromFile(path);
+        if (buffer) compare(path, std::string(buffer->text()));
+    }
+    return checkSummary("parallel lexer");
+}
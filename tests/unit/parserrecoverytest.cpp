@@ -0,0 +1,135 @@
+#include "../../core/include/lexer.h"
+#include "../../core/include/parser.h"
+#include "../../core/include/source_buffer.h"
+#include "../bench/corpus.h"
+#include "check.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Parse errors are recorded without exceptions: each top-level item reports
+// its first error, keeps what was parsed before it (with ErrorExpression
+// where an expression was missing), and parsing resumes at the next item.
+// The error limit stops a file early. Parse rates for a clean and a heavily
+// broken file are reported, not checked, so the result does not depend on
+// the machine.
+
+namespace {
+
+struct Parsed {
+    std::unique_ptr<Program> program;
+    std::vector<ParseError> errors;
+    bool threw = false;
+};
+
+Parsed parse(const std::string& source, size_t errorLimit = 0) {
+    Lexer lexer(source);
+    Parser parser(lexer.tokenize());
+    parser.setErrorLimit(errorLimit);
+    Parsed result;
+    try {
+        result.program = parser.parse();
+    } catch (...) {
+        result.threw = true;
+    }
+    result.errors = parser.errors();
+    return result;
+}
+
+size_t countErrorNodes(const Node& node) {
+    size_t count = dynamic_cast<const ErrorExpression*>(&node) != nullptr;
+    forEachChild(node, [&count](const Node& child) { count += countErrorNodes(child); });
+    return count;
+}
+
+size_t occurrences(const std::string& text, const std::string& needle) {
+    size_t count = 0;
+    for (size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + needle.size())) ++count;
+    return count;
+}
+
+double tokensPerSecond(const std::vector<Token>& tokens) {
+    double best = 1e30;
+    for (int run = 0; run < 3; ++run) {
+        std::vector<Token> copy = tokens;
+        auto start = std::chrono::steady_clock::now();
+        Parser parser(std::move(copy));
+        parser.parse();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return tokens.size() / best;
+}
+
+}
+
+int main() {
+    {
+        Parsed p = parse("let = 5\nlet x = 1\n");
+        check(!p.threw && p.errors.size() == 1 && p.errors[0].message == "Expected variable name, got '='" &&
+                  p.errors[0].offset == 4,
+              "missing name is reported at the '='");
+        check(p.program && p.program->globalStatements.size() == 2, "the broken declaration and the next are kept");
+    }
+    {
+        Parsed p = parse("function f( {\n}\nfunction g() {\n    return 1\n}\n");
+        check(p.errors.size() == 1 && p.errors[0].message == "Expected parameter name, got '{'",
+              "one error for the broken parameter list");
+        check(p.program && p.program->functions.size() == 2 &&
+                  symbolText(p.program->functions[1]->name) == "g",
+              "parsing resumes at the next function");
+    }
+    {
+        Parsed p = parse("x = )\ny = 2\n");
+        check(p.errors.size() == 1 && p.errors[0].message == "Unexpected token in expression: ')'",
+              "missing operand is reported");
+        check(p.program && countErrorNodes(*p.program) == 1, "missing operand becomes an ErrorExpression");
+    }
+    {
+        Parsed p = parse("x = 1 +");
+        check(p.errors.size() == 1 && p.errors[0].message == "Unexpected end of input in expression" &&
+                  p.errors[0].offset == 7,
+              "end of input gets its own message");
+    }
+    {
+        Parsed p = parse("if (a {\n    b = 1\n}\nc = 2 +\nd = 3\n");
+        check(p.errors.size() == 2, "each broken statement reports once");
+    }
+
+    std::string broken = corpus::generate(corpus::Shape::Broken, 1 << 20, 3);
+    size_t functions = occurrences(broken, "function broken");
+    Parsed all = parse(broken);
+    check(!all.threw, "a broken file parses without throwing");
+    check(all.errors.size() > 1000, "every broken statement's function reports an error");
+    check(all.program && all.program->functions.size() == functions, "every function is kept");
+    check(all.program && countErrorNodes(*all.program) > 0, "error nodes are in the tree");
+    bool ordered = true;
+    for (size_t i = 1; i < all.errors.size(); ++i) {
+        const ParseError& a = all.errors[i - 1];
+        const ParseError& b = all.errors[i];
+        ordered &= a.offset <= b.offset;
+    }
+    check(ordered, "errors are in source order");
+
+    Parsed capped = parse(broken, 10);
+    check(capped.errors.size() == 11 && capped.errors.back().message == "Too many errors, parsing stopped",
+          "error limit stops after ten errors and says so");
+    check(capped.program && capped.program->functions.size() < functions, "nothing is parsed past the limit");
+    for (size_t i = 0; i < 10 && i < capped.errors.size(); ++i) {
+        if (capped.errors[i].message != all.errors[i].message || capped.errors[i].offset != all.errors[i].offset) {
+            check(false, "capped errors are the first ten");
+            break;
+        }
+    }
+
+    Lexer brokenLexer(broken);
+    std::vector<Token> brokenTokens = brokenLexer.tokenize();
+    Lexer cleanLexer(corpus::generate(corpus::Shape::Expressions, 1 << 20, 3));
+    std::vector<Token> cleanTokens = cleanLexer.tokenize();
+    double brokenRate = tokensPerSecond(brokenTokens);
+    double cleanRate = tokensPerSecond(cleanTokens);
+    std::cout << "[STATS] parse: " << cleanRate / 1e6 << " Mtok/s clean, " << brokenRate / 1e6 << " Mtok/s with "
+              << all.errors.size() << " errors\n";
+
+    return checkSummary("parser recovery");
+}
@@ -0,0 +1,147 @@
+#include "../../core/include/alterion_compiler.h"
+#include "../../core/include/json_writer.h"
+#include "../../core/include/phase_timer.h"
+#include "../bench/corpus.h"
+#include "check.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Compiles generated files with a PhaseTrace installed and checks what it
+// recorded: every phase appears, events are attributed to the file being
+// compiled and nest inside its "file" event, a scope inside another of the
+// same name is marked nested, and the Chrome trace and summary carry all of
+// it. With no trace installed nothing is recorded.
+
+namespace {
+
+size_t countOf(const std::vector<PhaseTrace::Event>& events, const char* name) {
+    return std::count_if(events.begin(), events.end(),
+                         [&](const PhaseTrace::Event& e) { return std::strcmp(e.name, name) == 0; });
+}
+
+size_t occurrences(const std::string& text, const std::string& needle) {
+    size_t count = 0;
+    for (size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + needle.size())) ++count;
+    return count;
+}
+
+}
+
+int main() {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "alterion-phasetimertest";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    std::vector<std::string> files;
+    const corpus::Shape shapes[] = {corpus::Shape::ALTX, corpus::Shape::Mixed, corpus::Shape::Expressions};
+    for (size_t i = 0; i < 3; ++i) {
+        std::filesystem::path path = directory / ("file" + std::to_string(i) + ".alt");
+        std::ofstream(path, std::ios::binary) << corpus::generate(shapes[i], (i + 1) * 64 * 1024, 7);
+        files.push_back(path.string());
+    }
+
+    {
+        PhaseTrace idle;
+        compileFiles(files, CompileOptions{2});
+        check(idle.events().empty() && PhaseTrace::active() == nullptr, "nothing is recorded without install()");
+    }
+
+    PhaseTrace trace;
+    PhaseTrace::install(&trace);
+    std::vector<FileResult> results = compileFiles(files, CompileOptions{2});
+    PhaseTrace::install(nullptr);
+    std::vector<PhaseTrace::Event> events = trace.events();
+    std::vector<std::string> traced = trace.files();
+
+    check(countOf(events, "file") == files.size() && traced.size() == files.size(), "one file event per file");
+    check(countOf(events, "lex") == files.size() && countOf(events, "parse") == files.size(),
+          "one lex and one parse event per file");
+    check(countOf(events, "parseComponent") > 0 && countOf(events, "parseTag") > 0,
+          "components and tags are timed");
+
+    bool attributed = true;
+    bool contained = true;
+    bool namedComponents = true;
+    for (const PhaseTrace::Event& event : events) {
+        if (event.file == PhaseTrace::NoFile) {
+            attributed = false;
+            continue;
+        }
+        if (std::strcmp(event.name, "parseComponent") == 0 && event.detail.empty()) namedComponents = false;
+        auto file = std::find_if(events.begin(), events.end(), [&](const PhaseTrace::Event& e) {
+            return std::strcmp(e.name, "file") == 0 && e.file == event.file;
+        });
+        if (file == events.end() || file->thread != event.thread || event.start < file->start ||
+            event.start + event.duration > file->start + file->duration) {
+            contained = false;
+        }
+    }
+    check(attributed, "every event is attributed to a file");
+    check(contained, "events lie inside their file's event, on the same thread");
+    check(namedComponents, "component events carry the component name");
+
+    // Tag trees are parsed with an explicit stack: one scope per tree.
+    size_t outerTags = 0, nestedTags = 0;
+    for (const PhaseTrace::Event& event : events) {
+        if (std::strcmp(event.name, "parseTag") == 0) (event.nested ? nestedTags : outerTags)++;
+    }
+    check(outerTags > 0 && nestedTags == 0, "one parseTag scope per tag tree");
+
+    {
+        PhaseTrace recursion;
+        PhaseTrace::install(&recursion);
+        {
+            PhaseTimer outer("scope");
+            PhaseTimer inner("scope");
+        }
+        PhaseTrace::install(nullptr);
+        std::vector<PhaseTrace::Event> scopes = recursion.events();
+        check(scopes.size() == 2 && scopes[0].nested && !scopes[1].nested,
+              "a scope inside one of the same name is marked nested");
+    }
+
+    std::string json;
+    {
+        JsonWriter writer(json, JsonWriter::Style::Compact);
+        trace.writeChromeTrace(writer);
+    }
+    check(json.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0) == 0, "Chrome trace has traceEvents");
+    check(occurrences(json, "\"ph\":\"X\"") == events.size(), "one complete event per scope");
+    check(occurrences(json, "\"name\":\"thread_name\"") >= 1, "worker threads are named");
+    check(json.find("\"detail\":\"Panel") != std::string::npos, "component names reach the trace args");
+
+    std::ostringstream summary;
+    trace.printSummary(summary, 5);
+    std::string table = summary.str();
+    bool allFiles = true;
+    for (const std::string& path : files) allFiles &= table.find(path) != std::string::npos;
+    check(table.find("parseComponent") != std::string::npos && table.find("slowest components") != std::string::npos,
+          "summary lists phases and components");
+    check(allFiles, "summary lists every file");
+    std::cout << table;
+
+    // The disabled path is a load and a branch per scope; compare a parse
+    // with the trace off to one with it on to show what recording costs.
+    std::vector<std::string> big{files[0]};
+    auto time = [&] {
+        auto start = std::chrono::steady_clock::now();
+        compileFiles(big, CompileOptions{1});
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+    double off = time();
+    PhaseTrace overhead;
+    PhaseTrace::install(&overhead);
+    double on = time();
+    PhaseTrace::install(nullptr);
+    std::cout << "[STATS] " << files[0] << ": " << off << " ms untraced, " << on << " ms traced ("
+              << overhead.events().size() << " events)\n";
+
+    std::filesystem::remove_all(directory);
+    return checkSummary("phase timer");
+}
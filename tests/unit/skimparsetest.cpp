@@ -0,0 +1,206 @@
+#include "../../core/include/ast_serialization.h"
+#include "../../core/include/lexer.h"
+#include "../../core/include/parser.h"
+#include "../../core/include/source_buffer.h"
+#include "../bench/corpus.h"
+#include "check.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Skim mode keeps every function and method body as a DeferredBlock. Once
+// each is parsed, the tree encodes to the same bytes as a full parse of the
+// same tokens. Errors inside a body are reported by its block, under the
+// skimming parser's error and nesting limits, and a body left open is
+// reported once, by the parse itself.
+
+namespace {
+
+void visitFunctions(Node& node, const std::function<void(Function&)>& visit) {
+    if (auto* function = dynamic_cast<Function*>(&node)) visit(*function);
+    forEachChild(node, [&visit](Node& child) { visitFunctions(child, visit); });
+}
+
+std::vector<DeferredBlock*> deferredBodies(Program& program) {
+    std::vector<DeferredBlock*> bodies;
+    visitFunctions(program, [&bodies](Function& function) {
+        if (auto* deferred = dynamic_cast<DeferredBlock*>(function.body.get())) bodies.push_back(deferred);
+    });
+    return bodies;
+}
+
+// Parses every skimmed body and puts it where a full parse would have.
+void expand(Program& program) {
+    visitFunctions(program, [](Function& function) {
+        uint32_t at = function.body->offset;
+        auto block = std::make_unique<BlockStatement>(std::move(functionBody(function).statements), at);
+        function.body = std::move(block);
+    });
+}
+
+std::string encode(const Program& program) {
+    std::string bytes;
+    writeProgram(program, bytes);
+    return bytes;
+}
+
+struct Skimmed {
+    std::string source;
+    std::unique_ptr<Lexer> lexer;   // the bodies' tokens point into it
+    std::unique_ptr<Program> program;
+    std::vector<ParseError> errors;
+};
+
+Skimmed skim(const std::string& source) {
+    Skimmed result;
+    result.source = source;
+    result.lexer = std::make_unique<Lexer>(source);
+    Parser parser(result.lexer->tokenizeBuffer());
+    parser.setSkimBodies(true);
+    result.program = parser.parse();
+    result.errors = parser.errors();
+    return result;
+}
+
+bool sameAsFullParse(const std::string& source) {
+    auto buffer = SourceBuffer::fromString(source);
+    Lexer fullLexer(buffer);
+    Parser full(fullLexer.tokenizeBuffer());
+    std::string expected = encode(*full.parse());
+    std::vector<ParseError> expectedErrors = full.errors();
+
+    // Pulling from the lexer, so skimmed tokens are copied out of the
+    // lookahead window as they go by.
+    Lexer lexer(buffer);
+    Parser parser(lexer);
+    parser.setSkimBodies(true);
+    auto program = parser.parse();
+    std::vector<DeferredBlock*> bodies = deferredBodies(*program);
+    bool deferred = !bodies.empty();
+    for (DeferredBlock* body : bodies) deferred &= !body->isParsed();
+    // The corpus bodies are clean, so the errors (from ALTX) are the same.
+    bool sameErrors = parser.errors().size() == expectedErrors.size();
+    for (size_t i = 0; sameErrors && i < expectedErrors.size(); ++i) {
+        sameErrors = parser.errors()[i].offset == expectedErrors[i].offset &&
+                     parser.errors()[i].message == expectedErrors[i].message;
+    }
+    for (DeferredBlock* body : bodies) sameErrors &= (body->block(), body->errors().empty());
+    expand(*program);
+    return deferred && sameErrors && encode(*program) == expected;
+}
+
+double bestSeconds(const TokenBuffer& tokens, bool skimBodies) {
+    double best = 1e30;
+    for (int run = 0; run < 3; ++run) {
+        TokenBuffer copy = tokens;
+        auto start = std::chrono::steady_clock::now();
+        Parser parser(std::move(copy));
+        parser.setSkimBodies(skimBodies);
+        auto program = parser.parse();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+}
+
+int main() {
+    // Shapes whose function bodies parse cleanly. After an error inside a
+    // body a full parse resynchronizes at the top level, part way through
+    // the body, where block() stops at the error; the trees then differ.
+    for (corpus::Shape shape : {corpus::Shape::ALTX, corpus::Shape::Expressions, corpus::Shape::Mixed}) {
+        check(sameAsFullParse(corpus::generate(shape, 256 * 1024, 5)),
+              std::string(corpus::name(shape)) + ": skimmed bodies parse to the full tree");
+    }
+
+    {
+        Skimmed file = skim("function f(a, b) {\n"
+                            "    let o = {x: {y: 1}}\n"
+                            "    if (a) { return o } else { while (b) { b = b - 1 } }\n"
+                            "}\n"
+                            "component Counter {\n"
+                            "    count = 0\n"
+                            "    increment {\n"
+                            "        count = count + 1\n"
+                            "    }\n"
+                            "}\n"
+                            "export function g() { return 2 }\n");
+        std::vector<DeferredBlock*> bodies = deferredBodies(*file.program);
+        check(file.errors.empty() && bodies.size() == 3, "functions, methods and exported functions are skimmed");
+        // forEachChild order: components, then functions, then the rest.
+        bool nested = bodies.size() == 3 && bodies[1]->block().statements.size() == 2;
+        check(nested && file.program->components.size() == 1 && file.program->components[0]->statements.size() == 2,
+              "nested braces stay inside the body; parsing resumes after it");
+        BlockStatement* first = bodies.empty() ? nullptr : &bodies[0]->block();
+        check(first != nullptr && &bodies[0]->block() == first && bodies[0]->tokens.empty(),
+              "a body is parsed once and its tokens are released");
+        check(bodies.size() == 3 && bodies[0]->block().offset == bodies[0]->offset &&
+                  bodies[0]->offset == file.source.find("increment"),
+              "a method body keeps the method's offset");
+    }
+
+    {
+        Skimmed file = skim("function f() {\n    x = (1 +\n}\ncomponent After {\n}\n");
+        std::vector<DeferredBlock*> bodies = deferredBodies(*file.program);
+        check(file.errors.empty() && file.program->components.size() == 1,
+              "an error inside a body does not reach the outline");
+        bool reported = bodies.size() == 1 && (bodies[0]->block(), bodies[0]->errors().size() == 1);
+        check(reported && bodies[0]->errors()[0].offset == file.source.find("}\ncomponent"),
+              "block() reports it where a full parse would");
+    }
+
+    {
+        Skimmed file = skim("component A {\n    open {\n        x = 1\n");
+        check(file.errors.size() == 1 && file.errors[0].message.find("after method body") != std::string::npos,
+              "a body left open is reported by the parse");
+    }
+
+    for (const char* source : {"function f() {\n    x = 1\n", "function f() {\n    x = (1 +\n"}) {
+        Lexer lexer(source);
+        Parser full(lexer.tokenize());
+        full.parse();
+        Skimmed file = skim(source);
+        std::vector<DeferredBlock*> bodies = deferredBodies(*file.program);
+        std::vector<ParseError> all = file.errors;
+        for (DeferredBlock* body : bodies) {
+            body->block();
+            all.insert(all.end(), body->errors().begin(), body->errors().end());
+        }
+        check(all.size() == 1 && full.errors().size() == 1 && all[0].message == full.errors()[0].message &&
+                  all[0].offset == full.errors()[0].offset,
+              "a body left open gives one diagnostic, the full parse's");
+    }
+
+    {
+        std::string source = "function f() {\n    x = " + std::string(20, '(') + "1" + std::string(20, ')') +
+                             "\n}\nfunction g() {\n    a = )\n}\n";
+        Lexer lexer(source);
+        Parser parser(lexer.tokenizeBuffer());
+        parser.setSkimBodies(true);
+        parser.setNestingLimit(10);
+        parser.setErrorLimit(1);
+        auto program = parser.parse();
+        std::vector<DeferredBlock*> bodies = deferredBodies(*program);
+        bool limited = bodies.size() == 2 && (bodies[0]->block(), bodies[1]->block(), true) &&
+                       !bodies[0]->errors().empty() &&
+                       bodies[0]->errors()[0].message.find("nested more than 10") != std::string::npos &&
+                       bodies[1]->errors().size() == 2 &&
+                       bodies[1]->errors().back().message == "Too many errors, parsing stopped";
+        check(limited, "bodies are parsed under the skimming parser's limits");
+    }
+
+    for (corpus::Shape shape : {corpus::Shape::Expressions, corpus::Shape::Mixed}) {
+        Lexer lexer(corpus::generate(shape, 4 << 20, 5));
+        TokenBuffer tokens = lexer.tokenizeBuffer();
+        double full = bestSeconds(tokens, false);
+        double skimmed = bestSeconds(tokens, true);
+        std::cout << "[STATS] " << corpus::name(shape) << ": full parse " << tokens.size() / full / 1e6
+                  << " Mtok/s, skim " << tokens.size() / skimmed / 1e6 << " Mtok/s (" << 100.0 * skimmed / full
+                  << "% of the time)\n";
+    }
+
+    return checkSummary("skim parse");
+}
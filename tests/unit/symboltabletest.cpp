@@ -0,0 +1,52 @@
+#include "../../core/include/symbol_table.h"
+#include "check.h"
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Interns overlapping sets of names from several threads at once and checks
+// that every thread got the same symbol for the same name and that each
+// symbol reads back as its name.
+
+namespace {
+
+constexpr int ThreadCount = 4;
+constexpr int NameCount = 20000;
+
+std::string nameFor(int i) {
+    return (i % 3 == 0 ? "div-" : i % 3 == 1 ? "item" : "onClick_") + std::to_string(i);
+}
+
+}
+
+int main() {
+    check(intern("").empty() && symbolText(Symbol{}).empty(), "empty string is the empty symbol");
+    check(intern("button") == intern(std::string("but") + "ton"), "equal text interns to one symbol");
+    check(intern("button") != intern("Button"), "distinct text interns to distinct symbols");
+
+    std::vector<std::vector<Symbol>> results(ThreadCount, std::vector<Symbol>(NameCount));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < ThreadCount; ++t) {
+        threads.emplace_back([t, &results] {
+            // Each thread walks the names from a different starting point so
+            // first insertions race against lookups.
+            for (int k = 0; k < NameCount; ++k) {
+                int i = (k + t * NameCount / ThreadCount) % NameCount;
+                results[t][i] = intern(nameFor(i));
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    bool agree = true, roundTrip = true;
+    for (int i = 0; i < NameCount; ++i) {
+        for (int t = 1; t < ThreadCount; ++t) agree &= results[t][i] == results[0][i];
+        roundTrip &= symbolText(results[0][i]) == nameFor(i);
+    }
+    check(agree, "threads agree on every symbol");
+    check(roundTrip, "symbols read back as their text");
+    check(SymbolTable::global().size() >= NameCount, "table holds every name");
+
+    return checkSummary("symbol table");
+}
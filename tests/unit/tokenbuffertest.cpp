@@ -0,0 +1,100 @@
+#include "../../core/include/lexer.h"
+#include "../../core/include/parser.h"
+#include "../../core/include/source_buffer.h"
+#include "../../core/include/token_buffer.h"
+#include "../bench/corpus.h"
+#include "check.h"
+#include <iostream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+// Lexer::tokenizeBuffer() against tokenize() on every corpus shape: the same
+// tokens, offsets that point at each token's text, EOF padding after the
+// type column, and the same tree and errors from Parser(TokenBuffer) as from
+// Parser(std::vector<Token>).
+
+namespace {
+
+bool sameToken(const Token& a, const Token& b) {
+    return a.type == b.type && a.keyword == b.keyword && a.value == b.value && a.value.data() == b.value.data() &&
+           a.offset == b.offset && a.errorIndex == b.errorIndex && a.symbol == b.symbol;
+}
+
+// Node kinds and positions in preorder.
+void outline(const Node& node, std::string& out) {
+    out += typeid(node).name();
+    out += '@' + std::to_string(node.offset) + '(';
+    forEachChild(node, [&out](const Node& child) { outline(child, out); });
+    out += ')';
+}
+
+void checkShape(corpus::Shape shape) {
+    std::string name = corpus::name(shape);
+    auto source = SourceBuffer::fromString(corpus::generate(shape, 256 * 1024, 5));
+    std::string_view text = source->text();
+
+    Lexer vectorLexer(source);
+    std::vector<Token> tokens = vectorLexer.tokenize();
+    Lexer bufferLexer(source);
+    TokenBuffer buffer = bufferLexer.tokenizeBuffer();
+
+    bool same = buffer.size() == tokens.size();
+    for (size_t i = 0; same && i < tokens.size(); ++i) same = sameToken(buffer.token(i), tokens[i]);
+    check(same, name + ": same tokens as tokenize()");
+
+    bool padded = true;
+    for (size_t i = 0; i < TokenBuffer::Padding; ++i) {
+        padded &= buffer.type(buffer.size() + i) == TokenType::EOFToken;
+    }
+    check(padded, name + ": type column ends in EOF padding");
+
+    // A token whose text is a slice of the source starts where the slice
+    // does, or one byte before (the quote of a string, the '<' of a tag);
+    // the rest (punctuation literals, unescaped strings) at least keep order.
+    bool located = true;
+    bool ordered = true;
+    for (size_t i = 0; i < buffer.size(); ++i) {
+        std::string_view value = buffer.payload(i).value;
+        if (value.data() >= text.data() && value.data() < text.data() + text.size()) {
+            size_t start = static_cast<size_t>(value.data() - text.data());
+            located &= buffer.offset(i) == start || buffer.offset(i) + 1 == start;
+        }
+        if (i > 0) ordered &= buffer.offset(i - 1) <= buffer.offset(i);
+    }
+    check(located, name + ": offsets point at the token text");
+    check(ordered && buffer.offset(buffer.size() - 1) == text.size(), name + ": offsets ascend to the end");
+
+    Parser fromVector(tokens);
+    Parser fromBuffer(std::move(buffer));
+    std::unique_ptr<Program> expected = fromVector.parse();
+    std::unique_ptr<Program> actual = fromBuffer.parse();
+    std::string expectedShape, actualShape;
+    outline(*expected, expectedShape);
+    outline(*actual, actualShape);
+    check(expectedShape == actualShape, name + ": same tree from the columns");
+    bool sameErrors = fromVector.errors().size() == fromBuffer.errors().size();
+    for (size_t i = 0; sameErrors && i < fromVector.errors().size(); ++i) {
+        const ParseError& a = fromVector.errors()[i];
+        const ParseError& b = fromBuffer.errors()[i];
+        sameErrors = a.message == b.message && a.offset == b.offset;
+    }
+    check(sameErrors, name + ": same parse errors from the columns");
+}
+
+}
+
+int main() {
+    for (corpus::Shape shape : corpus::allShapes()) checkShape(shape);
+
+    Lexer lexer(std::string("let x = 1"));
+    TokenBuffer buffer = lexer.tokenizeBuffer();
+    check(buffer.size() == 5 && buffer.offset(0) == 0 && buffer.offset(1) == 4 && buffer.offset(2) == 6 &&
+              buffer.offset(3) == 8 && buffer.offset(4) == 9,
+          "offsets of a short line");
+    check(buffer.type(0) == TokenType::Keyword && buffer.payload(0).keyword == Keyword::Let &&
+              buffer.type(1) == TokenType::Identifier && symbolText(buffer.payload(1).symbol) == "x",
+          "keyword and symbol are in the payload");
+
+    return checkSummary("token buffer");
+}
@@ -0,0 +1,74 @@
+#include "../../core/include/lexer.h"
+#include "../../core/include/source_buffer.h"
+#include "../../core/include/token.h"
+#include "check.h"
+#include <iostream>
+#include <set>
+#include <string>
+
+// `alterion tokens` names each token with Token::tokenTypeToString. Every
+// TokenType has its own name, and lexing sources that reach every kind of
+// token the lexer produces prints no UNKNOWN.
+
+namespace {
+
+// Operators, compound assignments, comments, ALTX tags, attributes,
+// bindings and modifiers.
+const char* everyToken =
+    "// line comment\n"
+    "/* block comment */\n"
+    "import { Card } from \"ui\"\n"
+    "component Every {\n"
+    "    count = 0\n"
+    "    flag = true\n"
+    "    none = null\n"
+    "    @async\n"
+    "    load() {\n"
+    "        count += 1; count -= 1; count *= 2; count /= 2; count %= 3; count **= 2\n"
+    "        count++\n"
+    "        count--\n"
+    "        let x = (count + 1 - 2 * 3 / 4 % 5 ** 2) == 1 != 2 <= 3 >= 4 && !flag || none\n"
+    "        let f = (a) => a.b[0]\n"
+    "        return { key: x, list: [1, 2.5e3] }\n"
+    "    }\n"
+    "    render:\n"
+    "        <div class=\"box\" style=\"color:red\" value:bind={count} @click={load}>\n"
+    "            Some text {count > 1 ? \"many\" : \"one\"}\n"
+    "            <br/>\n"
+    "        </div>\n"
+    "}\n";
+
+// Returns how many tokens were named UNKNOWN and adds each type seen.
+size_t unnamed(const std::shared_ptr<const SourceBuffer>& source, std::set<TokenType>& seen) {
+    size_t count = 0;
+    Lexer lexer(source);
+    for (const Token& token : lexer) {
+        seen.insert(token.type);
+        count += Token::tokenTypeToString(token.type) == "UNKNOWN";
+    }
+    return count;
+}
+
+}
+
+int main() {
+    std::set<std::string> names;
+    bool named = true;
+    for (int i = 0; i <= static_cast<int>(TokenType::Slash); ++i) {
+        auto type = static_cast<TokenType>(i);
+        std::string name = Token::tokenTypeToString(type);
+        named &= (name == "UNKNOWN") == (type == TokenType::Unknown);
+        names.insert(name);
+    }
+    check(named, "every token type but Unknown has a name");
+    check(names.size() == static_cast<size_t>(TokenType::Slash) + 1, "no two token types share a name");
+
+    std::set<TokenType> seen;
+    size_t sample = unnamed(SourceBuffer::fromString(everyToken), seen);
+    check(sample == 0 && seen.size() > 40, "no token in the sample is dumped as UNKNOWN");
+    // demo_app.alt is left out: its template strings lex as Unknown tokens.
+    auto example = SourceBuffer::fromFile("examples/lexer-app-test.alt");
+    check(example && unnamed(example, seen) == 0, "no token in examples/lexer-app-test.alt is dumped as UNKNOWN");
+
+    return checkSummary("token dump");
+}
@@ -0,0 +1,86 @@
+// document_store.cpp
+// Alterion Language - Phase 6: Language Server Protocol (LSP) Integration
+#include "document_store.h"
+#include "../../core/include/utf8_utils.h"
+#include <algorithm>
+
+void DocumentStore::open(const std::string& uri, std::string text, int version) {
+    auto document = std::make_unique<LSPDocument>();
+    document->version = version;
+    document->lexer.reset(std::move(text));
+    document->parser.parse(document->lexer);
+    documents[uri] = std::move(document);
+}
+
+bool DocumentStore::change(const std::string& uri, int version, const std::vector<LSPTextChange>& changes) {
+    auto found = documents.find(uri);
+    if (found == documents.end()) return false;
+    LSPDocument& document = *found->second;
+    for (const LSPTextChange& change : changes) {
+        if (!change.range) {
+            document.parser.noteEdit(document.lexer.assign(change.text));
+            continue;
+        }
+        size_t start = offsetOf(document.lexer, change.range->start);
+        size_t end = std::max(start, offsetOf(document.lexer, change.range->end));
+        document.parser.noteEdit(document.lexer.edit(start, end - start, change.text));
+    }
+    document.parser.parse(document.lexer);
+    document.version = version;
+    return true;
+}
+
+void DocumentStore::close(const std::string& uri) {
+    documents.erase(uri);
+}
+
+const LSPDocument* DocumentStore::find(const std::string& uri) const {
+    auto found = documents.find(uri);
+    return found == documents.end() ? nullptr : found->second.get();
+}
+
+std::vector<LSPDiagnostic> DocumentStore::diagnostics(const std::string& uri) const {
+    std::vector<LSPDiagnostic> result;
+    const LSPDocument* document = find(uri);
+    if (document == nullptr) return result;
+    for (const LexError& error : document->lexer.errors()) {
+        LSPPosition at = positionOf(document->lexer, error.offset);
+        result.push_back({{at, at}, error.message});
+    }
+    for (const ParseError& error : document->parser.errors()) {
+        LSPPosition at = positionOf(document->lexer, error.offset);
+        result.push_back({{at, at}, error.message});
+    }
+    // Lexer and parser errors interleave by position; ties keep lexer first.
+    std::stable_sort(result.begin(), result.end(), [](const LSPDiagnostic& a, const LSPDiagnostic& b) {
+        const LSPPosition& x = a.range.start;
+        const LSPPosition& y = b.range.start;
+        return x.line != y.line ? x.line < y.line : x.character < y.character;
+    });
+    return result;
+}
+
+size_t DocumentStore::offsetOf(const IncrementalLexer& lexer, LSPPosition position) {
+    std::string_view text = lexer.text();
+    size_t offset = lexer.lineOffset(position.line + 1);
+    // Characters past the end of the line clamp to it, as the protocol asks.
+    for (size_t units = 0; units < position.character && offset < text.size() && text[offset] != '\n';) {
+        size_t length = utf8SequenceLength(text, offset);
+        units += length == 4 ? 2 : 1;
+        offset = std::min(text.size(), offset + length);
+    }
+    return offset;
+}
+
+LSPPosition DocumentStore::positionOf(const IncrementalLexer& lexer, size_t offset) {
+    std::string_view text = lexer.text();
+    offset = std::min(offset, text.size());
+    SourceLocation at = lexer.locate(offset);
+    size_t units = 0;
+    for (size_t position = lexer.lineOffset(at.line); position < offset;) {
+        size_t length = utf8SequenceLength(text, position);
+        units += length == 4 ? 2 : 1;
+        position += length;
+    }
+    return {at.line - 1, units};
+}
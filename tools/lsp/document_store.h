@@ -0,0 +1,64 @@
+// document_store.h
+// Alterion Language - Phase 6: Language Server Protocol (LSP) Integration
+// Open documents and their incrementally maintained token streams
+
+#pragma once
+#include "../../core/include/incremental_lexer.h"
+#include "../../core/include/incremental_parser.h"
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Zero-based line and UTF-16 code unit offset, as LSP counts them.
+struct LSPPosition {
+    size_t line;
+    size_t character;
+};
+
+struct LSPRange {
+    LSPPosition start;
+    LSPPosition end;
+};
+
+// One entry of textDocument/didChange: replaces `range`, or the whole
+// document when there is none.
+struct LSPTextChange {
+    std::optional<LSPRange> range;
+    std::string text;
+};
+
+struct LSPDiagnostic {
+    LSPRange range;
+    std::string message;
+};
+
+struct LSPDocument {
+    int version = 0;
+    IncrementalLexer lexer;
+    IncrementalParser parser;
+};
+
+// Documents the client has open. Changes are applied as edits to each
+// document's IncrementalLexer, so a keystroke re-lexes only the tokens around
+// it however long the file is, and the document is re-parsed reusing every
+// component and function the edits did not touch. Full-text changes are
+// diffed against the current text and applied the same way.
+class DocumentStore {
+public:
+    void open(const std::string& uri, std::string text, int version);
+    // Returns false if the document is not open.
+    bool change(const std::string& uri, int version, const std::vector<LSPTextChange>& changes);
+    void close(const std::string& uri);
+
+    const LSPDocument* find(const std::string& uri) const;
+    std::vector<LSPDiagnostic> diagnostics(const std::string& uri) const;
+
+    // Conversions between LSP positions and byte offsets.
+    static size_t offsetOf(const IncrementalLexer& lexer, LSPPosition position);
+    static LSPPosition positionOf(const IncrementalLexer& lexer, size_t offset);
+
+private:
+    std::map<std::string, std::unique_ptr<LSPDocument>> documents;
+};
@@ -11,10 +11,30 @@ void LSPServer::start(int port) {
 
 void LSPServer::handleRequest(const std::string& request) {
     // Example: handle request and generate diagnostics
-    diagnostics.push_back("Handled request: " + request);
+    diagnosticsLog.push_back("Handled request: " + request);
     lastResponse = "Response to: " + request;
 }
 
 std::string LSPServer::getResponse() const {
     return lastResponse;
 }
+
+void LSPServer::didOpen(const std::string& uri, std::string text, int version) {
+    documents.open(uri, std::move(text), version);
+}
+
+void LSPServer::didChange(const std::string& uri, int version, const std::vector<LSPTextChange>& changes) {
+    documents.change(uri, version, changes);
+}
+
+void LSPServer::didClose(const std::string& uri) {
+    documents.close(uri);
+}
+
+const LSPDocument* LSPServer::document(const std::string& uri) const {
+    return documents.find(uri);
+}
+
+std::vector<LSPDiagnostic> LSPServer::diagnostics(const std::string& uri) const {
+    return documents.diagnostics(uri);
+}
@@ -3,6 +3,7 @@
 // Reference implementation for LSP server
 
 #pragma once
+#include "document_store.h"
 #include <string>
 #include <vector>
 #include <memory>
@@ -14,9 +15,20 @@ public:
     void start(int port);
     void handleRequest(const std::string& request);
     std::string getResponse() const;
+
+    // textDocument/didOpen, didChange and didClose. Open documents keep
+    // their token stream between edits; see DocumentStore.
+    void didOpen(const std::string& uri, std::string text, int version);
+    void didChange(const std::string& uri, int version, const std::vector<LSPTextChange>& changes);
+    void didClose(const std::string& uri);
+
+    const LSPDocument* document(const std::string& uri) const;
+    // What textDocument/publishDiagnostics would send for `uri`.
+    std::vector<LSPDiagnostic> diagnostics(const std::string& uri) const;
 private:
-    std::vector<std::string> diagnostics;
+    std::vector<std::string> diagnosticsLog;
     std::string lastResponse;
+    DocumentStore documents;
     // Add more: autocomplete, go-to-definition, etc.
 };
 